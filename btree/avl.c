@@ -0,0 +1,163 @@
+/*
+ * AVL strom nad uzly bst_node_t
+ *
+ * Výšky podstromů každého uzlu se liší nejvýš o jedna. Výšku podstromu si
+ * uzel pamatuje v položce height, kterou nastavují a udržují jen funkce
+ * bst_avl_insert a bst_avl_delete. Strom proto musí vzniknout a měnit se
+ * jen těmito funkcemi, funkce bst_insert a bst_delete výšky neudržují.
+ *
+ * Obě funkce jsou rekurzivní a uzly na cestě k vloženému nebo odstraněnému
+ * uzlu vyváží jednoduchou nebo dvojitou rotací při návratu z rekurze. Výška
+ * stromu tak zůstává nejvýš asi 1,44 log2 n i pro klíče vkládané seřazeně,
+ * pro nejvýš 256 různých klíčů typu char tedy 11 a vejde se do signed char.
+ * Funkce jsou společné pro rekurzivní i iterativní variantu stromu.
+ */
+
+#include "btree.h"
+#include <stdlib.h>
+
+/*
+ * Výška stromu, prázdný strom má výšku 0 a list 1.
+ */
+static int bst_avl_height(bst_node_t *tree) {
+  return tree != NULL ? tree->height : 0;
+}
+
+/*
+ * Přepočet výšky uzlu z výšek jeho potomků.
+ */
+static void bst_avl_update_height(bst_node_t *tree) {
+  int left = bst_avl_height(tree->left), right = bst_avl_height(tree->right);
+  tree->height = (left > right ? left : right) + 1;
+}
+
+static void bst_avl_rotate_left(bst_node_t **tree) {
+  bst_node_t *root = (*tree)->right;
+  (*tree)->right = root->left;
+  root->left = *tree;
+  bst_avl_update_height(root->left);
+  bst_avl_update_height(root);
+  *tree = root;
+}
+
+static void bst_avl_rotate_right(bst_node_t **tree) {
+  bst_node_t *root = (*tree)->left;
+  (*tree)->left = root->right;
+  root->right = *tree;
+  bst_avl_update_height(root->right);
+  bst_avl_update_height(root);
+  *tree = root;
+}
+
+/*
+ * Vyvážení uzlu po vložení nebo odstranění v jeho podstromu.
+ *
+ * Podstromy uzlu musí být vyvážené a jejich výšky se smí lišit nejvýš o dva.
+ * Uzel se nahradí kořenem vyváženého podstromu a jeho výška se přepočítá.
+ */
+static void bst_avl_rebalance(bst_node_t **tree) {
+  bst_node_t *node = *tree;
+  int balance = bst_avl_height(node->left) - bst_avl_height(node->right);
+
+  if (balance > 1) {
+    //left-right case turns into left-left first
+    if (bst_avl_height(node->left->left) <
+        bst_avl_height(node->left->right)) {
+      bst_avl_rotate_left(&node->left);
+    }
+    bst_avl_rotate_right(tree);
+  } else if (balance < -1) {
+    if (bst_avl_height(node->right->right) <
+        bst_avl_height(node->right->left)) {
+      bst_avl_rotate_right(&node->right);
+    }
+    bst_avl_rotate_left(tree);
+  } else {
+    bst_avl_update_height(node);
+  }
+}
+
+/*
+ * Vložení uzlu do AVL stromu.
+ *
+ * Pokud uzel se zadaným klíčem už ve stromu existuje, nahradí se jeho
+ * hodnota. Jinak se vloží nový list a strom se cestou nahoru vyváží.
+ */
+void bst_avl_insert(bst_node_t **tree, char key, int value) {
+  if (*tree == NULL) {
+    bst_node_t *node = malloc(sizeof(bst_node_t));
+    if (node == NULL) {
+      return;
+    }
+    node->key = key;
+    node->value = value;
+    node->height = 1;
+    node->left = NULL;
+    node->right = NULL;
+    *tree = node;
+    return;
+  }
+
+  if (key == (*tree)->key) {
+    (*tree)->value = value;
+    return;
+  }
+
+  if (key < (*tree)->key) {
+    bst_avl_insert(&(*tree)->left, key, value);
+  } else {
+    bst_avl_insert(&(*tree)->right, key, value);
+  }
+
+  //rebalance on the way up
+  bst_avl_rebalance(tree);
+}
+
+/*
+ * Nahrazení uzlu target nejpravějším uzlem podstromu tree, uzly na cestě
+ * k němu se vyváží.
+ */
+static void bst_avl_replace_by_rightmost(bst_node_t *target,
+                                         bst_node_t **tree) {
+  if ((*tree)->right != NULL) {
+    bst_avl_replace_by_rightmost(target, &(*tree)->right);
+    bst_avl_rebalance(tree);
+    return;
+  }
+
+  target->key = (*tree)->key;
+  target->value = (*tree)->value;
+  bst_node_t *tmp = *tree;
+  *tree = (*tree)->left;
+  free(tmp);
+}
+
+/*
+ * Odstranění uzlu z AVL stromu.
+ *
+ * Uzel se dvěma podstromy se nahradí nejpravějším uzlem levého podstromu,
+ * uzly na cestě k fyzicky odstraněnému uzlu se při návratu z rekurze
+ * vyváží. Pokud uzel se zadaným klíčem neexistuje, strom se nezmění.
+ */
+void bst_avl_delete(bst_node_t **tree, char key) {
+  if (*tree == NULL) {
+    return;
+  }
+
+  if (key < (*tree)->key) {
+    bst_avl_delete(&(*tree)->left, key);
+  } else if (key > (*tree)->key) {
+    bst_avl_delete(&(*tree)->right, key);
+  } else if ((*tree)->left != NULL && (*tree)->right != NULL) {
+    bst_avl_replace_by_rightmost(*tree, &(*tree)->left);
+  } else {
+    //a node with at most one subtree is replaced by it
+    bst_node_t *tmp = *tree;
+    *tree = (*tree)->left != NULL ? (*tree)->left : (*tree)->right;
+    free(tmp);
+  }
+
+  if (*tree != NULL) {
+    bst_avl_rebalance(tree);
+  }
+}
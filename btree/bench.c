@@ -0,0 +1,639 @@
+/*
+ * Měření výkonu vyhledávacích stromů.
+ *
+ * Soubor se překládá zvlášť pro každou variantu stromu, makra BENCH_INSERT
+ * a BENCH_DELETE určují funkce, které se měří (viz rb/Makefile).
+ *
+ * Měření pool porovnává bst_pool_insert a bst_pool_delete se zásobou uzlů
+ * a s funkcí malloc (pool NULL). Obě tvoří nevyvážený strom, ve všech
+ * variantách se proto měří stejný strom a liší se jen alokace uzlů.
+ *
+ * Měření layout a disk porovnávají pořadí uzlů v poli s klíči typu int a
+ * na variantě nezávisí. Měření disk zapíše do aktuálního adresáře dva
+ * soubory po 1 GiB a po skončení je smaže.
+ *
+ * Spuštění: ./bench_rb [název měření ...], bez argumentů spustí všechna.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
+#include "btree.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef BENCH_INSERT
+#define BENCH_INSERT bst_insert
+#endif
+#ifndef BENCH_DELETE
+#define BENCH_DELETE bst_delete
+#endif
+
+// Počet různých klíčů, kladné hodnoty typu char
+#define KEY_COUNT 127
+
+// Délka náhodných proudů klíčů a počet opakování měření
+#define STREAM_LENGTH 4096
+#define ROUNDS 2000
+
+// Počet stromů a opakování v měření pool
+#define POOL_TREES 256
+#define POOL_ROUNDS 20
+
+// Počet vyhledání v měření layout a disk
+#define LAYOUT_QUERIES 1000000
+#define DISK_QUERIES 300
+
+// Uzel binárního stromu s ukazateli jako bst_node_t, jen s klíčem int
+typedef struct int_node {
+  int key;
+  int value;
+  struct int_node *left;
+  struct int_node *right;
+} int_node_t;
+
+static const char *variant = "";
+
+static double now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static unsigned long long bench_rand(unsigned long long *state) {
+  //xorshift64*
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return *state * 2685821657736338717ULL;
+}
+
+static int tree_height(bst_node_t *tree) {
+  if (tree == NULL) {
+    return 0;
+  }
+  int left = tree_height(tree->left), right = tree_height(tree->right);
+  return (left > right ? left : right) + 1;
+}
+
+/*
+ * Vzestupně seřazené klíče 1 až KEY_COUNT, nejhorší případ pro
+ * nevyvážený strom.
+ */
+static int make_sorted_keys(char *keys) {
+  for (int i = 0; i < KEY_COUNT; i++) {
+    keys[i] = (char)(i + 1);
+  }
+  return KEY_COUNT;
+}
+
+/*
+ * Klíče 1 až KEY_COUNT v náhodném pořadí.
+ */
+static void make_shuffled_keys(char *keys, unsigned long long *seed) {
+  make_sorted_keys(keys);
+  for (int i = KEY_COUNT - 1; i > 0; i--) {
+    int j = bench_rand(seed) % (i + 1);
+    char tmp = keys[i];
+    keys[i] = keys[j];
+    keys[j] = tmp;
+  }
+}
+
+static int make_random_keys(char *keys) {
+  unsigned long long seed = 42;
+  for (int i = 0; i < STREAM_LENGTH; i++) {
+    keys[i] = (char)(bench_rand(&seed) % KEY_COUNT + 1);
+  }
+  return STREAM_LENGTH;
+}
+
+/*
+ * Klíče se Zipfovým rozdělením s exponentem 1, pořadí klíčů podle četnosti
+ * je náhodná permutace.
+ */
+static int make_zipf_keys(char *keys) {
+  unsigned long long seed = 7;
+  char ranked[KEY_COUNT];
+  double cdf[KEY_COUNT], sum = 0;
+
+  make_sorted_keys(ranked);
+  for (int i = KEY_COUNT - 1; i > 0; i--) {
+    int j = bench_rand(&seed) % (i + 1);
+    char tmp = ranked[i];
+    ranked[i] = ranked[j];
+    ranked[j] = tmp;
+  }
+  for (int i = 0; i < KEY_COUNT; i++) {
+    sum += 1.0 / (i + 1);
+    cdf[i] = sum;
+  }
+
+  for (int i = 0; i < STREAM_LENGTH; i++) {
+    double u = (bench_rand(&seed) >> 11) * 0x1.0p-53 * sum;
+    int low = 0, high = KEY_COUNT - 1;
+    while (low < high) {
+      int mid = (low + high) / 2;
+      if (cdf[mid] < u) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+    keys[i] = ranked[low];
+  }
+  return STREAM_LENGTH;
+}
+
+/*
+ * Vložení, vyhledání a odstranění všech klíčů proudu, opakované ROUNDS krát
+ * do prázdného stromu.
+ */
+static void run_stream(const char *name, const char *keys, int count) {
+  double insert_time = 0, search_time = 0, delete_time = 0;
+  long long found = 0;
+  int height = 0;
+
+  for (int round = 0; round < ROUNDS; round++) {
+    bst_node_t *tree;
+    bst_init(&tree);
+
+    double start = now_sec();
+    for (int i = 0; i < count; i++) {
+      BENCH_INSERT(&tree, keys[i], i);
+    }
+    double inserted = now_sec();
+    for (int i = 0; i < count; i++) {
+      int value;
+      found += bst_search(tree, keys[i], &value);
+    }
+    double searched = now_sec();
+    height = tree_height(tree);
+    double deleting = now_sec();
+    for (int i = 0; i < count; i++) {
+      BENCH_DELETE(&tree, keys[i]);
+    }
+    double deleted = now_sec();
+
+    insert_time += inserted - start;
+    search_time += searched - inserted;
+    delete_time += deleted - deleting;
+    bst_dispose(&tree);
+  }
+
+  double ops = (double)count * ROUNDS;
+  printf("%-10s %-8s insert %6.1f ns  search %6.1f ns  delete %6.1f ns  "
+         "height %3d%s\n",
+         variant, name, insert_time / ops * 1e9, search_time / ops * 1e9,
+         delete_time / ops * 1e9, height, found == ops ? "" : "  MISSING");
+}
+
+/*
+ * Seřazené, náhodné a Zipfovy proudy klíčů.
+ */
+static void bench_streams(void) {
+  char *keys = malloc(STREAM_LENGTH);
+  if (keys == NULL) {
+    return;
+  }
+  run_stream("sorted", keys, make_sorted_keys(keys));
+  run_stream("random", keys, make_random_keys(keys));
+  run_stream("zipf", keys, make_zipf_keys(keys));
+  free(keys);
+}
+
+/*
+ * Vyhledání ve stromu se všemi KEY_COUNT klíči vloženými v náhodném
+ * pořadí a ve stejném stromu po bst_freeze. Hledají se náhodné klíče ze
+ * stromu, skoky při procházení stromu se tak nedají předvídat.
+ */
+static void bench_frozen(void) {
+  char inserted[KEY_COUNT];
+  char *queries = malloc(STREAM_LENGTH);
+  if (queries == NULL) {
+    return;
+  }
+  unsigned long long seed = 11;
+  make_shuffled_keys(inserted, &seed);
+  for (int i = 0; i < STREAM_LENGTH; i++) {
+    queries[i] = (char)(bench_rand(&seed) % KEY_COUNT + 1);
+  }
+
+  bst_node_t *tree;
+  bst_init(&tree);
+  for (int i = 0; i < KEY_COUNT; i++) {
+    BENCH_INSERT(&tree, inserted[i], i);
+  }
+  bst_frozen_t frozen;
+  if (!bst_freeze(tree, &frozen)) {
+    bst_dispose(&tree);
+    free(queries);
+    return;
+  }
+
+  long long found[2] = {0, 0};
+  int value;
+  double start = now_sec();
+  for (int round = 0; round < ROUNDS; round++) {
+    for (int i = 0; i < STREAM_LENGTH; i++) {
+      found[0] += bst_search(tree, queries[i], &value);
+    }
+  }
+  double tree_time = now_sec() - start;
+  start = now_sec();
+  for (int round = 0; round < ROUNDS; round++) {
+    for (int i = 0; i < STREAM_LENGTH; i++) {
+      found[1] += bst_frozen_search(&frozen, queries[i], &value);
+    }
+  }
+  double frozen_time = now_sec() - start;
+
+  double ops = (double)STREAM_LENGTH * ROUNDS;
+  printf("%-10s frozen   tree %6.1f ns  frozen %6.1f ns  speedup %.2fx  "
+         "height %3d%s\n",
+         variant, tree_time / ops * 1e9, frozen_time / ops * 1e9,
+         tree_time / frozen_time, tree_height(tree),
+         found[0] == found[1] ? "" : "  MISMATCH");
+  bst_frozen_dispose(&frozen);
+  bst_dispose(&tree);
+  free(queries);
+}
+
+/*
+ * Vložení klíčů do POOL_TREES stromů střídavě, jako když program staví
+ * více stromů najednou, vyhledání v náhodných stromech, odstranění a nové
+ * vložení poloviny klíčů a zrušení všech stromů. S funkcí malloc leží uzly
+ * jednoho stromu daleko od sebe, se zásobou v několika blocích.
+ */
+static void run_pool(bool pooled, const char *inserted, const char *queries) {
+  bst_node_t *trees[POOL_TREES];
+  bst_pool_t pools[POOL_TREES];
+  double insert_time = 0, search_time = 0, churn_time = 0, dispose_time = 0;
+  long long found = 0;
+  unsigned long long seed = 13;
+
+  for (int round = 0; round < POOL_ROUNDS; round++) {
+    for (int t = 0; t < POOL_TREES; t++) {
+      bst_init(&trees[t]);
+      bst_pool_init(&pools[t]);
+    }
+
+    double start = now_sec();
+    for (int i = 0; i < KEY_COUNT; i++) {
+      for (int t = 0; t < POOL_TREES; t++) {
+        bst_pool_insert(pooled ? &pools[t] : NULL, &trees[t], inserted[i], i);
+      }
+    }
+    double inserted_at = now_sec();
+    for (int i = 0; i < STREAM_LENGTH * 16; i++) {
+      int value;
+      int t = bench_rand(&seed) % POOL_TREES;
+      found += bst_search(trees[t], queries[i % STREAM_LENGTH], &value);
+    }
+    double searched = now_sec();
+    for (int t = 0; t < POOL_TREES; t++) {
+      for (int i = 0; i < KEY_COUNT / 2; i++) {
+        bst_pool_delete(pooled ? &pools[t] : NULL, &trees[t], inserted[i]);
+      }
+      for (int i = 0; i < KEY_COUNT / 2; i++) {
+        bst_pool_insert(pooled ? &pools[t] : NULL, &trees[t], inserted[i], i);
+      }
+    }
+    double churned = now_sec();
+    for (int t = 0; t < POOL_TREES; t++) {
+      if (pooled) {
+        bst_pool_dispose(&pools[t], &trees[t]);
+      } else {
+        bst_dispose(&trees[t]);
+      }
+    }
+    double disposed = now_sec();
+
+    insert_time += inserted_at - start;
+    search_time += searched - inserted_at;
+    churn_time += churned - searched;
+    dispose_time += disposed - churned;
+  }
+
+  double nodes = (double)KEY_COUNT * POOL_TREES * POOL_ROUNDS;
+  double searches = (double)STREAM_LENGTH * 16 * POOL_ROUNDS;
+  printf("%-10s pool     %-6s insert %6.1f ns  search %6.1f ns  "
+         "delete+insert %6.1f ns  dispose %6.1f ns/node%s\n",
+         variant, pooled ? "pool" : "malloc", insert_time / nodes * 1e9,
+         search_time / searches * 1e9, churn_time / (nodes / 2) * 1e9,
+         dispose_time / nodes * 1e9, found == searches ? "" : "  MISSING");
+}
+
+static void bench_pool(void) {
+  char inserted[KEY_COUNT];
+  char *queries = malloc(STREAM_LENGTH);
+  if (queries == NULL) {
+    return;
+  }
+  unsigned long long seed = 17;
+  make_shuffled_keys(inserted, &seed);
+  for (int i = 0; i < STREAM_LENGTH; i++) {
+    queries[i] = (char)(bench_rand(&seed) % KEY_COUNT + 1);
+  }
+  run_pool(false, inserted, queries);
+  run_pool(true, inserted, queries);
+  free(queries);
+}
+
+/*
+ * Prvních 10 klíčů větších nebo rovných náhodnému klíči, jednou přes celý
+ * průchod bst_inorder do pole a jednou iterátorem od bst_iter_seek.
+ */
+static void bench_iter(void) {
+  char inserted[KEY_COUNT];
+  unsigned long long seed = 19;
+  make_shuffled_keys(inserted, &seed);
+  bst_node_t *tree;
+  bst_init(&tree);
+  for (int i = 0; i < KEY_COUNT; i++) {
+    BENCH_INSERT(&tree, inserted[i], i);
+  }
+
+  //both loops look up the same keys
+  unsigned long long query_seed = seed;
+  long long sums[2] = {0, 0};
+  double start = now_sec();
+  for (int round = 0; round < ROUNDS * 16; round++) {
+    char from = (char)(bench_rand(&seed) % KEY_COUNT + 1);
+    bst_items_t items = {NULL, 0, 0};
+    bst_inorder(tree, &items);
+    int taken = 0;
+    for (int i = 0; i < items.size && taken < 10; i++) {
+      if (items.nodes[i]->key >= from) {
+        sums[0] += items.nodes[i]->key;
+        taken++;
+      }
+    }
+    free(items.nodes);
+  }
+  double items_time = now_sec() - start;
+
+  seed = query_seed;
+  start = now_sec();
+  for (int round = 0; round < ROUNDS * 16; round++) {
+    char from = (char)(bench_rand(&seed) % KEY_COUNT + 1);
+    bst_iter_t iter;
+    bst_node_t *node;
+    bst_iter_seek(&iter, tree, from);
+    for (int taken = 0; taken < 10 && (node = bst_iter_next(&iter)) != NULL;
+         taken++) {
+      sums[1] += node->key;
+    }
+  }
+  double iter_time = now_sec() - start;
+
+  printf("%-10s iter     first 10 from key: inorder %7.1f ns  "
+         "iterator %6.1f ns  speedup %.1fx%s\n",
+         variant, items_time / (ROUNDS * 16) * 1e9,
+         iter_time / (ROUNDS * 16) * 1e9, items_time / iter_time,
+         sums[0] == sums[1] ? "" : "  MISMATCH");
+  bst_dispose(&tree);
+}
+
+/*
+ * Náhodná permutace čísel 0 až n - 1.
+ */
+static int *make_permutation(int n, unsigned long long seed) {
+  int *perm = malloc((size_t)n * sizeof(int));
+  if (perm == NULL) {
+    return NULL;
+  }
+  for (int i = 0; i < n; i++) {
+    perm[i] = i;
+  }
+  for (int i = n - 1; i > 0; i--) {
+    int j = bench_rand(&seed) % (i + 1);
+    int tmp = perm[i];
+    perm[i] = perm[j];
+    perm[j] = tmp;
+  }
+  return perm;
+}
+
+/*
+ * Vyvážený strom z uzlů s pořadím start až end, uzel s pořadím r je
+ * nodes[position[r]] a má klíč 2 r + 1.
+ */
+static int_node_t *build_balanced(int_node_t *nodes, const int *position,
+                                  int start, int end) {
+  if (start > end) {
+    return NULL;
+  }
+  int mid = start + (end - start) / 2;
+  int_node_t *root = &nodes[position[mid]];
+  root->key = 2 * mid + 1;
+  root->value = mid;
+  root->left = build_balanced(nodes, position, start, mid - 1);
+  root->right = build_balanced(nodes, position, mid + 1, end);
+  return root;
+}
+
+static bool int_tree_search(const int_node_t *tree, int key, int *value) {
+  while (tree != NULL) {
+    if (key == tree->key) {
+      *value = tree->value;
+      return true;
+    }
+    tree = key < tree->key ? tree->left : tree->right;
+  }
+  return false;
+}
+
+/*
+ * Pole s n lichými klíči 1, 3, 5, ... v pořadí layout.
+ */
+static bool make_packed(int n, bst_layout_t layout, bst_packed_t *packed) {
+  int *keys = malloc((size_t)n * sizeof(int));
+  int *values = malloc((size_t)n * sizeof(int));
+  bool made = keys != NULL && values != NULL;
+  for (int i = 0; made && i < n; i++) {
+    keys[i] = 2 * i + 1;
+    values[i] = i;
+  }
+  made = made && bst_pack_sorted(keys, values, n, layout, packed);
+  free(keys);
+  free(values);
+  return made;
+}
+
+/*
+ * Počet různých bloků velikosti block bajtů, které projde
+ * hledání klíče key.
+ */
+static int packed_blocks(const bst_packed_t *packed, int key, size_t block) {
+  int blocks = 0, i = 0;
+  size_t last = (size_t)-1;
+  while (i >= 0) {
+    size_t current = i * sizeof(bst_packed_node_t) / block;
+    blocks += current != last;
+    last = current;
+    if (key == packed->nodes[i].key) {
+      break;
+    }
+    i = key < packed->nodes[i].key ? packed->nodes[i].left
+                                   : packed->nodes[i].right;
+  }
+  return blocks;
+}
+
+static void run_layout(int n) {
+  const char *names[2] = {"bfs", "veb"};
+  double times[3] = {0, 0, 0};
+  double lines[2] = {0, 0}, pages[2] = {0, 0};
+  long long found = 0;
+  int value;
+  int *queries = make_permutation(n, 3);
+  if (queries == NULL) {
+    return;
+  }
+  int count = n < LAYOUT_QUERIES ? n : LAYOUT_QUERIES;
+
+  for (int layout = 0; layout < 2; layout++) {
+    bst_packed_t packed;
+    if (!make_packed(n, layout, &packed)) {
+      printf("%d keys: out of memory\n", n);
+      free(queries);
+      return;
+    }
+    double start = now_sec();
+    for (int i = 0; i < count; i++) {
+      found += bst_packed_search(&packed, 2 * queries[i] + 1, &value);
+    }
+    times[layout] = now_sec() - start;
+    for (int i = 0; i < 10000; i++) {
+      int key = 2 * queries[i % n] + 1;
+      lines[layout] += packed_blocks(&packed, key, 64) / 10000.0;
+      pages[layout] += packed_blocks(&packed, key, 4096) / 10000.0;
+    }
+    bst_packed_dispose(&packed);
+  }
+
+  //pointer tree with nodes in random insertion order
+  int *perm = make_permutation(n, 42);
+  int *position = malloc((size_t)n * sizeof(int));
+  int_node_t *nodes = malloc((size_t)n * sizeof(int_node_t));
+  if (perm != NULL && position != NULL && nodes != NULL) {
+    for (int i = 0; i < n; i++) {
+      position[perm[i]] = i;
+    }
+    int_node_t *root = build_balanced(nodes, position, 0, n - 1);
+    double start = now_sec();
+    for (int i = 0; i < count; i++) {
+      found += int_tree_search(root, 2 * queries[i] + 1, &value);
+    }
+    times[2] = now_sec() - start;
+  }
+  free(perm);
+  free(position);
+  free(nodes);
+  free(queries);
+
+  printf("%9d keys %7.1f MiB  pointers %6.1f ns", n,
+         n * sizeof(bst_packed_node_t) / 1048576.0, times[2] / count * 1e9);
+  for (int layout = 0; layout < 2; layout++) {
+    printf("  %s %6.1f ns %4.1f lines %4.1f pages", names[layout],
+           times[layout] / count * 1e9, lines[layout], pages[layout]);
+  }
+  printf("%s\n", found == 3LL * count ? "" : "  MISSING");
+}
+
+/*
+ * Vyhledání ve stromech od velikosti cache L1 po stovky MiB.
+ */
+static void bench_layout(void) {
+  for (int n = 1 << 10; n <= 1 << 26; n *= 4) {
+    run_layout(n);
+  }
+}
+
+/*
+ * Vyhledání v poli namapovaném ze souboru, který před každým hledáním
+ * zmizí z paměti. Každý přístup do nové stránky tak čte z disku, jako
+ * když je strom větší než paměť.
+ */
+static void bench_disk(void) {
+  const char *names[2] = {"bfs", "veb"};
+  const char *paths[2] = {"bench_bfs.bin", "bench_veb.bin"};
+  const int n = 1 << 26;
+  int *queries = make_permutation(n, 5);
+  if (queries == NULL) {
+    return;
+  }
+
+  for (int layout = 0; layout < 2; layout++) {
+    bst_packed_t packed;
+    if (!make_packed(n, layout, &packed)) {
+      break;
+    }
+    bool saved = bst_packed_save(&packed, paths[layout]);
+    bst_packed_dispose(&packed);
+    int fd = open(paths[layout], O_RDONLY);
+    if (!saved || fd < 0 || !bst_packed_map(&packed, paths[layout])) {
+      printf("disk %s: cannot write or map %s\n", names[layout],
+             paths[layout]);
+      if (fd >= 0) {
+        close(fd);
+      }
+      remove(paths[layout]);
+      continue;
+    }
+
+    double time = 0;
+    long long found = 0;
+    int value;
+    for (int i = 0; i < DISK_QUERIES; i++) {
+      //drop the mapped pages and the page cache
+      madvise(packed.mapping, packed.mapping_size, MADV_DONTNEED);
+      posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+      double start = now_sec();
+      found += bst_packed_search(&packed, 2 * queries[i] + 1, &value);
+      time += now_sec() - start;
+    }
+    printf("%9d keys %7.1f MiB  cold %s %8.1f us per search%s\n", n,
+           n * sizeof(bst_packed_node_t) / 1048576.0, names[layout],
+           time / DISK_QUERIES * 1e6, found == DISK_QUERIES ? "" : "  MISSING");
+    bst_packed_dispose(&packed);
+    close(fd);
+    remove(paths[layout]);
+  }
+  free(queries);
+}
+
+static const struct {
+  const char *name;
+  void (*run)(void);
+} BENCHES[] = {
+    {"streams", bench_streams},
+    {"frozen", bench_frozen},
+    {"pool", bench_pool},
+    {"iter", bench_iter},
+    {"layout", bench_layout},
+    {"disk", bench_disk},
+};
+
+int main(int argc, char *argv[]) {
+  int count = sizeof(BENCHES) / sizeof(BENCHES[0]);
+  const char *slash = strrchr(argv[0], '/');
+  variant = slash != NULL ? slash + 1 : argv[0];
+
+  for (int i = 0; i < count; i++) {
+    bool selected = argc == 1;
+    for (int j = 1; j < argc; j++) {
+      selected = selected || strcmp(argv[j], BENCHES[i].name) == 0;
+    }
+    if (selected) {
+      BENCHES[i].run();
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,212 @@
+/*
+ * Měření výkonu B+stromu proti vyváženému binárnímu stromu.
+ *
+ * Binární strom má uzly jako bst_node_t, jen s klíčem typu int, a je
+ * dokonale vyvážený jako po bst_balance. Uzly leží v paměti v pořadí, v
+ * jakém by je alokovalo vkládání náhodně seřazených klíčů.
+ *
+ * Spuštění: ./bench [název měření ...], bez argumentů spustí všechna.
+ * Program bench_scalar měří totéž s hledáním v uzlu bez SSE2.
+ * Měření 100m potřebuje asi 3 GB paměti.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "bplus.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Nejvýš tolik vyhledání v jednom měření
+#define QUERY_COUNT 10000000
+
+// Hledání v uzlu B+stromu, bench_scalar se překládá s -DBPT_SCALAR
+#ifdef BPT_SCALAR
+#define BENCH_SEARCH "scalar"
+#else
+#define BENCH_SEARCH "sse2"
+#endif
+
+typedef struct int_node {
+  int key;
+  int value;
+  struct int_node *left;
+  struct int_node *right;
+} int_node_t;
+
+static double now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static unsigned long long bench_rand(unsigned long long *state) {
+  //xorshift64*
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return *state * 2685821657736338717ULL;
+}
+
+/*
+ * Náhodná permutace čísel 0 až n - 1.
+ */
+static int *make_permutation(int n, unsigned long long seed) {
+  int *perm = malloc((size_t)n * sizeof(int));
+  if (perm == NULL) {
+    return NULL;
+  }
+  for (int i = 0; i < n; i++) {
+    perm[i] = i;
+  }
+  for (int i = n - 1; i > 0; i--) {
+    int j = bench_rand(&seed) % (i + 1);
+    int tmp = perm[i];
+    perm[i] = perm[j];
+    perm[j] = tmp;
+  }
+  return perm;
+}
+
+/*
+ * Vyvážený strom z uzlů s pořadím start až end, uzel s pořadím r je
+ * nodes[position[r]] a má klíč 2 r + 1.
+ */
+static int_node_t *build_balanced(int_node_t *nodes, const int *position,
+                                  int start, int end) {
+  if (start > end) {
+    return NULL;
+  }
+  int mid = start + (end - start) / 2;
+  int_node_t *root = &nodes[position[mid]];
+  root->key = 2 * mid + 1;
+  root->value = mid;
+  root->left = build_balanced(nodes, position, start, mid - 1);
+  root->right = build_balanced(nodes, position, mid + 1, end);
+  return root;
+}
+
+static bool int_tree_search(const int_node_t *tree, int key, int *value) {
+  while (tree != NULL) {
+    if (key == tree->key) {
+      *value = tree->value;
+      return true;
+    }
+    tree = key < tree->key ? tree->left : tree->right;
+  }
+  return false;
+}
+
+/*
+ * Vložení n náhodně seřazených lichých klíčů, vyhledání, průchod listy a
+ * odstranění všech klíčů. Pak vyhledání ve vyváženém binárním stromu.
+ */
+static void run_size(int n) {
+  int *perm = make_permutation(n, 42);
+  if (perm == NULL) {
+    printf("%d keys: out of memory\n", n);
+    return;
+  }
+  int queries = n < QUERY_COUNT ? n : QUERY_COUNT;
+  long long found = 0;
+  int value;
+
+  bpt_tree_t tree;
+  bpt_init(&tree);
+  double start = now_sec();
+  for (int i = 0; i < n; i++) {
+    bpt_insert(&tree, 2 * perm[i] + 1, perm[i]);
+  }
+  double insert_time = now_sec() - start;
+  size_t memory = tree.nodes * sizeof(bpt_node_t);
+  int height = tree.height;
+
+  //queries in another random order
+  start = now_sec();
+  for (int i = 0; i < queries; i++) {
+    found += bpt_search(&tree, 2 * perm[n - 1 - i] + 1, &value);
+  }
+  double search_time = now_sec() - start;
+
+  bpt_iter_t iter;
+  int key;
+  long long scanned = 0;
+  start = now_sec();
+  bpt_iter_begin(&iter, &tree, 0);
+  while (bpt_iter_next(&iter, &key, &value)) {
+    scanned += key;
+  }
+  double scan_time = now_sec() - start;
+
+  start = now_sec();
+  for (int i = 0; i < n; i++) {
+    bpt_delete(&tree, 2 * perm[i] + 1);
+  }
+  double delete_time = now_sec() - start;
+  bpt_dispose(&tree);
+
+  //nodes of the binary tree in insertion order
+  double tree_time = 0;
+  int *position = malloc((size_t)n * sizeof(int));
+  int_node_t *nodes = malloc((size_t)n * sizeof(int_node_t));
+  if (position != NULL && nodes != NULL) {
+    for (int i = 0; i < n; i++) {
+      position[perm[i]] = i;
+    }
+    int_node_t *root = build_balanced(nodes, position, 0, n - 1);
+    start = now_sec();
+    for (int i = 0; i < queries; i++) {
+      found += int_tree_search(root, 2 * perm[n - 1 - i] + 1, &value);
+    }
+    tree_time = now_sec() - start;
+  }
+  free(position);
+  free(nodes);
+
+  printf("%9d keys  height %d  %5.1f B/key  insert %6.1f ns  "
+         "delete %6.1f ns  scan %5.2f ns/key\n",
+         n, height, (double)memory / n, insert_time / n * 1e9,
+         delete_time / n * 1e9, scan_time / n * 1e9);
+  printf("%16s search  b+tree %-6s %6.1f ns  binary tree %6.1f ns%s\n",
+         "", BENCH_SEARCH, search_time / queries * 1e9,
+         tree_time / queries * 1e9,
+         found == 2LL * queries && scanned > 0 ? "" : "  MISSING");
+  free(perm);
+}
+
+static void bench_1m(void) {
+  run_size(1000000);
+}
+
+static void bench_10m(void) {
+  run_size(10000000);
+}
+
+static void bench_100m(void) {
+  run_size(100000000);
+}
+
+static const struct {
+  const char *name;
+  void (*run)(void);
+} BENCHES[] = {
+    {"1m", bench_1m},
+    {"10m", bench_10m},
+    {"100m", bench_100m},
+};
+
+int main(int argc, char *argv[]) {
+  int count = sizeof(BENCHES) / sizeof(BENCHES[0]);
+
+  for (int i = 0; i < count; i++) {
+    bool selected = argc == 1;
+    for (int j = 1; j < argc; j++) {
+      selected = selected || strcmp(argv[j], BENCHES[i].name) == 0;
+    }
+    if (selected) {
+      BENCHES[i].run();
+    }
+  }
+  return 0;
+}
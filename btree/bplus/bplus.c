@@ -0,0 +1,425 @@
+/*
+ * B+strom s širokými uzly
+ *
+ * Vnitřní uzly obsahují jen oddělovací klíče a ukazatele na potomky,
+ * dvojice klíč a hodnota jsou v listech. Všechny listy jsou ve stejné
+ * hloubce a každý uzel kromě kořene má aspoň BPT_MIN_KEYS klíčů.
+ *
+ * Uzel se prohledává celý, volná místa obsahují INT_MAX, které není
+ * menší než žádný klíč. S SSE2 se porovnávají čtyři klíče najednou a
+ * výsledky porovnání se sčítají bez větvení; pozice klíče je počet
+ * menších klíčů.
+ *
+ * Vkládání rozdělí plný uzel už cestou dolů, takže rodič má vždy místo
+ * pro nový oddělovač a nic se nevrací nahoru. Odstranění doplní uzel,
+ * který klesl pod BPT_MIN_KEYS, od sourozence, nebo ho se sourozencem
+ * spojí.
+ */
+
+#include "bplus.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && defined(__SSE2__) && !defined(BPT_SCALAR)
+#define BPT_SSE2 1
+#include <emmintrin.h>
+#endif
+
+/*
+ * Počet klíčů uzlu menších než key, tedy pozice key v uzlu.
+ */
+static int bpt_rank(const bpt_node_t *node, int key) {
+#ifdef BPT_SSE2
+  __m128i needle = _mm_set1_epi32(key);
+  __m128i less = _mm_setzero_si128();
+  for (int i = 0; i < BPT_KEYS; i += 4) {
+    __m128i keys = _mm_load_si128((const __m128i *)(node->keys + i));
+    //a true lane is -1, subtracting it counts
+    less = _mm_sub_epi32(less, _mm_cmplt_epi32(keys, needle));
+  }
+  less = _mm_add_epi32(less, _mm_shuffle_epi32(less, 0x4e));
+  less = _mm_add_epi32(less, _mm_shuffle_epi32(less, 0xb1));
+  return _mm_cvtsi128_si32(less);
+#else
+  int less = 0;
+  for (int i = 0; i < BPT_KEYS; i++) {
+    less += node->keys[i] < key;
+  }
+  return less;
+#endif
+}
+
+/*
+ * Index potomka vnitřního uzlu, v jehož podstromu je key.
+ */
+static int bpt_child_index(const bpt_node_t *node, int key) {
+  int i = bpt_rank(node, key);
+  return i + (i < node->count && node->keys[i] == key);
+}
+
+/*
+ * Vyplnění volných míst uzlu za count klíčem INT_MAX.
+ */
+static void bpt_pad(bpt_node_t *node) {
+  for (int i = node->count; i < BPT_KEYS; i++) {
+    node->keys[i] = INT_MAX;
+  }
+}
+
+static bpt_node_t *bpt_node_new(bpt_tree_t *tree, bool leaf) {
+  bpt_node_t *node = aligned_alloc(_Alignof(bpt_node_t), sizeof(bpt_node_t));
+  if (node == NULL) {
+    return NULL;
+  }
+  node->count = 0;
+  node->leaf = leaf;
+  if (leaf) {
+    node->next = NULL;
+  }
+  bpt_pad(node);
+  tree->nodes++;
+  return node;
+}
+
+static void bpt_node_free(bpt_tree_t *tree, bpt_node_t *node) {
+  free(node);
+  tree->nodes--;
+}
+
+/*
+ * Inicializace prázdného stromu.
+ */
+void bpt_init(bpt_tree_t *tree) {
+  tree->root = NULL;
+  tree->count = 0;
+  tree->nodes = 0;
+  tree->height = 0;
+}
+
+/*
+ * Rozdělení plného potomka parent->children[i] na dva uzly.
+ *
+ * Rodič nesmí být plný. List si ponechá dolní polovinu klíčů a první klíč
+ * nového listu se zkopíruje do rodiče jako oddělovač. Vnitřní uzel
+ * prostřední klíč do rodiče přesune. Vrací false, pokud se nepodaří
+ * alokovat nový uzel; strom pak zůstane beze změny.
+ */
+static bool bpt_split_child(bpt_tree_t *tree, bpt_node_t *parent, int i) {
+  bpt_node_t *child = parent->children[i];
+  bpt_node_t *right = bpt_node_new(tree, child->leaf);
+  if (right == NULL) {
+    return false;
+  }
+
+  int half = BPT_KEYS / 2;
+  int separator;
+  if (child->leaf) {
+    right->count = BPT_KEYS - half;
+    memcpy(right->keys, child->keys + half, right->count * sizeof(int));
+    memcpy(right->values, child->values + half, right->count * sizeof(int));
+    right->next = child->next;
+    child->next = right;
+    separator = right->keys[0];
+  } else {
+    right->count = BPT_KEYS - half - 1;
+    memcpy(right->keys, child->keys + half + 1, right->count * sizeof(int));
+    memcpy(right->children, child->children + half + 1,
+           (right->count + 1) * sizeof(bpt_node_t *));
+    separator = child->keys[half];
+  }
+  child->count = half;
+  bpt_pad(child);
+
+  //make room in the parent for the separator and the new child
+  memmove(parent->keys + i + 1, parent->keys + i,
+          (parent->count - i) * sizeof(int));
+  memmove(parent->children + i + 2, parent->children + i + 1,
+          (parent->count - i) * sizeof(bpt_node_t *));
+  parent->keys[i] = separator;
+  parent->children[i + 1] = right;
+  parent->count++;
+  return true;
+}
+
+/*
+ * Vložení klíče do stromu, existující klíč dostane novou hodnotu.
+ *
+ * Pokud se nepodaří alokovat paměť, funkce strom nezmění.
+ */
+void bpt_insert(bpt_tree_t *tree, int key, int value) {
+  if (tree->root == NULL) {
+    tree->root = bpt_node_new(tree, true);
+    if (tree->root == NULL) {
+      return;
+    }
+    tree->height = 1;
+  }
+
+  //a full root gets a new parent, the tree grows at the top
+  if (tree->root->count == BPT_KEYS) {
+    bpt_node_t *root = bpt_node_new(tree, false);
+    if (root == NULL) {
+      return;
+    }
+    root->children[0] = tree->root;
+    if (!bpt_split_child(tree, root, 0)) {
+      bpt_node_free(tree, root);
+      return;
+    }
+    tree->root = root;
+    tree->height++;
+  }
+
+  //split full nodes on the way down
+  bpt_node_t *node = tree->root;
+  while (!node->leaf) {
+    int i = bpt_child_index(node, key);
+    if (node->children[i]->count == BPT_KEYS) {
+      if (!bpt_split_child(tree, node, i)) {
+        return;
+      }
+      i += key >= node->keys[i];
+    }
+    node = node->children[i];
+  }
+
+  int i = bpt_rank(node, key);
+  if (i < node->count && node->keys[i] == key) {
+    node->values[i] = value;
+    return;
+  }
+  memmove(node->keys + i + 1, node->keys + i, (node->count - i) * sizeof(int));
+  memmove(node->values + i + 1, node->values + i,
+          (node->count - i) * sizeof(int));
+  node->keys[i] = key;
+  node->values[i] = value;
+  node->count++;
+  tree->count++;
+}
+
+/*
+ * Vyhledání klíče, při úspěchu zapíše jeho hodnotu do value.
+ */
+bool bpt_search(const bpt_tree_t *tree, int key, int *value) {
+  const bpt_node_t *node = tree->root;
+  if (node == NULL) {
+    return false;
+  }
+  while (!node->leaf) {
+    node = node->children[bpt_child_index(node, key)];
+  }
+
+  int i = bpt_rank(node, key);
+  if (i < node->count && node->keys[i] == key) {
+    *value = node->values[i];
+    return true;
+  }
+  return false;
+}
+
+/*
+ * Přesun jednoho klíče z levého sourozence do potomka parent->children[i].
+ */
+static void bpt_borrow_left(bpt_node_t *parent, int i) {
+  bpt_node_t *child = parent->children[i];
+  bpt_node_t *left = parent->children[i - 1];
+
+  memmove(child->keys + 1, child->keys, child->count * sizeof(int));
+  if (child->leaf) {
+    memmove(child->values + 1, child->values, child->count * sizeof(int));
+    child->keys[0] = left->keys[left->count - 1];
+    child->values[0] = left->values[left->count - 1];
+    parent->keys[i - 1] = child->keys[0];
+  } else {
+    //the separator comes down, the last key of the sibling goes up
+    memmove(child->children + 1, child->children,
+            (child->count + 1) * sizeof(bpt_node_t *));
+    child->keys[0] = parent->keys[i - 1];
+    child->children[0] = left->children[left->count];
+    parent->keys[i - 1] = left->keys[left->count - 1];
+  }
+  child->count++;
+  left->count--;
+  bpt_pad(left);
+}
+
+/*
+ * Přesun jednoho klíče z pravého sourozence do potomka parent->children[i].
+ */
+static void bpt_borrow_right(bpt_node_t *parent, int i) {
+  bpt_node_t *child = parent->children[i];
+  bpt_node_t *right = parent->children[i + 1];
+
+  if (child->leaf) {
+    child->keys[child->count] = right->keys[0];
+    child->values[child->count] = right->values[0];
+    memmove(right->values, right->values + 1,
+            (right->count - 1) * sizeof(int));
+  } else {
+    child->keys[child->count] = parent->keys[i];
+    child->children[child->count + 1] = right->children[0];
+    memmove(right->children, right->children + 1,
+            right->count * sizeof(bpt_node_t *));
+    parent->keys[i] = right->keys[0];
+  }
+  memmove(right->keys, right->keys + 1, (right->count - 1) * sizeof(int));
+  child->count++;
+  right->count--;
+  bpt_pad(right);
+  if (child->leaf) {
+    parent->keys[i] = right->keys[0];
+  }
+}
+
+/*
+ * Spojení potomků parent->children[i] a parent->children[i + 1] do
+ * levého z nich. Oddělovač z rodiče zmizí, u vnitřních uzlů se přesune
+ * mezi klíče spojeného uzlu.
+ */
+static void bpt_merge(bpt_tree_t *tree, bpt_node_t *parent, int i) {
+  bpt_node_t *left = parent->children[i];
+  bpt_node_t *right = parent->children[i + 1];
+
+  if (left->leaf) {
+    memcpy(left->keys + left->count, right->keys, right->count * sizeof(int));
+    memcpy(left->values + left->count, right->values,
+           right->count * sizeof(int));
+    left->count += right->count;
+    left->next = right->next;
+  } else {
+    left->keys[left->count] = parent->keys[i];
+    memcpy(left->keys + left->count + 1, right->keys,
+           right->count * sizeof(int));
+    memcpy(left->children + left->count + 1, right->children,
+           (right->count + 1) * sizeof(bpt_node_t *));
+    left->count += right->count + 1;
+  }
+  bpt_node_free(tree, right);
+
+  memmove(parent->keys + i, parent->keys + i + 1,
+          (parent->count - i - 1) * sizeof(int));
+  memmove(parent->children + i + 1, parent->children + i + 2,
+          (parent->count - i - 1) * sizeof(bpt_node_t *));
+  parent->count--;
+  bpt_pad(parent);
+}
+
+/*
+ * Doplnění potomka parent->children[i], který má méně než BPT_MIN_KEYS
+ * klíčů, přednostně půjčkou od sourozence.
+ */
+static void bpt_fix_child(bpt_tree_t *tree, bpt_node_t *parent, int i) {
+  if (i > 0 && parent->children[i - 1]->count > BPT_MIN_KEYS) {
+    bpt_borrow_left(parent, i);
+  } else if (i < parent->count &&
+             parent->children[i + 1]->count > BPT_MIN_KEYS) {
+    bpt_borrow_right(parent, i);
+  } else {
+    bpt_merge(tree, parent, i > 0 ? i - 1 : i);
+  }
+}
+
+/*
+ * Odstranění klíče z podstromu node. Vrací true, pokud byl klíč nalezen.
+ */
+static bool bpt_delete_from(bpt_tree_t *tree, bpt_node_t *node, int key) {
+  if (node->leaf) {
+    int i = bpt_rank(node, key);
+    if (i == node->count || node->keys[i] != key) {
+      return false;
+    }
+    memmove(node->keys + i, node->keys + i + 1,
+            (node->count - i - 1) * sizeof(int));
+    memmove(node->values + i, node->values + i + 1,
+            (node->count - i - 1) * sizeof(int));
+    node->count--;
+    bpt_pad(node);
+    return true;
+  }
+
+  //the separator may stay a copy of a deleted key, it still separates
+  int i = bpt_child_index(node, key);
+  if (!bpt_delete_from(tree, node->children[i], key)) {
+    return false;
+  }
+  if (node->children[i]->count < BPT_MIN_KEYS) {
+    bpt_fix_child(tree, node, i);
+  }
+  return true;
+}
+
+/*
+ * Odstranění klíče ze stromu. Pokud klíč ve stromu není, funkce nic
+ * nedělá.
+ */
+void bpt_delete(bpt_tree_t *tree, int key) {
+  if (tree->root == NULL || !bpt_delete_from(tree, tree->root, key)) {
+    return;
+  }
+  tree->count--;
+
+  //an empty root is replaced by its only child, the tree shrinks at the top
+  bpt_node_t *root = tree->root;
+  if (root->count == 0) {
+    tree->root = root->leaf ? NULL : root->children[0];
+    bpt_node_free(tree, root);
+    tree->height--;
+  }
+}
+
+static void bpt_dispose_node(bpt_node_t *node) {
+  if (!node->leaf) {
+    for (int i = 0; i <= node->count; i++) {
+      bpt_dispose_node(node->children[i]);
+    }
+  }
+  free(node);
+}
+
+/*
+ * Zrušení celého stromu, strom pak bude ve stejném stavu jako po
+ * inicializaci. Hloubka rekurze je výška stromu.
+ */
+void bpt_dispose(bpt_tree_t *tree) {
+  if (tree->root != NULL) {
+    bpt_dispose_node(tree->root);
+  }
+  bpt_init(tree);
+}
+
+/*
+ * Začátek průchodu klíči od nejmenšího klíče, který není menší než from.
+ * Celý strom v pořadí klíčů (inorder) projde iterátor od INT_MIN.
+ */
+void bpt_iter_begin(bpt_iter_t *iter, const bpt_tree_t *tree, int from) {
+  const bpt_node_t *node = tree->root;
+  iter->leaf = NULL;
+  iter->index = 0;
+  if (node == NULL) {
+    return;
+  }
+  while (!node->leaf) {
+    node = node->children[bpt_child_index(node, from)];
+  }
+  iter->leaf = node;
+  iter->index = bpt_rank(node, from);
+}
+
+/*
+ * Další klíč a hodnota průchodu, vrací false na konci stromu.
+ */
+bool bpt_iter_next(bpt_iter_t *iter, int *key, int *value) {
+  //only the root leaf can be empty, other leaves have BPT_MIN_KEYS
+  while (iter->leaf != NULL && iter->index >= iter->leaf->count) {
+    iter->leaf = iter->leaf->next;
+    iter->index = 0;
+  }
+  if (iter->leaf == NULL) {
+    return false;
+  }
+  *key = iter->leaf->keys[iter->index];
+  *value = iter->leaf->values[iter->index];
+  iter->index++;
+  return true;
+}
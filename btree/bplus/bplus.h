@@ -0,0 +1,66 @@
+/*
+ * Hlavičkový soubor pro B+strom.
+ *
+ * Uzel B+stromu drží až BPT_KEYS klíčů v souvislém poli zarovnaném na
+ * začátek řádku cache, jeden sestup tak projde celým uzlem místo jednoho
+ * klíče jako u bst_node_t. Hodnoty jsou jen v listech a listy jsou
+ * propojené, průchod v pořadí klíčů (inorder) a rozsahové dotazy proto
+ * jen čtou listy za sebou.
+ *
+ * Klíče jsou typu int, aby strom mohl držet miliony klíčů.
+ *
+ * Uzel se prohledává pomocí SSE2, pokud ho překladač podporuje. Překlad
+ * s -DBPT_SCALAR použije vždy obyčejný cyklus (test_scalar, bench_scalar).
+ */
+
+#ifndef IAL_BTREE_BPLUS_H
+#define IAL_BTREE_BPLUS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Největší počet klíčů v uzlu, násobek čtyř kvůli vektorovému hledání
+#define BPT_KEYS 32
+
+// Nejmenší počet klíčů v uzlu kromě kořene
+#define BPT_MIN_KEYS (BPT_KEYS / 2 - 1)
+
+// Uzel stromu, vnitřní uzel nebo list
+typedef struct bpt_node {
+  _Alignas(64) int keys[BPT_KEYS]; // seřazené klíče, volná místa INT_MAX
+  int count;                       // počet klíčů
+  bool leaf;                       // uzel je list
+  union {
+    // vnitřní uzel: v podstromu children[i] jsou klíče od keys[i - 1]
+    // (včetně) do keys[i]
+    struct bpt_node *children[BPT_KEYS + 1];
+    struct {
+      int values[BPT_KEYS];  // hodnoty klíčů listu
+      struct bpt_node *next; // následující list
+    };
+  };
+} bpt_node_t;
+
+// B+strom
+typedef struct bpt_tree {
+  bpt_node_t *root; // kořen, NULL pro prázdný strom
+  size_t count;     // počet klíčů
+  size_t nodes;     // počet uzlů
+  int height;       // počet úrovní uzlů
+} bpt_tree_t;
+
+// Iterátor přes klíče v pořadí, stav průchodu listy
+typedef struct bpt_iter {
+  const bpt_node_t *leaf; // aktuální list, NULL na konci
+  int index;              // další klíč aktuálního listu
+} bpt_iter_t;
+
+void bpt_init(bpt_tree_t *tree);
+void bpt_insert(bpt_tree_t *tree, int key, int value);
+bool bpt_search(const bpt_tree_t *tree, int key, int *value);
+void bpt_delete(bpt_tree_t *tree, int key);
+void bpt_dispose(bpt_tree_t *tree);
+void bpt_iter_begin(bpt_iter_t *iter, const bpt_tree_t *tree, int from);
+bool bpt_iter_next(bpt_iter_t *iter, int *key, int *value);
+
+#endif
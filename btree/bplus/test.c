@@ -0,0 +1,188 @@
+#include "bplus.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int tests_passed = 0;
+int tests_failed = 0;
+
+void check(bool passed, const char *name) {
+  if (passed) {
+    printf("\033[1;32m[%s] [TEST PASSED ✓]\033[0m\n", name);
+    tests_passed++;
+  } else {
+    printf("\033[1;31m[%s] [TEST FAILED ☓]\033[0m\n", name);
+    tests_failed++;
+  }
+}
+
+/*
+ * Kontrola podstromu: klíče seřazené a v mezích [min, max), volná místa
+ * INT_MAX, obsazenost uzlů a listy ve stejné hloubce. Vrací počet klíčů v
+ * listech, nebo -1, pokud podmínky nesplňuje.
+ */
+long check_node(const bpt_node_t *node, bool root, long min, long max,
+                int depth, int *leaf_depth) {
+  if (node->count > BPT_KEYS || (!root && node->count < BPT_MIN_KEYS))
+    return -1;
+  for (int i = 0; i < BPT_KEYS; i++) {
+    if (i >= node->count ? node->keys[i] != INT_MAX
+                         : node->keys[i] < min || node->keys[i] >= max ||
+                               (i > 0 && node->keys[i - 1] >= node->keys[i]))
+      return -1;
+  }
+  if (node->leaf) {
+    if (*leaf_depth == 0)
+      *leaf_depth = depth;
+    return depth == *leaf_depth ? node->count : -1;
+  }
+
+  long keys = 0;
+  for (int i = 0; i <= node->count; i++) {
+    long low = i > 0 ? node->keys[i - 1] : min;
+    long high = i < node->count ? node->keys[i] : max;
+    long child = check_node(node->children[i], false, low, high, depth + 1,
+                            leaf_depth);
+    if (child < 0)
+      return -1;
+    keys += child;
+  }
+  return keys;
+}
+
+bool check_tree(const bpt_tree_t *tree) {
+  int leaf_depth = 0;
+  if (tree->root == NULL)
+    return tree->count == 0 && tree->nodes == 0 && tree->height == 0;
+  return check_node(tree->root, true, INT_MIN, (long)INT_MAX + 1, 1,
+                    &leaf_depth) == (long)tree->count &&
+         leaf_depth == tree->height;
+}
+
+void test_sequential(void) {
+  bpt_tree_t tree;
+  bpt_init(&tree);
+  const int count = 100000;
+  for (int i = 0; i < count; i++)
+    bpt_insert(&tree, 2 * i, i);
+  bpt_insert(&tree, 0, -1);
+
+  bool found_all = true;
+  int value;
+  for (int i = 0; i < count; i++) {
+    found_all = found_all && bpt_search(&tree, 2 * i, &value) &&
+                value == (i == 0 ? -1 : i) &&
+                !bpt_search(&tree, 2 * i + 1, &value);
+  }
+  found_all = found_all && !bpt_search(&tree, -1, &value) &&
+              !bpt_search(&tree, INT_MAX, &value);
+  printf("100000 keys in %zu nodes, height %d\n", tree.nodes, tree.height);
+  check(found_all && tree.count == (size_t)count && tree.height <= 5 &&
+            check_tree(&tree),
+        "insert ascending keys");
+  bpt_dispose(&tree);
+}
+
+void test_iterator(void) {
+  bpt_tree_t tree;
+  bpt_init(&tree);
+  for (int i = 1000; i > 0; i--)
+    bpt_insert(&tree, i * 10, i);
+
+  bpt_iter_t iter;
+  int key, value, visited = 0, previous = INT_MIN;
+  bool sorted = true;
+  bpt_iter_begin(&iter, &tree, INT_MIN);
+  while (bpt_iter_next(&iter, &key, &value)) {
+    sorted = sorted && key > previous && value == key / 10;
+    previous = key;
+    visited++;
+  }
+
+  //a range starting between two keys
+  int range = 0;
+  bpt_iter_begin(&iter, &tree, 4995);
+  while (bpt_iter_next(&iter, &key, &value) && key <= 6000)
+    range += key == 5000 + 10 * range;
+  bpt_iter_begin(&iter, &tree, 10001);
+  bool past_end = !bpt_iter_next(&iter, &key, &value);
+  check(sorted && visited == 1000 && range == 101 && past_end,
+        "in-order and range iteration");
+  bpt_dispose(&tree);
+}
+
+void test_random_operations(void) {
+  bpt_tree_t tree;
+  bpt_init(&tree);
+  const int key_count = 20000;
+  int *reference = calloc(key_count, sizeof(int));
+  bool correct = reference != NULL;
+  unsigned seed = 1;
+
+  for (int step = 0; correct && step < 400000; step++) {
+    seed = seed * 1103515245 + 12345;
+    int key = (seed >> 8) % key_count;
+    //inserts win early, deletes later, so the tree grows and shrinks
+    if ((seed >> 4) % 8 < (step < 200000 ? 5 : 3)) {
+      bpt_insert(&tree, key, step + 1);
+      reference[key] = step + 1;
+    } else {
+      bpt_delete(&tree, key);
+      reference[key] = 0;
+    }
+    if (step % 20000 == 0)
+      correct = check_tree(&tree);
+  }
+
+  int value;
+  for (int key = 0; correct && key < key_count; key++) {
+    bool found = bpt_search(&tree, key, &value);
+    correct = found == (reference[key] != 0) &&
+              (!found || value == reference[key]);
+  }
+  correct = correct && check_tree(&tree);
+
+  //remove everything
+  for (int key = 0; key < key_count; key++)
+    bpt_delete(&tree, key);
+  check(correct && tree.root == NULL && check_tree(&tree),
+        "random inserts and deletes");
+  free(reference);
+  bpt_dispose(&tree);
+}
+
+void test_node_search(void) {
+  bpt_tree_t tree;
+  bpt_init(&tree);
+  for (int i = -5000; i < 5000; i++)
+    bpt_insert(&tree, i * 3, i);
+
+  //every key between and around the stored ones, negative keys included
+  bool correct = true;
+  for (int key = -15010; key < 15010; key++) {
+    int value = 0;
+    bool found = bpt_search(&tree, key, &value);
+    correct = correct &&
+              found == (key % 3 == 0 && key >= -15000 && key < 15000) &&
+              (!found || value == key / 3);
+  }
+#ifdef BPT_SCALAR
+  check(correct, "scalar node search finds exactly the stored keys");
+#else
+  check(correct, "node search finds exactly the stored keys");
+#endif
+  bpt_dispose(&tree);
+}
+
+int main() {
+  printf("B+ Tree - testing script\n");
+  printf("------------------------\n\n");
+
+  test_sequential();
+  test_iterator();
+  test_random_operations();
+  test_node_search();
+
+  printf("\nTESTS PASSED: %d, TESTS FAILED: %d\n", tests_passed, tests_failed);
+  return tests_failed == 0 ? 0 : 1;
+}
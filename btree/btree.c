@@ -20,4 +20,223 @@ void bst_add_node_to_items(bst_node_t* node, bst_items_t *items) {
   }
   items->nodes[items->size] = node;
   items->size++;
-}
\ No newline at end of file
+}
+
+/*
+ * Nejpravější uzel levého podstromu uzlu node, tedy jeho předchůdce
+ * v pořadí inorder. Pokud už ukazuje pravým ukazatelem zpět na node,
+ * vrátí se tento uzel.
+ */
+static bst_node_t *bst_morris_predecessor(bst_node_t *node) {
+  bst_node_t *predecessor = node->left;
+  while (predecessor->right != NULL && predecessor->right != node) {
+    predecessor = predecessor->right;
+  }
+  return predecessor;
+}
+
+/*
+ * Inorder průchod stromem bez zásobníku (Morris).
+ *
+ * Před sestupem do levého podstromu se pravý ukazatel jeho nejpravějšího
+ * uzlu dočasně nasměruje zpět na aktuální uzel, cesta nahoru je tak
+ * uložená přímo ve stromu. Při druhém příchodu do uzlu se ukazatel vrátí
+ * na NULL. Po skončení je strom stejný jako předtím a průchod potřebuje
+ * jen konstantní paměť, každá hrana se projde nejvýš třikrát.
+ *
+ * Strom se během průchodu mění, nesmí se proto současně procházet jinde.
+ */
+void bst_morris_inorder(bst_node_t *tree, bst_items_t *items) {
+  while (tree != NULL) {
+    if (tree->left == NULL) {
+      bst_add_node_to_items(tree, items);
+      tree = tree->right;
+      continue;
+    }
+    bst_node_t *predecessor = bst_morris_predecessor(tree);
+    if (predecessor->right == NULL) {
+      predecessor->right = tree;
+      tree = tree->left;
+    } else {
+      //the left subtree is done
+      predecessor->right = NULL;
+      bst_add_node_to_items(tree, items);
+      tree = tree->right;
+    }
+  }
+}
+
+/*
+ * Preorder průchod stromem bez zásobníku, stejně jako bst_morris_inorder
+ * se jen uzel zpracuje už při prvním příchodu.
+ */
+void bst_morris_preorder(bst_node_t *tree, bst_items_t *items) {
+  while (tree != NULL) {
+    if (tree->left == NULL) {
+      bst_add_node_to_items(tree, items);
+      tree = tree->right;
+      continue;
+    }
+    bst_node_t *predecessor = bst_morris_predecessor(tree);
+    if (predecessor->right == NULL) {
+      bst_add_node_to_items(tree, items);
+      predecessor->right = tree;
+      tree = tree->left;
+    } else {
+      predecessor->right = NULL;
+      tree = tree->right;
+    }
+  }
+}
+
+/*
+ * Otočení cesty po pravých ukazatelích z from do to. Vrací to.
+ */
+static bst_node_t *bst_morris_reverse(bst_node_t *from, bst_node_t *to) {
+  bst_node_t *previous = NULL, *node = from;
+  while (previous != to) {
+    bst_node_t *next = node->right;
+    node->right = previous;
+    previous = node;
+    node = next;
+  }
+  return to;
+}
+
+/*
+ * Postorder průchod stromem bez zásobníku.
+ *
+ * Nad kořenem je pomocný uzel, jehož levým podstromem je celý strom. Po
+ * dokončení levého podstromu uzlu se zpracuje pravá cesta od jeho levého
+ * potomka k předchůdci odzadu: cesta se otočí, projde a otočí zpět.
+ */
+void bst_morris_postorder(bst_node_t *tree, bst_items_t *items) {
+  bst_node_t head = {0};
+  head.left = tree;
+  bst_node_t *node = &head;
+
+  while (node != NULL) {
+    if (node->left == NULL) {
+      node = node->right;
+      continue;
+    }
+    bst_node_t *predecessor = bst_morris_predecessor(node);
+    if (predecessor->right == NULL) {
+      predecessor->right = node;
+      node = node->left;
+      continue;
+    }
+
+    //without the thread the reversed path ends with NULL
+    predecessor->right = NULL;
+    bst_morris_reverse(node->left, predecessor);
+    for (bst_node_t *visit = predecessor; visit != NULL;
+         visit = visit->right) {
+      bst_add_node_to_items(visit, items);
+    }
+    bst_morris_reverse(predecessor, node->left);
+    node = node->right;
+  }
+}
+
+/*
+ * Vložení uzlu na zásobník iterátoru. Pokud je zásobník plný, iterátor
+ * skončí.
+ */
+static void bst_iter_push(bst_iter_t *iter, bst_node_t *node) {
+  if (iter->top == BST_ITER_DEPTH) {
+    iter->overflow = true;
+    return;
+  }
+  iter->stack[iter->top++] = node;
+}
+
+/*
+ * Vložení uzlu a celé jeho levé cesty na zásobník.
+ */
+static void bst_iter_push_left(bst_iter_t *iter, bst_node_t *node) {
+  while (node != NULL && !iter->overflow) {
+    bst_iter_push(iter, node);
+    node = node->left;
+  }
+}
+
+/*
+ * Inicializace iterátoru přes strom tree v pořadí order.
+ *
+ * Iterátor nealokuje, ukládá jen cestu od kořene, a lze ho kdykoli
+ * přestat používat. Strom se během iterace nesmí měnit. Hlubší strom než
+ * BST_ITER_DEPTH iterátor nedokončí a nastaví overflow.
+ */
+void bst_iter_init(bst_iter_t *iter, bst_node_t *tree, bst_order_t order) {
+  iter->order = order;
+  iter->top = 0;
+  iter->overflow = false;
+  iter->last = NULL;
+  if (order == BST_PREORDER) {
+    if (tree != NULL) {
+      bst_iter_push(iter, tree);
+    }
+  } else {
+    bst_iter_push_left(iter, tree);
+  }
+}
+
+/*
+ * Inicializace iterátoru v pořadí inorder od prvního uzlu s klíčem
+ * větším nebo rovným key.
+ *
+ * Na zásobník přijdou jen uzly cesty z kořene, u kterých hledání key
+ * pokračuje doleva, tedy ty s klíčem aspoň key.
+ */
+void bst_iter_seek(bst_iter_t *iter, bst_node_t *tree, char key) {
+  bst_iter_init(iter, NULL, BST_INORDER);
+  while (tree != NULL && !iter->overflow) {
+    if (tree->key >= key) {
+      bst_iter_push(iter, tree);
+      tree = tree->left;
+    } else {
+      tree = tree->right;
+    }
+  }
+}
+
+/*
+ * Další uzel průchodu, NULL na konci.
+ */
+bst_node_t *bst_iter_next(bst_iter_t *iter) {
+  if (iter->overflow || iter->top == 0) {
+    return NULL;
+  }
+
+  bst_node_t *node;
+  switch (iter->order) {
+  case BST_PREORDER:
+    node = iter->stack[--iter->top];
+    if (node->right != NULL) {
+      bst_iter_push(iter, node->right);
+    }
+    if (node->left != NULL) {
+      bst_iter_push(iter, node->left);
+    }
+    break;
+  case BST_INORDER:
+    node = iter->stack[--iter->top];
+    bst_iter_push_left(iter, node->right);
+    break;
+  default:
+    //descend into right subtrees that are not done yet
+    node = iter->stack[iter->top - 1];
+    while (node->right != NULL && node->right != iter->last) {
+      bst_iter_push_left(iter, node->right);
+      if (iter->overflow) {
+        return NULL;
+      }
+      node = iter->stack[iter->top - 1];
+    }
+    iter->top--;
+    iter->last = node;
+    break;
+  }
+  return iter->overflow ? NULL : node;
+}
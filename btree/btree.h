@@ -7,21 +7,47 @@
 #define IAL_BTREE_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
 // Uzel stromu
 typedef struct bst_node {
   char key;               // klíč
+  signed char height;     // výška podstromu, udržují ji jen funkce bst_avl_*
+  bool red;               // barva uzlu v červeno-černém stromu (btree/rb)
   int value;              // hodnota
   struct bst_node *left;  // levý potomek
   struct bst_node *right; // pravý potomek
 } bst_node_t;
 
+// Výška a barva leží ve výplni za klíčem, uzel se jimi nezvětší
+_Static_assert(sizeof(bst_node_t) ==
+                   2 * sizeof(int) + 2 * sizeof(struct bst_node *),
+               "bst_node_t must keep height and red in the key padding");
+
 void bst_init(bst_node_t **tree);
 void bst_insert(bst_node_t **tree, char key, int value);
 bool bst_search(bst_node_t *tree, char key, int *value);
 void bst_delete(bst_node_t **tree, char key);
 void bst_dispose(bst_node_t **tree);
 
+// Blok uzlů zásoby, definovaný v pool.c
+struct bst_pool_slab;
+
+// Zásoba uzlů jednoho stromu, uzly se alokují po blocích
+typedef struct bst_pool {
+  struct bst_pool_slab *slabs; // bloky uzlů, naposledy alokovaný první
+  int used;                    // obsazené uzly posledního bloku
+  int capacity;                // kapacita posledního bloku v počtu uzlů
+  bst_node_t *free;            // uvolněné uzly spojené přes left
+} bst_pool_t;
+
+void bst_pool_init(bst_pool_t *pool);
+bst_node_t *bst_pool_alloc(bst_pool_t *pool);
+void bst_pool_free(bst_pool_t *pool, bst_node_t *node);
+void bst_pool_insert(bst_pool_t *pool, bst_node_t **tree, char key, int value);
+void bst_pool_delete(bst_pool_t *pool, bst_node_t **tree, char key);
+void bst_pool_dispose(bst_pool_t *pool, bst_node_t **tree);
+
 // Pole uzlu
 typedef struct bst_items {
   bst_node_t **nodes;     // pole uzlu
@@ -35,11 +61,87 @@ void bst_preorder(bst_node_t *tree, bst_items_t *items);
 void bst_inorder(bst_node_t *tree, bst_items_t *items);
 void bst_postorder(bst_node_t *tree, bst_items_t *items);
 
+// Průchody bez zásobníku, strom během průchodu dočasně mění (Morris)
+void bst_morris_preorder(bst_node_t *tree, bst_items_t *items);
+void bst_morris_inorder(bst_node_t *tree, bst_items_t *items);
+void bst_morris_postorder(bst_node_t *tree, bst_items_t *items);
+
+// Hloubka zásobníku iterátoru, strom s různými klíči char má nejvýš 256 uzlů
+#define BST_ITER_DEPTH 256
+
+// Pořadí průchodu iterátoru
+typedef enum bst_order {
+  BST_PREORDER,
+  BST_INORDER,
+  BST_POSTORDER
+} bst_order_t;
+
+// Iterátor vracející uzly po jednom, zásobník je součástí struktury
+typedef struct bst_iter {
+  bst_order_t order;                 // pořadí průchodu
+  int top;                           // počet uzlů na zásobníku
+  bool overflow;                     // strom je hlubší než BST_ITER_DEPTH
+  bst_node_t *last;                  // naposledy vrácený uzel (postorder)
+  bst_node_t *stack[BST_ITER_DEPTH]; // předci dalšího uzlu
+} bst_iter_t;
+
+void bst_iter_init(bst_iter_t *iter, bst_node_t *tree, bst_order_t order);
+void bst_iter_seek(bst_iter_t *iter, bst_node_t *tree, char key);
+bst_node_t *bst_iter_next(bst_iter_t *iter);
+
+// Varianta rb (-DRB) nejpravější uzel hledá přímo v bst_delete
+#ifndef RB
 void bst_replace_by_rightmost(bst_node_t *target, bst_node_t **tree);
+#endif // RB
 
 void bst_print_node(bst_node_t *node);
 
+// AVL strom (avl.c), jen pro stromy měněné výhradně těmito funkcemi
+void bst_avl_insert(bst_node_t **tree, char key, int value);
+void bst_avl_delete(bst_node_t **tree, char key);
+
 void bst_balance(bst_node_t **tree);
+
+// Zmrazený strom pro vyhledávání beze změn, pořadí Eytzingerové (BFS)
+typedef struct bst_frozen {
+  int size;    // počet klíčů
+  char *keys;  // klíče keys[1] až keys[size], potomci i jsou 2 i a 2 i + 1
+  int *values; // hodnoty ve stejném bloku paměti za klíči
+} bst_frozen_t;
+
+bool bst_freeze(bst_node_t *tree, bst_frozen_t *frozen);
+bool bst_frozen_search(const bst_frozen_t *frozen, char key, int *value);
+void bst_frozen_dispose(bst_frozen_t *frozen);
+
+// Pořadí uzlů v poli bst_packed_t
+typedef enum bst_layout {
+  BST_LAYOUT_BFS, // po úrovních jako u bst_freeze
+  BST_LAYOUT_VEB  // rekurzivně po podstromech (van Emde Boas)
+} bst_layout_t;
+
+// Uzel v souvislém poli, potomci jsou indexy do pole, -1 pro žádného
+typedef struct bst_packed_node {
+  int key;   // klíč
+  int value; // hodnota
+  int left;  // index levého potomka
+  int right; // index pravého potomka
+} bst_packed_node_t;
+
+// Vyvážený strom v souvislém poli uzlů, kořen má index 0
+typedef struct bst_packed {
+  bst_packed_node_t *nodes; // pole uzlů
+  int size;                 // počet uzlů
+  void *mapping;            // namapovaný soubor, NULL pro pole na haldě
+  size_t mapping_size;      // délka namapovaného souboru
+} bst_packed_t;
+
+bool bst_pack(bst_node_t *tree, bst_layout_t layout, bst_packed_t *packed);
+bool bst_pack_sorted(const int *keys, const int *values, int count,
+                     bst_layout_t layout, bst_packed_t *packed);
+bool bst_packed_search(const bst_packed_t *packed, int key, int *value);
+bool bst_packed_save(const bst_packed_t *packed, const char *path);
+bool bst_packed_map(bst_packed_t *packed, const char *path);
+void bst_packed_dispose(bst_packed_t *packed);
 void letter_count(bst_node_t **letter_frequency_tree, char *input);
 
 #endif
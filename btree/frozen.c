@@ -0,0 +1,117 @@
+/*
+ * Zmrazený vyhledávací strom v pořadí Eytzingerové
+ *
+ * Klíče ze stromu se uloží do jednoho pole v pořadí průchodu do šířky
+ * vyváženého stromu: kořen je na indexu 1 a potomci indexu i jsou na
+ * indexech 2 i a 2 i + 1. Pole nepotřebuje ukazatele a horní úrovně
+ * stromu jsou na začátku pole, takže sdílejí několik řádků cache.
+ *
+ * Vyhledání v každém kroku jen přičte výsledek porovnání k indexu, bez
+ * podmíněného skoku podle klíče. Klíč je jeden bajt a pole klíčů začíná na
+ * hranici 64 bajtů, všech 64 potomků uzlu i o šest úrovní níž (indexy
+ * 64 i až 64 i + 63) tak leží v jednom řádku cache a lze je načíst
+ * dopředu. Po průchodu na konec pole ukazují horní bity indexu na
+ * poslední uzel, kde hledání odbočilo doleva, tedy na nejmenší klíč,
+ * který není menší než hledaný.
+ */
+
+#include "btree.h"
+#include <stdlib.h>
+
+// Počet úrovní, o které se načítají klíče dopředu; 2^6 klíčů je 64 bajtů
+#define BST_FROZEN_PREFETCH 6
+
+// Řádek cache, na jehož hranici začíná pole klíčů
+#define BST_FROZEN_LINE 64
+
+/*
+ * Vyplnění podstromu s kořenem k z uzlů items->nodes od indexu next
+ * v pořadí inorder. Vrací index dalšího nepoužitého uzlu.
+ */
+static int bst_frozen_fill(bst_frozen_t *frozen, bst_items_t *items,
+                           int next, int k) {
+  if (k > frozen->size) {
+    return next;
+  }
+  next = bst_frozen_fill(frozen, items, next, 2 * k);
+  frozen->keys[k] = items->nodes[next]->key;
+  frozen->values[k] = items->nodes[next]->value;
+  return bst_frozen_fill(frozen, items, next + 1, 2 * k + 1);
+}
+
+/*
+ * Zmrazení stromu do pole v pořadí Eytzingerové.
+ *
+ * Uzly se seřadí průchodem inorder jako v bst_balance, strom zůstane beze
+ * změny. Klíče i hodnoty jsou v jednom bloku paměti zarovnaném na řádek
+ * cache, který uvolní bst_frozen_dispose. Vrací false, pokud se nepodaří
+ * alokovat paměť.
+ */
+bool bst_freeze(bst_node_t *tree, bst_frozen_t *frozen) {
+  bst_items_t items = {NULL, 0, 0};
+  bst_inorder(tree, &items);
+
+  //keys first on a line boundary, values after them from the next line
+  int size = items.size;
+  size_t keys_bytes =
+      ((size_t)size + BST_FROZEN_LINE) & ~(size_t)(BST_FROZEN_LINE - 1);
+  size_t values_bytes = (size + 1) * sizeof(int);
+  size_t bytes = (keys_bytes + values_bytes + BST_FROZEN_LINE - 1) &
+                 ~(size_t)(BST_FROZEN_LINE - 1);
+  char *block = aligned_alloc(BST_FROZEN_LINE, bytes);
+  if (block == NULL) {
+    free(items.nodes);
+    return false;
+  }
+  frozen->size = size;
+  frozen->keys = block;
+  frozen->values = (int *)(block + keys_bytes);
+  bst_frozen_fill(frozen, &items, 0, 1);
+  free(items.nodes);
+  return true;
+}
+
+/*
+ * Vyhledání klíče ve zmrazeném stromu.
+ *
+ * V případě úspěchu vrátí funkce hodnotu true a do proměnné value zapíše
+ * hodnotu klíče. V opačném případě vrátí false a value zůstane nezměněná.
+ */
+bool bst_frozen_search(const bst_frozen_t *frozen, char key, int *value) {
+  unsigned long i = 1;
+  unsigned long size = frozen->size;
+
+  while (i <= size) {
+#ifdef __GNUC__
+    if (i << BST_FROZEN_PREFETCH <= size) {
+      __builtin_prefetch(frozen->keys + (i << BST_FROZEN_PREFETCH));
+    }
+#endif
+    i = 2 * i + (frozen->keys[i] < key);
+  }
+
+  //drop the right turns taken after the last left turn, and that one too
+#ifdef __GNUC__
+  i >>= __builtin_ffsl(~i);
+#else
+  while (i & 1) {
+    i >>= 1;
+  }
+  i >>= 1;
+#endif
+  if (i == 0 || frozen->keys[i] != key) {
+    return false;
+  }
+  *value = frozen->values[i];
+  return true;
+}
+
+/*
+ * Uvolnění zmrazeného stromu, strom pak bude prázdný.
+ */
+void bst_frozen_dispose(bst_frozen_t *frozen) {
+  free(frozen->keys);
+  frozen->size = 0;
+  frozen->keys = NULL;
+  frozen->values = NULL;
+}
@@ -0,0 +1,153 @@
+/*
+ * Měření stromu s uzly v poli proti stromu z uzlů bst_node_t.
+ *
+ * Oba stromy vznikají vkládáním stejných klíčů ve stejném pořadí, mají
+ * proto stejný tvar a liší se jen velikostí a umístěním uzlů. Stromy se
+ * staví střídavě, uzly jednoho stromu bst_node_t tak neleží vedle sebe.
+ *
+ * Spuštění: ./bench [název měření ...], bez argumentů spustí všechna.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../btree.h"
+#include "idx.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Počet stromů, klíčů v každém stromu a vyhledání
+#define TREE_COUNT 16384
+#define KEY_COUNT 127
+#define QUERY_COUNT 4000000
+
+static double now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static unsigned long long bench_rand(unsigned long long *state) {
+  //xorshift64*
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return *state * 2685821657736338717ULL;
+}
+
+/*
+ * Vložení KEY_COUNT náhodně seřazených klíčů do TREE_COUNT stromů obou
+ * druhů a vyhledání náhodných klíčů v náhodných stromech.
+ */
+static void bench_search(void) {
+  bst_node_t **trees = malloc(TREE_COUNT * sizeof(bst_node_t *));
+  bst_idx_tree_t *idx_trees = malloc(TREE_COUNT * sizeof(bst_idx_tree_t));
+  if (trees == NULL || idx_trees == NULL) {
+    free(trees);
+    free(idx_trees);
+    return;
+  }
+  unsigned long long seed = 42;
+  char keys[KEY_COUNT];
+  for (int i = 0; i < KEY_COUNT; i++) {
+    keys[i] = (char)(i + 1);
+  }
+  for (int i = KEY_COUNT - 1; i > 0; i--) {
+    int j = bench_rand(&seed) % (i + 1);
+    char tmp = keys[i];
+    keys[i] = keys[j];
+    keys[j] = tmp;
+  }
+
+  double start = now_sec();
+  for (int t = 0; t < TREE_COUNT; t++) {
+    bst_init(&trees[t]);
+  }
+  for (int i = 0; i < KEY_COUNT; i++) {
+    for (int t = 0; t < TREE_COUNT; t++) {
+      bst_insert(&trees[t], keys[i], i);
+    }
+  }
+  double tree_insert = now_sec() - start;
+  start = now_sec();
+  for (int t = 0; t < TREE_COUNT; t++) {
+    bst_idx_init(&idx_trees[t]);
+  }
+  for (int i = 0; i < KEY_COUNT; i++) {
+    for (int t = 0; t < TREE_COUNT; t++) {
+      bst_idx_insert(&idx_trees[t], keys[i], i);
+    }
+  }
+  double idx_insert = now_sec() - start;
+
+  long long found[2] = {0, 0};
+  int value;
+  unsigned long long query_seed = 7;
+  start = now_sec();
+  for (int i = 0; i < QUERY_COUNT; i++) {
+    unsigned long long r = bench_rand(&query_seed);
+    found[0] += bst_search(trees[r % TREE_COUNT],
+                           (char)((r >> 32) % KEY_COUNT + 1), &value);
+  }
+  double tree_search = now_sec() - start;
+  query_seed = 7;
+  start = now_sec();
+  for (int i = 0; i < QUERY_COUNT; i++) {
+    unsigned long long r = bench_rand(&query_seed);
+    found[1] += bst_idx_search(&idx_trees[r % TREE_COUNT],
+                               (char)((r >> 32) % KEY_COUNT + 1), &value);
+  }
+  double idx_search = now_sec() - start;
+
+  //arrays first, freed after the nodes each one merges with the free
+  //memory around it and the dispose is a hundred times slower
+  double idx_bytes = (double)idx_trees[0].capacity * sizeof(bst_idx_node_t);
+  start = now_sec();
+  for (int t = 0; t < TREE_COUNT; t++) {
+    bst_idx_dispose(&idx_trees[t]);
+  }
+  double idx_dispose = now_sec() - start;
+  start = now_sec();
+  for (int t = 0; t < TREE_COUNT; t++) {
+    bst_dispose(&trees[t]);
+  }
+  double tree_dispose = now_sec() - start;
+
+  double nodes = (double)TREE_COUNT * KEY_COUNT;
+  printf("%d trees of %d keys\n", TREE_COUNT, KEY_COUNT);
+  printf("  bst_node_t %5.1f B/key  insert %6.1f ns  search %6.1f ns  "
+         "dispose %6.1f ns/key\n",
+         (double)sizeof(bst_node_t), tree_insert / nodes * 1e9,
+         tree_search / QUERY_COUNT * 1e9, tree_dispose / nodes * 1e9);
+  printf("  index      %5.1f B/key  insert %6.1f ns  search %6.1f ns  "
+         "dispose %6.1f ns/key%s\n",
+         idx_bytes / KEY_COUNT, idx_insert / nodes * 1e9,
+         idx_search / QUERY_COUNT * 1e9, idx_dispose / nodes * 1e9,
+         found[0] == QUERY_COUNT && found[1] == QUERY_COUNT ? ""
+                                                            : "  MISSING");
+  free(trees);
+  free(idx_trees);
+}
+
+static const struct {
+  const char *name;
+  void (*run)(void);
+} BENCHES[] = {
+    {"search", bench_search},
+};
+
+int main(int argc, char *argv[]) {
+  int count = sizeof(BENCHES) / sizeof(BENCHES[0]);
+
+  for (int i = 0; i < count; i++) {
+    bool selected = argc == 1;
+    for (int j = 1; j < argc; j++) {
+      selected = selected || strcmp(argv[j], BENCHES[i].name) == 0;
+    }
+    if (selected) {
+      BENCHES[i].run();
+    }
+  }
+  return 0;
+}
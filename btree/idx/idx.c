@@ -0,0 +1,228 @@
+/*
+ * Binární vyhledávací strom s uzly v poli
+ *
+ * Strom se chová stejně jako iterativní varianta bst_node_t: vkládá nové
+ * listy a odstraněný uzel se dvěma podstromy nahradí nejpravějším uzlem
+ * levého podstromu. Místo funkcí malloc a free pro každý uzel se uzly
+ * berou z pole, které se při zaplnění zvětší na dvojnásobek. Odstraněné
+ * uzly se řadí do seznamu a další vkládání je použije znovu, pole se
+ * nezmenšuje. Zrušení stromu uvolní jen pole.
+ *
+ * Index pravého potomka sdílí 32 bitů s klíčem. Vzhledem k tomu, že klíč
+ * je char a strom má nejvýš 256 uzlů, omezení na BST_IDX_MAX_NODES
+ * prakticky nevadí.
+ */
+
+#include "idx.h"
+#include <stdlib.h>
+#include <string.h>
+
+_Static_assert(sizeof(bst_idx_node_t) == 12, "bst_idx_node_t is 12 bytes");
+
+// Počáteční kapacita pole v počtu uzlů
+#define BST_IDX_FIRST_CAPACITY 16
+
+static char bst_idx_key(const bst_idx_node_t *node) {
+  return (char)node->key;
+}
+
+/*
+ * Potomek uzlu ve směru dir, false je levý a true pravý.
+ */
+static uint32_t bst_idx_child(const bst_idx_node_t *node, bool dir) {
+  return dir ? node->right : node->left;
+}
+
+/*
+ * Nastavení potomka uzlu parent ve směru dir, pro parent 0 kořene.
+ */
+static void bst_idx_link(bst_idx_tree_t *tree, uint32_t parent, bool dir,
+                         uint32_t child) {
+  if (parent == 0) {
+    tree->root = child;
+  } else if (dir) {
+    tree->nodes[parent].right = child;
+  } else {
+    tree->nodes[parent].left = child;
+  }
+}
+
+/*
+ * Index nového uzlu, ze seznamu uvolněných nebo z konce pole. Vrací 0,
+ * pokud se nepodaří pole zvětšit.
+ */
+static uint32_t bst_idx_alloc(bst_idx_tree_t *tree) {
+  if (tree->free != 0) {
+    uint32_t index = tree->free;
+    tree->free = tree->nodes[index].left;
+    return index;
+  }
+
+  if (tree->size == tree->capacity) {
+    uint32_t capacity =
+        tree->capacity == 0 ? BST_IDX_FIRST_CAPACITY : tree->capacity * 2;
+    if (capacity > BST_IDX_MAX_NODES) {
+      capacity = BST_IDX_MAX_NODES;
+    }
+    if (capacity == tree->capacity) {
+      return 0;
+    }
+    bst_idx_node_t *nodes =
+        realloc(tree->nodes, capacity * sizeof(bst_idx_node_t));
+    if (nodes == NULL) {
+      return 0;
+    }
+    tree->nodes = nodes;
+    tree->capacity = capacity;
+    if (tree->size == 0) {
+      //index 0 stands for no node
+      tree->size = 1;
+    }
+  }
+  return tree->size++;
+}
+
+static void bst_idx_free(bst_idx_tree_t *tree, uint32_t index) {
+  tree->nodes[index].left = tree->free;
+  tree->free = index;
+}
+
+/*
+ * Inicializace prázdného stromu.
+ */
+void bst_idx_init(bst_idx_tree_t *tree) {
+  tree->nodes = NULL;
+  tree->root = 0;
+  tree->size = 0;
+  tree->capacity = 0;
+  tree->free = 0;
+}
+
+/*
+ * Vložení uzlu do stromu.
+ *
+ * Pokud uzel se zadaným klíčem už ve stromu existuje, nahradí se jeho
+ * hodnota. Jinak se vloží nový list. Pokud se nepodaří zvětšit pole,
+ * strom zůstane beze změny.
+ */
+void bst_idx_insert(bst_idx_tree_t *tree, char key, int value) {
+  uint32_t parent = 0, node = tree->root;
+  bool dir = false;
+
+  while (node != 0) {
+    bst_idx_node_t *current = &tree->nodes[node];
+    if (key == bst_idx_key(current)) {
+      current->value = value;
+      return;
+    }
+    parent = node;
+    dir = key > bst_idx_key(current);
+    node = bst_idx_child(current, dir);
+  }
+
+  //the array may move, so only indices are kept across the allocation
+  uint32_t index = bst_idx_alloc(tree);
+  if (index == 0) {
+    return;
+  }
+  bst_idx_node_t *leaf = &tree->nodes[index];
+  leaf->key = (unsigned char)key;
+  leaf->value = value;
+  leaf->left = 0;
+  leaf->right = 0;
+  bst_idx_link(tree, parent, dir, index);
+}
+
+/*
+ * Vyhledání uzlu ve stromu.
+ *
+ * V případě úspěchu vrátí funkce hodnotu true a do proměnné value zapíše
+ * hodnotu daného uzlu. Pole uzlů může být i jen pro čtení.
+ */
+bool bst_idx_search(const bst_idx_tree_t *tree, char key, int *value) {
+  uint32_t node = tree->root;
+  while (node != 0) {
+    const bst_idx_node_t *current = &tree->nodes[node];
+    if (key == bst_idx_key(current)) {
+      *value = current->value;
+      return true;
+    }
+    node = bst_idx_child(current, key > bst_idx_key(current));
+  }
+  return false;
+}
+
+/*
+ * Odstranění uzlu ze stromu.
+ *
+ * Pokud uzel se zadaným klíčem neexistuje, funkce nic nedělá. Pokud má
+ * odstraněný uzel oba podstromy, je nahrazený nejpravějším uzlem levého
+ * podstromu.
+ */
+void bst_idx_delete(bst_idx_tree_t *tree, char key) {
+  uint32_t parent = 0, node = tree->root;
+  bool dir = false;
+
+  while (node != 0 && key != bst_idx_key(&tree->nodes[node])) {
+    parent = node;
+    dir = key > bst_idx_key(&tree->nodes[node]);
+    node = bst_idx_child(&tree->nodes[node], dir);
+  }
+  if (node == 0) {
+    return;
+  }
+
+  bst_idx_node_t *target = &tree->nodes[node];
+  if (target->left != 0 && target->right != 0) {
+    //the rightmost node of the left subtree takes the place of the target
+    uint32_t rightmost_parent = node, rightmost = target->left;
+    bool rightmost_dir = false;
+    while (tree->nodes[rightmost].right != 0) {
+      rightmost_parent = rightmost;
+      rightmost_dir = true;
+      rightmost = tree->nodes[rightmost].right;
+    }
+    target->key = tree->nodes[rightmost].key;
+    target->value = tree->nodes[rightmost].value;
+    bst_idx_link(tree, rightmost_parent, rightmost_dir,
+                 tree->nodes[rightmost].left);
+    bst_idx_free(tree, rightmost);
+  } else {
+    bst_idx_link(tree, parent, dir,
+                 target->left != 0 ? target->left : target->right);
+    bst_idx_free(tree, node);
+  }
+}
+
+/*
+ * Zrušení celého stromu.
+ *
+ * Po zrušení bude strom ve stejném stavu jako po inicializaci. Uvolní se
+ * jen pole, uzly se neprocházejí.
+ */
+void bst_idx_dispose(bst_idx_tree_t *tree) {
+  free(tree->nodes);
+  bst_idx_init(tree);
+}
+
+/*
+ * Kopie stromu do nově alokovaného pole jedním voláním memcpy.
+ *
+ * Vrací false, pokud se nepodaří alokovat paměť.
+ */
+bool bst_idx_copy(const bst_idx_tree_t *tree, bst_idx_tree_t *copy) {
+  bst_idx_init(copy);
+  if (tree->size == 0) {
+    return true;
+  }
+  copy->nodes = malloc(tree->size * sizeof(bst_idx_node_t));
+  if (copy->nodes == NULL) {
+    return false;
+  }
+  memcpy(copy->nodes, tree->nodes, tree->size * sizeof(bst_idx_node_t));
+  copy->root = tree->root;
+  copy->size = tree->size;
+  copy->capacity = tree->size;
+  copy->free = tree->free;
+  return true;
+}
@@ -0,0 +1,45 @@
+/*
+ * Hlavičkový soubor pro binární vyhledávací strom s uzly v poli.
+ *
+ * Uzly jednoho stromu leží v jednom souvislém poli a místo ukazatelů na
+ * potomky obsahují jejich indexy do pole. Uzel tak má 12 bajtů místo 24
+ * u bst_node_t a do řádku cache se vejde víc než dvakrát víc uzlů.
+ *
+ * Pole neobsahuje žádné ukazatele, lze ho proto zkopírovat funkcí memcpy
+ * nebo uložit do souboru a namapovat zpět na jinou adresu beze změny.
+ */
+
+#ifndef IAL_BTREE_IDX_H
+#define IAL_BTREE_IDX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Největší počet uzlů v poli, index pravého potomka má jen 24 bitů
+#define BST_IDX_MAX_NODES (1u << 24)
+
+// Uzel stromu, index 0 znamená žádného potomka
+typedef struct bst_idx_node {
+  int value;           // hodnota
+  uint32_t left;       // index levého potomka
+  unsigned right : 24; // index pravého potomka
+  unsigned key : 8;    // klíč jako unsigned char
+} bst_idx_node_t;
+
+// Strom s uzly v souvislém poli
+typedef struct bst_idx_tree {
+  bst_idx_node_t *nodes; // pole uzlů, nodes[0] se nepoužívá
+  uint32_t root;         // index kořene, 0 pro prázdný strom
+  uint32_t size;         // použitá část pole včetně nodes[0]
+  uint32_t capacity;     // kapacita pole v počtu uzlů
+  uint32_t free;         // uvolněné uzly spojené přes left
+} bst_idx_tree_t;
+
+void bst_idx_init(bst_idx_tree_t *tree);
+void bst_idx_insert(bst_idx_tree_t *tree, char key, int value);
+bool bst_idx_search(const bst_idx_tree_t *tree, char key, int *value);
+void bst_idx_delete(bst_idx_tree_t *tree, char key);
+void bst_idx_dispose(bst_idx_tree_t *tree);
+bool bst_idx_copy(const bst_idx_tree_t *tree, bst_idx_tree_t *copy);
+
+#endif
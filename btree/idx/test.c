@@ -0,0 +1,167 @@
+#include "idx.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int tests_passed = 0;
+int tests_failed = 0;
+
+void check(bool passed, const char *name) {
+  if (passed) {
+    printf("\033[1;32m[%s] [TEST PASSED ✓]\033[0m\n", name);
+    tests_passed++;
+  } else {
+    printf("\033[1;31m[%s] [TEST FAILED ☓]\033[0m\n", name);
+    tests_failed++;
+  }
+}
+
+/*
+ * Kontrola podstromu: klíče v mezích (min, max) a každý index v poli nejvýš
+ * jednou. Vrací počet uzlů, nebo -1, pokud podmínky nesplňuje.
+ */
+int check_node(const bst_idx_tree_t *tree, uint32_t node, int min, int max,
+               bool *used) {
+  if (node == 0)
+    return 0;
+  if (node >= tree->size || used[node])
+    return -1;
+  used[node] = true;
+  int key = (char)tree->nodes[node].key;
+  if (key <= min || key >= max)
+    return -1;
+  int left = check_node(tree, tree->nodes[node].left, min, key, used);
+  int right = check_node(tree, tree->nodes[node].right, key, max, used);
+  return left < 0 || right < 0 ? -1 : left + right + 1;
+}
+
+/*
+ * Vrací počet klíčů, nebo -1, pokud strom není vyhledávací nebo uzly
+ * stromu a uvolněné uzly nepokrývají celé použité pole.
+ */
+int check_tree(const bst_idx_tree_t *tree) {
+  bool *used = calloc(tree->size + 1, sizeof(bool));
+  if (used == NULL)
+    return -1;
+  int count = check_node(tree, tree->root, -129, 128, used);
+  int free_count = 0;
+  for (uint32_t i = tree->free; count >= 0 && i != 0; i = tree->nodes[i].left) {
+    if (i >= tree->size || used[i])
+      count = -1;
+    else
+      used[i] = true;
+    free_count++;
+  }
+  if (count >= 0 && tree->size > 0 &&
+      (uint32_t)(count + free_count) != tree->size - 1)
+    count = -1;
+  free(used);
+  return count;
+}
+
+void test_insert_search(void) {
+  const char keys[] = "HDLBFJNACEGIKMO";
+  bst_idx_tree_t tree;
+  bst_idx_init(&tree);
+  for (int i = 0; keys[i] != '\0'; i++)
+    bst_idx_insert(&tree, keys[i], i);
+  bst_idx_insert(&tree, 'H', 100);
+
+  bool found_all = true;
+  int value;
+  for (int i = 1; keys[i] != '\0'; i++)
+    found_all = found_all && bst_idx_search(&tree, keys[i], &value) &&
+                value == i;
+  found_all = found_all && bst_idx_search(&tree, 'H', &value) &&
+              value == 100 && !bst_idx_search(&tree, 'Z', &value);
+  //same shape as bst_insert: H is the root, D and L its children
+  const bst_idx_node_t *root = &tree.nodes[tree.root];
+  check(sizeof(bst_idx_node_t) == 12 && found_all && check_tree(&tree) == 15 &&
+            root->key == 'H' && tree.nodes[root->left].key == 'D' &&
+            tree.nodes[root->right].key == 'L',
+        "12 byte nodes, insert and search");
+  bst_idx_dispose(&tree);
+}
+
+void test_random_operations(void) {
+  bst_idx_tree_t tree;
+  bst_idx_init(&tree);
+  int reference[256] = {0};
+  bool correct = true;
+  unsigned seed = 1;
+
+  for (int step = 0; correct && step < 100000; step++) {
+    seed = seed * 1103515245 + 12345;
+    char key = (char)(seed >> 16);
+    if ((seed >> 4) % 8 < (step < 50000 ? 5 : 3)) {
+      bst_idx_insert(&tree, key, step + 1);
+      reference[(unsigned char)key] = step + 1;
+    } else {
+      bst_idx_delete(&tree, key);
+      reference[(unsigned char)key] = 0;
+    }
+    if (step % 1000 == 0)
+      correct = check_tree(&tree) >= 0;
+  }
+
+  int value, count = 0;
+  for (int key = -128; correct && key < 128; key++) {
+    bool found = bst_idx_search(&tree, (char)key, &value);
+    int expected = reference[(unsigned char)key];
+    correct = found == (expected != 0) && (!found || value == expected);
+    count += found;
+  }
+  //deleted nodes are reused, the array never outgrows all 256 keys
+  correct = correct && check_tree(&tree) == count && tree.size <= 257;
+  for (int key = -128; key < 128; key++)
+    bst_idx_delete(&tree, (char)key);
+  check(correct && tree.root == 0 && check_tree(&tree) == 0,
+        "random inserts and deletes");
+  bst_idx_dispose(&tree);
+}
+
+void test_relocation(void) {
+  bst_idx_tree_t tree, copy, moved;
+  bst_idx_init(&tree);
+  for (int i = 0; i < 200; i++)
+    bst_idx_insert(&tree, (char)(i * 37), i);
+  for (int i = 0; i < 200; i += 3)
+    bst_idx_delete(&tree, (char)(i * 37));
+  bool copied = bst_idx_copy(&tree, &copy);
+
+  //a raw byte copy at another address is the same tree too
+  moved = tree;
+  moved.nodes = malloc(tree.size * sizeof(bst_idx_node_t));
+  if (moved.nodes != NULL)
+    memcpy(moved.nodes, tree.nodes, tree.size * sizeof(bst_idx_node_t));
+  bst_idx_dispose(&tree);
+
+  bool same = copied && moved.nodes != NULL;
+  for (int i = 0; same && i < 200; i++) {
+    int copy_value = -1, moved_value = -1;
+    bool copy_found = bst_idx_search(&copy, (char)(i * 37), &copy_value);
+    bool moved_found = bst_idx_search(&moved, (char)(i * 37), &moved_value);
+    same = copy_found == (i % 3 != 0) && moved_found == copy_found &&
+           (!copy_found || (copy_value == i && moved_value == i));
+  }
+  //the copy can still grow
+  bst_idx_insert(&copy, 0, -1);
+  int value;
+  check(same && bst_idx_search(&copy, 0, &value) && value == -1 &&
+            check_tree(&copy) >= 0,
+        "tree copied with memcpy");
+  bst_idx_dispose(&copy);
+  free(moved.nodes);
+}
+
+int main() {
+  printf("Index Tree - testing script\n");
+  printf("---------------------------\n\n");
+
+  test_insert_search();
+  test_random_operations();
+  test_relocation();
+
+  printf("\nTESTS PASSED: %d, TESTS FAILED: %d\n", tests_passed, tests_failed);
+  return tests_failed == 0 ? 0 : 1;
+}
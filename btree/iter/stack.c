@@ -4,27 +4,53 @@
  */
 #include "stack.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 /*
  * Makro generující implementaci funkcí pracujících se zásobníky.
  * Podrobnější popis zásobníků v stack.h.
+ *
+ * Položky jsou v poli items, dokud se do něj vejdou, pak v poli heap.
+ * Pole heap se uvolní, jakmile se zásobník vyprázdní, průchody, které
+ * skončí s prázdným zásobníkem, ho proto nemusí uvolňovat. Zásobník
+ * přesunutý na haldu nelze kopírovat, kopie by sdílely pole heap. Pokud
+ * se nepodaří zvětšit pole heap, položka se zahodí jako dříve při
+ * přetečení.
  */
 #define STACKDEF(T, TNAME)                                                     \
-  void stack_##TNAME##_init(stack_##TNAME##_t *stack) { stack->top = -1; }     \
+  static T *stack_##TNAME##_items(stack_##TNAME##_t *stack) {                  \
+    return stack->heap != NULL ? stack->heap : stack->items;                   \
+  }                                                                            \
+                                                                               \
+  void stack_##TNAME##_init(stack_##TNAME##_t *stack) {                        \
+    stack->heap = NULL;                                                        \
+    stack->capacity = MAXSTACK;                                                \
+    stack->top = -1;                                                           \
+  }                                                                            \
                                                                                \
   void stack_##TNAME##_push(stack_##TNAME##_t *stack, T item) {                \
-    if (stack->top == MAXSTACK - 1) {                                          \
-      printf("[W] Stack overflow\n");                                          \
-    } else {                                                                   \
-      stack->items[++stack->top] = item;                                       \
+    if (stack->top == stack->capacity - 1) {                                   \
+      /*spill to the heap, the capacity doubles*/                              \
+      T *heap = realloc(stack->heap, 2 * stack->capacity * sizeof(T));         \
+      if (heap == NULL) {                                                      \
+        printf("[W] Stack overflow\n");                                        \
+        return;                                                                \
+      }                                                                        \
+      if (stack->heap == NULL) {                                               \
+        memcpy(heap, stack->items, sizeof(stack->items));                      \
+      }                                                                        \
+      stack->heap = heap;                                                      \
+      stack->capacity *= 2;                                                    \
     }                                                                          \
+    stack_##TNAME##_items(stack)[++stack->top] = item;                         \
   }                                                                            \
                                                                                \
   T stack_##TNAME##_top(stack_##TNAME##_t *stack) {                            \
     if (stack->top == -1) {                                                    \
       return NULL;                                                             \
     }                                                                          \
-    return stack->items[stack->top];                                           \
+    return stack_##TNAME##_items(stack)[stack->top];                           \
   }                                                                            \
                                                                                \
   T stack_##TNAME##_pop(stack_##TNAME##_t *stack) {                            \
@@ -32,7 +58,12 @@
       printf("[W] Stack underflow\n");                                         \
       return NULL;                                                             \
     }                                                                          \
-    return stack->items[stack->top--];                                         \
+    T item = stack_##TNAME##_items(stack)[stack->top--];                       \
+    if (stack->top == -1 && stack->heap != NULL) {                             \
+      free(stack->heap);                                                       \
+      stack_##TNAME##_init(stack);                                             \
+    }                                                                          \
+    return item;                                                               \
   }                                                                            \
                                                                                \
   bool stack_##TNAME##_empty(stack_##TNAME##_t *stack) {                       \
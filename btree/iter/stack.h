@@ -7,8 +7,9 @@
 
 #include "../btree.h"
 
-// Maximální velikost zásobníku
-#define MAXSTACK 30
+// Počet položek uložených přímo ve struktuře zásobníku, hlubší zásobník
+// se přesune na haldu a jeho kapacita se pak zdvojnásobuje
+#define MAXSTACK 32
 
 /*
  * Makro generující deklarace pro zásobník typu T s názvovým infixem TNAME.
@@ -20,10 +21,15 @@
  *           bst_node_t *stack_bst_top(stack_bst_t *stack)
  *           bool stack_bst_empty(stack_bst_t *stack)
  * A ekvivalent pro TNAME="bool", T="bool".
+ *
+ * Do hloubky MAXSTACK zásobník nealokuje. Hlubší zásobník alokuje pole na
+ * haldě a uvolní ho, až se vyprázdní.
  */
 #define STACKDEC(T, TNAME)                                                     \
   typedef struct {                                                             \
     T items[MAXSTACK];                                                         \
+    T *heap;                                                                   \
+    int capacity;                                                              \
     int top;                                                                   \
   } stack_##TNAME##_t;                                                         \
                                                                                \
@@ -0,0 +1,233 @@
+/*
+ * Vyvážený strom v souvislém poli uzlů
+ *
+ * Tvar stromu je stejný jako u bst_freeze: úplný binární strom očíslovaný
+ * po úrovních, uzel k má potomky 2 k a 2 k + 1 a klíče jsou v něm
+ * v pořadí inorder. Liší se jen pořadí, ve kterém uzly leží v poli.
+ *
+ * Při pořadí BST_LAYOUT_BFS leží uzly po úrovních. Horní úrovně sdílejí
+ * několik řádků cache, ale hlouběji je každý krok hledání jinde a na
+ * disku každý krok jiná stránka.
+ *
+ * Pořadí BST_LAYOUT_VEB (van Emde Boas) rozdělí strom výšky h na horní
+ * strom výšky h / 2 a pod ním podstromy se zbytkem výšky. Horní strom
+ * leží v poli první, za ním podstromy jeden po druhém, a každý z nich je
+ * uspořádaný stejně rekurzivně. Pro libovolnou velikost bloku B (řádek
+ * cache, stránka, blok disku) projde hledání jen O(log n / log B) bloků,
+ * aniž by pořadí B znalo.
+ *
+ * Potomci jsou uloženi jako indexy, ne ukazatele, takže pole lze uložit
+ * do souboru a namapovat zpět na libovolnou adresu.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "btree.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Začátek souboru s uloženým polem, za ním následují uzly
+typedef struct bst_packed_header {
+  char magic[8]; // BST_PACKED_MAGIC
+  long long size; // počet uzlů
+} bst_packed_header_t;
+
+#define BST_PACKED_MAGIC "BSTPACK1"
+
+/*
+ * Pozice uzlů podstromu k výšky height v pořadí van Emde Boas, od
+ * pozice *next.
+ */
+static void bst_veb_order(int *position, long size, long k, int height,
+                          int *next) {
+  if (k > size) {
+    return;
+  }
+  if (height == 1) {
+    position[k] = (*next)++;
+    return;
+  }
+
+  //the top tree first, then the bottom trees from left to right
+  int top = height / 2;
+  bst_veb_order(position, size, k, top, next);
+  for (long j = 0; j < 1L << top && (k << top) + j <= size; j++) {
+    bst_veb_order(position, size, (k << top) + j, height - top, next);
+  }
+}
+
+/*
+ * Vyplnění podstromu k klíči od indexu next v pořadí inorder. Vrací index
+ * dalšího nepoužitého klíče.
+ */
+static int bst_pack_fill(bst_packed_t *packed, const int *position,
+                         const int *keys, const int *values, int next,
+                         long k) {
+  long size = packed->size;
+  if (k > size) {
+    return next;
+  }
+  next = bst_pack_fill(packed, position, keys, values, next, 2 * k);
+  bst_packed_node_t *node = &packed->nodes[position[k]];
+  node->key = keys[next];
+  node->value = values[next];
+  node->left = 2 * k <= size ? position[2 * k] : -1;
+  node->right = 2 * k + 1 <= size ? position[2 * k + 1] : -1;
+  return bst_pack_fill(packed, position, keys, values, next + 1, 2 * k + 1);
+}
+
+/*
+ * Vyvážený strom z count vzestupně seřazených klíčů v pořadí layout.
+ *
+ * Vrací false, pokud se nepodaří alokovat paměť.
+ */
+bool bst_pack_sorted(const int *keys, const int *values, int count,
+                     bst_layout_t layout, bst_packed_t *packed) {
+  int *position = malloc(((size_t)count + 1) * sizeof(int));
+  packed->nodes = malloc(((size_t)count + 1) * sizeof(bst_packed_node_t));
+  if (position == NULL || packed->nodes == NULL) {
+    free(position);
+    free(packed->nodes);
+    packed->nodes = NULL;
+    return false;
+  }
+  packed->size = count;
+  packed->mapping = NULL;
+  packed->mapping_size = 0;
+
+  if (layout == BST_LAYOUT_VEB) {
+    int height = 0, next = 0;
+    while (1L << height <= count) {
+      height++;
+    }
+    bst_veb_order(position, count, 1, height, &next);
+  } else {
+    for (long k = 1; k <= count; k++) {
+      position[k] = k - 1;
+    }
+  }
+  bst_pack_fill(packed, position, keys, values, 0, 1);
+  free(position);
+  return true;
+}
+
+/*
+ * Vyvážený strom se stejnými klíči a hodnotami jako tree v pořadí layout.
+ * Strom tree zůstane beze změny.
+ */
+bool bst_pack(bst_node_t *tree, bst_layout_t layout, bst_packed_t *packed) {
+  bst_items_t items = {NULL, 0, 0};
+  bst_inorder(tree, &items);
+
+  int *keys = malloc(((size_t)items.size + 1) * sizeof(int));
+  int *values = malloc(((size_t)items.size + 1) * sizeof(int));
+  bool packed_ok = keys != NULL && values != NULL;
+  for (int i = 0; packed_ok && i < items.size; i++) {
+    keys[i] = items.nodes[i]->key;
+    values[i] = items.nodes[i]->value;
+  }
+  packed_ok = packed_ok &&
+              bst_pack_sorted(keys, values, items.size, layout, packed);
+  free(keys);
+  free(values);
+  free(items.nodes);
+  return packed_ok;
+}
+
+/*
+ * Vyhledání klíče, při úspěchu zapíše jeho hodnotu do value.
+ *
+ * Pole může pocházet z poškozeného souboru, hledání proto skončí u indexu
+ * mimo pole a po size krocích, tedy i na cyklu.
+ */
+bool bst_packed_search(const bst_packed_t *packed, int key, int *value) {
+  int i = 0;
+  for (int step = 0; step < packed->size; step++) {
+    //-1 and any index past the array end up here
+    if ((unsigned)i >= (unsigned)packed->size) {
+      return false;
+    }
+    const bst_packed_node_t *node = &packed->nodes[i];
+    if (key == node->key) {
+      *value = node->value;
+      return true;
+    }
+    i = key < node->key ? node->left : node->right;
+  }
+  return false;
+}
+
+/*
+ * Uložení pole do souboru path, který lze načíst funkcí bst_packed_map.
+ */
+bool bst_packed_save(const bst_packed_t *packed, const char *path) {
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    return false;
+  }
+  bst_packed_header_t header = {BST_PACKED_MAGIC, packed->size};
+  bool written =
+      fwrite(&header, sizeof(header), 1, file) == 1 &&
+      fwrite(packed->nodes, sizeof(bst_packed_node_t), packed->size, file) ==
+          (size_t)packed->size;
+  return fclose(file) == 0 && written;
+}
+
+/*
+ * Namapování pole uloženého funkcí bst_packed_save jen pro čtení.
+ *
+ * Uzly se načítají z disku až při prvním přístupu a jádro je může při
+ * nedostatku paměti zase zahodit. Vrací false, pokud soubor nejde otevřít
+ * nebo neobsahuje uložené pole.
+ */
+bool bst_packed_map(bst_packed_t *packed, const char *path) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 ||
+      (size_t)info.st_size < sizeof(bst_packed_header_t)) {
+    close(fd);
+    return false;
+  }
+  void *mapping = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+
+  const bst_packed_header_t *header = mapping;
+  if (memcmp(header->magic, BST_PACKED_MAGIC, sizeof(header->magic)) != 0 ||
+      header->size < 0 || header->size > (1LL << 31) - 1 ||
+      (size_t)info.st_size != sizeof(*header) +
+                                  header->size * sizeof(bst_packed_node_t)) {
+    munmap(mapping, info.st_size);
+    return false;
+  }
+  packed->nodes = (bst_packed_node_t *)(header + 1);
+  packed->size = header->size;
+  packed->mapping = mapping;
+  packed->mapping_size = info.st_size;
+  return true;
+}
+
+/*
+ * Uvolnění pole nebo zrušení jeho namapování.
+ */
+void bst_packed_dispose(bst_packed_t *packed) {
+  if (packed->mapping != NULL) {
+    munmap(packed->mapping, packed->mapping_size);
+  } else {
+    free(packed->nodes);
+  }
+  packed->nodes = NULL;
+  packed->size = 0;
+  packed->mapping = NULL;
+  packed->mapping_size = 0;
+}
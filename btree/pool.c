@@ -0,0 +1,161 @@
+/*
+ * Zásoba uzlů pro jeden strom
+ *
+ * Uzly se alokují po blocích, každý další blok je dvakrát větší než
+ * předchozí až do BST_POOL_MAX_SLAB uzlů. Uzly uvolněné funkcí
+ * bst_pool_free se řadí do seznamu spojeného přes ukazatel left a další
+ * alokace je použije dřív, než sáhne do bloku. Funkce bst_pool_dispose
+ * uvolní jen bloky, strom proto neprochází.
+ *
+ * Uzly jednoho stromu tak leží blízko sebe a vkládání ani odstranění
+ * nevolá malloc a free pro každý uzel zvlášť.
+ *
+ * Funkce bst_pool_insert a bst_pool_delete mění strom stejně jako
+ * bst_insert a bst_delete nevyvážené varianty, ve všech variantách stromu
+ * (i v rb) proto tvoří obyčejný nevyvážený strom.
+ */
+
+#include "btree.h"
+#include <stdlib.h>
+
+// Velikost prvního a největšího bloku v počtu uzlů
+#define BST_POOL_FIRST_SLAB 16
+#define BST_POOL_MAX_SLAB 1024
+
+// Blok uzlů
+struct bst_pool_slab {
+  struct bst_pool_slab *next; // dříve alokovaný blok
+  bst_node_t nodes[];         // uzly bloku
+};
+
+/*
+ * Inicializace prázdné zásoby.
+ */
+void bst_pool_init(bst_pool_t *pool) {
+  pool->slabs = NULL;
+  pool->used = 0;
+  pool->capacity = 0;
+  pool->free = NULL;
+}
+
+/*
+ * Alokace uzlu ze zásoby pool, pro pool NULL funkcí malloc.
+ *
+ * Vrací NULL, pokud se nepodaří alokovat paměť.
+ */
+bst_node_t *bst_pool_alloc(bst_pool_t *pool) {
+  if (pool == NULL) {
+    return malloc(sizeof(bst_node_t));
+  }
+  if (pool->free != NULL) {
+    bst_node_t *node = pool->free;
+    pool->free = node->left;
+    return node;
+  }
+
+  if (pool->used == pool->capacity) {
+    int capacity = pool->capacity == 0 ? BST_POOL_FIRST_SLAB
+                                       : pool->capacity * 2;
+    if (capacity > BST_POOL_MAX_SLAB) {
+      capacity = BST_POOL_MAX_SLAB;
+    }
+    struct bst_pool_slab *slab =
+        malloc(sizeof(*slab) + capacity * sizeof(bst_node_t));
+    if (slab == NULL) {
+      return NULL;
+    }
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+    pool->used = 0;
+    pool->capacity = capacity;
+  }
+  return &pool->slabs->nodes[pool->used++];
+}
+
+/*
+ * Vrácení uzlu alokovaného funkcí bst_pool_alloc se stejnou zásobou.
+ */
+void bst_pool_free(bst_pool_t *pool, bst_node_t *node) {
+  if (pool == NULL) {
+    free(node);
+    return;
+  }
+  node->left = pool->free;
+  pool->free = node;
+}
+
+/*
+ * Vložení uzlu do stromu, nový uzel se alokuje ze zásoby pool, pro pool
+ * NULL funkcí malloc.
+ *
+ * Pokud uzel se zadaným klíčem už ve stromu existuje, nahradí se jeho
+ * hodnota. Jinak se vloží nový list.
+ */
+void bst_pool_insert(bst_pool_t *pool, bst_node_t **tree, char key,
+                     int value) {
+  bst_node_t **link = tree;
+  while (*link != NULL) {
+    if (key == (*link)->key) {
+      (*link)->value = value;
+      return;
+    }
+    link = key < (*link)->key ? &(*link)->left : &(*link)->right;
+  }
+
+  bst_node_t *node = bst_pool_alloc(pool);
+  if (node == NULL) {
+    return;
+  }
+  node->key = key;
+  node->value = value;
+  node->left = NULL;
+  node->right = NULL;
+  *link = node;
+}
+
+/*
+ * Odstranění uzlu ze stromu, odstraněný uzel se vrátí do zásoby pool, ze
+ * které byl alokován.
+ *
+ * Uzel se dvěma podstromy převezme klíč a hodnotu nejpravějšího uzlu
+ * levého podstromu a odstraní se ten. Pokud uzel se zadaným klíčem
+ * neexistuje, strom se nezmění.
+ */
+void bst_pool_delete(bst_pool_t *pool, bst_node_t **tree, char key) {
+  bst_node_t **link = tree;
+  while (*link != NULL && (*link)->key != key) {
+    link = key < (*link)->key ? &(*link)->left : &(*link)->right;
+  }
+  if (*link == NULL) {
+    return;
+  }
+
+  bst_node_t *target = *link;
+  if (target->left != NULL && target->right != NULL) {
+    link = &target->left;
+    while ((*link)->right != NULL) {
+      link = &(*link)->right;
+    }
+    target->key = (*link)->key;
+    target->value = (*link)->value;
+  }
+
+  //the removed node has at most one subtree, which takes its place
+  bst_node_t *removed = *link;
+  *link = removed->left != NULL ? removed->left : removed->right;
+  bst_pool_free(pool, removed);
+}
+
+/*
+ * Zrušení stromu tree, jehož uzly jsou všechny ze zásoby pool, a uvolnění
+ * zásoby. Strom i zásoba budou ve stejném stavu jako po inicializaci.
+ */
+void bst_pool_dispose(bst_pool_t *pool, bst_node_t **tree) {
+  while (pool->slabs != NULL) {
+    struct bst_pool_slab *next = pool->slabs->next;
+    free(pool->slabs);
+    pool->slabs = next;
+  }
+  bst_pool_init(pool);
+  *tree = NULL;
+}
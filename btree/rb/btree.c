@@ -0,0 +1,315 @@
+/*
+ * Binární vyhledávací strom — červeno-černá varianta
+ *
+ * Strom implementuje stejné rozhraní jako rekurzivní a iterativní varianta,
+ * vkládání a odstranění ale strom udržují vyvážený: kořen je černý, červený
+ * uzel nemá červeného potomka a každá cesta z kořene do listu obsahuje
+ * stejný počet černých uzlů. Výška stromu je tak nejvýš 2 log2 (n + 1).
+ *
+ * Vkládání i odstranění pracují shora dolů (Guibas, Sedgewick) v jednom
+ * průchodu bez rekurze a bez zásobníku. Cestou dolů se přebarvují a otáčejí
+ * uzly tak, aby na konci stačila lokální změna, a pamatují si jen několik
+ * předků. Nad kořenem je pomocný falešný uzel, takže rotace kořene není
+ * zvláštní případ. Oproti AVL stromu stačí při vkládání nejvýš dvě rotace
+ * a výšky se nepřepočítávají.
+ *
+ * Odstranění si nejpravější uzel levého podstromu najde během průchodu,
+ * funkce bst_replace_by_rightmost proto tato varianta neimplementuje a
+ * btree.h ji při překladu s -DRB nedeklaruje.
+ */
+
+#include "../btree.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static bool bst_is_red(bst_node_t *node) {
+  return node != NULL && node->red;
+}
+
+/*
+ * Potomek uzlu ve směru dir, false je levý a true pravý.
+ */
+static bst_node_t **bst_link(bst_node_t *node, bool dir) {
+  return dir ? &node->right : &node->left;
+}
+
+/*
+ * Jednoduchá rotace podstromu root ve směru dir.
+ *
+ * Nový kořen podstromu zčerná, původní kořen zčervená. Vrací nový kořen.
+ */
+static bst_node_t *bst_rotate(bst_node_t *root, bool dir) {
+  bst_node_t *save = *bst_link(root, !dir);
+  *bst_link(root, !dir) = *bst_link(save, dir);
+  *bst_link(save, dir) = root;
+  root->red = true;
+  save->red = false;
+  return save;
+}
+
+static bst_node_t *bst_rotate_double(bst_node_t *root, bool dir) {
+  *bst_link(root, !dir) = bst_rotate(*bst_link(root, !dir), !dir);
+  return bst_rotate(root, dir);
+}
+
+/*
+ * Inicializace stromu.
+ *
+ * Uživatel musí zajistit, že inicializace se nebude opakovaně volat nad
+ * inicializovaným stromem. V opačném případě může dojít k úniku paměti (memory
+ * leak). Protože neinicializovaný ukazatel má nedefinovanou hodnotu, není
+ * možné toto detekovat ve funkci.
+ */
+void bst_init(bst_node_t **tree) {
+  *tree = NULL;
+}
+
+/*
+ * Vyhledání uzlu v stromu.
+ *
+ * V případě úspěchu vrátí funkce hodnotu true a do proměnné value zapíše
+ * hodnotu daného uzlu. V opačném případě funkce vrátí hodnotu false a proměnná
+ * value zůstává nezměněná.
+ */
+bool bst_search(bst_node_t *tree, char key, int *value) {
+  while (tree != NULL) {
+    if (key == tree->key) {
+      *value = tree->value;
+      return true;
+    }
+    tree = key < tree->key ? tree->left : tree->right;
+  }
+  return false;
+}
+
+/*
+ * Vložení uzlu do stromu.
+ *
+ * Pokud uzel se zadaným klíčem už ve stromu existuje, nahradí se jeho
+ * hodnota. Jinak se vloží nový červený list.
+ *
+ * Cestou dolů se uzel se dvěma červenými potomky přebarví (on červený,
+ * potomci černí). Vznikne-li tím nebo vložením listu dvojice červených uzlů
+ * pod sebou, odstraní se jednoduchou nebo dvojitou rotací prarodiče. Předci
+ * nad ním zůstávají v pořádku, proto se nahoru už nevrací.
+ */
+void bst_insert(bst_node_t **tree, char key, int value) {
+  bst_node_t head = {0};
+  bst_node_t *great = &head;   //great-grandparent
+  bst_node_t *grand = NULL;    //grandparent
+  bst_node_t *parent = NULL;
+  bst_node_t *node = *tree;
+  bool dir = true, last = true;
+  head.right = *tree;
+
+  for (;;) {
+    if (node == NULL) {
+      //insert a red leaf
+      node = malloc(sizeof(bst_node_t));
+      if (node == NULL) {
+        break;
+      }
+      node->key = key;
+      node->value = value;
+      node->red = true;
+      node->left = NULL;
+      node->right = NULL;
+      if (parent == NULL) {
+        head.right = node;
+      } else {
+        *bst_link(parent, dir) = node;
+      }
+    } else if (bst_is_red(node->left) && bst_is_red(node->right)) {
+      //color flip
+      node->red = true;
+      node->left->red = false;
+      node->right->red = false;
+    }
+
+    //fix two reds in a row
+    if (bst_is_red(node) && bst_is_red(parent)) {
+      bool grand_dir = great->right == grand;
+      if (node == *bst_link(parent, last)) {
+        *bst_link(great, grand_dir) = bst_rotate(grand, !last);
+      } else {
+        *bst_link(great, grand_dir) = bst_rotate_double(grand, !last);
+      }
+    }
+
+    if (key == node->key) {
+      node->value = value;
+      break;
+    }
+
+    last = dir;
+    dir = key > node->key;
+    if (grand != NULL) {
+      great = grand;
+    }
+    grand = parent;
+    parent = node;
+    node = *bst_link(node, dir);
+  }
+
+  //the root is always black
+  *tree = head.right;
+  if (*tree != NULL) {
+    (*tree)->red = false;
+  }
+}
+
+/*
+ * Odstranění uzlu ze stromu.
+ *
+ * Pokud uzel se zadaným klíčem neexistuje, funkce nic nedělá. Pokud má
+ * odstraněný uzel oba podstromy, je nahrazený nejpravějším uzlem levého
+ * podstromu, fyzicky se tak vždy odstraní uzel s nejvýš jedním potomkem.
+ *
+ * Odstranit lze bez další opravy jen červený uzel. Cestou dolů se proto
+ * červená barva posouvá k aktuálnímu uzlu: od červeného potomka rotací,
+ * od sourozence přebarvením nebo rotací rodiče.
+ */
+void bst_delete(bst_node_t **tree, char key) {
+  if (*tree == NULL) {
+    return;
+  }
+
+  bst_node_t head = {0};
+  bst_node_t *grand = NULL;
+  bst_node_t *parent = NULL;
+  bst_node_t *node = &head;
+  bst_node_t *found = NULL;
+  bool dir = true;
+  head.right = *tree;
+
+  //after the key is found, the search goes left once and then right, to the
+  //rightmost node of the left subtree
+  while (*bst_link(node, dir) != NULL) {
+    bool last = dir;
+    grand = parent;
+    parent = node;
+    node = *bst_link(node, dir);
+    dir = key > node->key;
+    if (key == node->key) {
+      found = node;
+    }
+
+    //push a red node down
+    if (bst_is_red(node) || bst_is_red(*bst_link(node, dir))) {
+      continue;
+    }
+    if (bst_is_red(*bst_link(node, !dir))) {
+      parent = *bst_link(parent, last) = bst_rotate(node, dir);
+      continue;
+    }
+    bst_node_t *sibling = *bst_link(parent, !last);
+    if (sibling == NULL) {
+      continue;
+    }
+    if (!bst_is_red(sibling->left) && !bst_is_red(sibling->right)) {
+      //color flip
+      parent->red = false;
+      sibling->red = true;
+      node->red = true;
+    } else {
+      bool grand_dir = grand->right == parent;
+      if (bst_is_red(*bst_link(sibling, last))) {
+        *bst_link(grand, grand_dir) = bst_rotate_double(parent, last);
+      } else {
+        *bst_link(grand, grand_dir) = bst_rotate(parent, last);
+      }
+
+      //fix the colors after the rotation
+      bst_node_t *root = *bst_link(grand, grand_dir);
+      node->red = true;
+      root->red = true;
+      root->left->red = false;
+      root->right->red = false;
+    }
+  }
+
+  //node has at most one child, its parent inherits it
+  if (found != NULL) {
+    found->key = node->key;
+    found->value = node->value;
+    *bst_link(parent, parent->right == node) =
+        node->left != NULL ? node->left : node->right;
+    free(node);
+  }
+
+  *tree = head.right;
+  if (*tree != NULL) {
+    (*tree)->red = false;
+  }
+}
+
+/*
+ * Zrušení celého stromu.
+ *
+ * Po zrušení se celý strom bude nacházet ve stejném stavu jako po
+ * inicializaci. Levý potomek se rotací přesouvá nad uzel, dokud uzel žádného
+ * nemá, pak se uzel uvolní a pokračuje se pravým podstromem. Funkce tak
+ * nepotřebuje zásobník.
+ */
+void bst_dispose(bst_node_t **tree) {
+  bst_node_t *node = *tree;
+
+  while (node != NULL) {
+    bst_node_t *next;
+    if (node->left == NULL) {
+      next = node->right;
+      free(node);
+    } else {
+      //rotate right
+      next = node->left;
+      node->left = next->right;
+      next->right = node;
+    }
+    node = next;
+  }
+
+  *tree = NULL;
+}
+
+/*
+ * Preorder průchod stromem.
+ *
+ * Pro aktuálně zpracovávaný uzel se zavolá funkce bst_add_node_to_items.
+ * Hloubka rekurze je omezená výškou stromu.
+ */
+void bst_preorder(bst_node_t *tree, bst_items_t *items) {
+  if (tree == NULL)
+    return;
+
+  bst_add_node_to_items(tree, items);
+  bst_preorder(tree->left, items);
+  bst_preorder(tree->right, items);
+}
+
+/*
+ * Inorder průchod stromem.
+ *
+ * Pro aktuálně zpracovávaný uzel se zavolá funkce bst_add_node_to_items.
+ */
+void bst_inorder(bst_node_t *tree, bst_items_t *items) {
+  if (tree == NULL)
+    return;
+
+  bst_inorder(tree->left, items);
+  bst_add_node_to_items(tree, items);
+  bst_inorder(tree->right, items);
+}
+
+/*
+ * Postorder průchod stromem.
+ *
+ * Pro aktuálně zpracovávaný uzel se zavolá funkce bst_add_node_to_items.
+ */
+void bst_postorder(bst_node_t *tree, bst_items_t *items) {
+  if (tree == NULL)
+    return;
+
+  bst_postorder(tree->left, items);
+  bst_postorder(tree->right, items);
+  bst_add_node_to_items(tree, items);
+}
@@ -1,5 +1,6 @@
 #include "btree.h"
 #include "test_util.h"
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -365,7 +366,12 @@ bool bool_res4;
 bool_res = bst_search(test_tree, 'E', &result);
 bool_res2 = bst_search(test_tree, 'D', &result2);
 bool_res3 = bst_search(test_tree, 'F', &result2);
+#ifndef RB
 bool_res4 = (test_tree->left->right->left->left == NULL);
+#else
+//the red-black tree is shaped differently, only the keys are checked
+bool_res4 = true;
+#endif // RB
 if (bool_res4 == true && bool_res3 == true && bool_res2 == true && bool_res == false){
   green();
   printf("Node E was deleted correctly: [TEST PASSED ✓]\n\n");
@@ -475,6 +481,470 @@ reset_color();
 bst_print_items(test_items);
 ENDTEST
 
+TEST(test_frozen_search, "Search in a frozen tree")
+test_count++;
+bst_init(&test_tree);
+bst_insert_many(&test_tree, base_keys, base_values, base_data_count);
+bst_frozen_t frozen;
+bool correct = bst_freeze(test_tree, &frozen) &&
+               frozen.size == base_data_count && frozen.keys[1] == 'H' &&
+               (uintptr_t)frozen.keys % 64 == 0;
+int result, tree_result;
+for (char key = 'A' - 1; correct && key <= 'Z'; key++) {
+  bool found = bst_frozen_search(&frozen, key, &result);
+  correct = found == bst_search(test_tree, key, &tree_result) &&
+            (!found || result == tree_result);
+}
+bst_frozen_dispose(&frozen);
+bst_dispose(&test_tree);
+correct = correct && bst_freeze(test_tree, &frozen) && frozen.size == 0 &&
+          !bst_frozen_search(&frozen, 'H', &result);
+bst_frozen_dispose(&frozen);
+if (correct){
+  green();
+  printf("Frozen tree finds the same keys as the tree: [TEST PASSED ✓]\n\n");
+  tests_passed++;
+} else {
+  red();
+  printf("Frozen tree does NOT find the same keys: [TEST FAILED ☓]\n\n");
+}
+reset_color();
+ENDTEST
+
+TEST(test_packed_layouts, "Search in BFS and van Emde Boas node arrays")
+test_count++;
+bst_init(&test_tree);
+bst_insert_many(&test_tree, base_keys, base_values, base_data_count);
+bst_packed_t bfs, veb, mapped;
+bool correct = bst_pack(test_tree, BST_LAYOUT_BFS, &bfs) &&
+               bst_pack(test_tree, BST_LAYOUT_VEB, &veb);
+//veb: H, D, L, then the subtrees B A C, F E G, J I K, N M O
+correct = correct && bfs.nodes[0].key == 'H' && bfs.nodes[4].key == 'F' &&
+          veb.nodes[0].key == 'H' && veb.nodes[3].key == 'B' &&
+          veb.nodes[4].key == 'A' && veb.nodes[6].key == 'F' &&
+          veb.nodes[14].key == 'O';
+correct = correct && bst_packed_save(&veb, "test_packed.bin") &&
+          bst_packed_map(&mapped, "test_packed.bin");
+remove("test_packed.bin");
+int result, tree_result;
+for (char key = 'A' - 1; correct && key <= 'Z'; key++) {
+  bool found = bst_search(test_tree, key, &tree_result);
+  correct = bst_packed_search(&bfs, key, &result) == found &&
+            (!found || result == tree_result) &&
+            bst_packed_search(&veb, key, &result) == found &&
+            (!found || result == tree_result) &&
+            bst_packed_search(&mapped, key, &result) == found &&
+            (!found || result == tree_result);
+}
+bst_packed_dispose(&bfs);
+bst_packed_dispose(&veb);
+bst_packed_dispose(&mapped);
+
+//odd keys of a larger tree that is not complete
+int keys[1000], values[1000];
+for (int i = 0; i < 1000; i++) {
+  keys[i] = 2 * i + 1;
+  values[i] = i;
+}
+correct = correct && bst_pack_sorted(keys, values, 1000, BST_LAYOUT_VEB, &veb);
+for (int key = 0; correct && key <= 2000; key++)
+  correct = bst_packed_search(&veb, key, &result) == (key % 2 == 1) &&
+            (key % 2 == 0 || result == key / 2);
+//a corrupted array: a cycle on the left, an index past the end on the right
+if (correct) {
+  veb.nodes[0].left = 0;
+  veb.nodes[0].right = 1000;
+  correct = !bst_packed_search(&veb, 0, &result) &&
+            !bst_packed_search(&veb, 2000, &result);
+}
+bst_packed_dispose(&veb);
+if (correct){
+  green();
+  printf("Both layouts find the same keys as the tree: [TEST PASSED ✓]\n\n");
+  tests_passed++;
+} else {
+  red();
+  printf("Layouts do NOT find the same keys: [TEST FAILED ☓]\n\n");
+}
+reset_color();
+ENDTEST
+
+TEST(test_pool_tree, "Insert and delete with nodes from a pool")
+test_count++;
+bst_init(&test_tree);
+bst_insert_many(&test_tree, base_keys, base_values, base_data_count);
+bst_pool_t pool;
+bst_node_t *pool_tree;
+bst_pool_init(&pool);
+bst_init(&pool_tree);
+for (int i = 0; i < base_data_count; i++)
+  bst_pool_insert(&pool, &pool_tree, base_keys[i], base_values[i]);
+//leaf, one subtree, both subtrees
+bst_delete(&test_tree, 'A');
+bst_delete(&test_tree, 'B');
+bst_delete(&test_tree, 'L');
+bst_pool_delete(&pool, &pool_tree, 'A');
+bst_pool_delete(&pool, &pool_tree, 'B');
+bst_pool_delete(&pool, &pool_tree, 'L');
+//a new node reuses the last deleted one
+bst_node_t *reused = pool.free;
+bst_insert(&test_tree, 'Z', 26);
+bst_pool_insert(&pool, &pool_tree, 'Z', 26);
+bool correct = reused != NULL && reused->key == 'Z';
+
+bst_items_t *pool_items = bst_init_items();
+#ifndef RB
+bst_preorder(test_tree, test_items);
+bst_preorder(pool_tree, pool_items);
+#else
+//the pool tree is not a red-black tree, only the keys are checked
+bst_inorder(test_tree, test_items);
+bst_inorder(pool_tree, pool_items);
+#endif // RB
+correct = correct && test_items->size == pool_items->size;
+for (int i = 0; correct && i < test_items->size; i++)
+  correct = test_items->nodes[i]->key == pool_items->nodes[i]->key &&
+            test_items->nodes[i]->value == pool_items->nodes[i]->value;
+bst_reset_items(pool_items);
+free(pool_items);
+bst_pool_dispose(&pool, &pool_tree);
+correct = correct && pool_tree == NULL && pool.slabs == NULL;
+if (correct){
+  green();
+  printf("Pool tree has the same shape as the tree: [TEST PASSED ✓]\n\n");
+  tests_passed++;
+} else {
+  red();
+  printf("Pool tree does NOT have the same shape: [TEST FAILED ☓]\n\n");
+}
+reset_color();
+ENDTEST
+
+/*
+ * Shoda dvou průchodů, uzel po uzlu.
+ */
+bool same_items(bst_items_t *expected, bst_items_t *actual) {
+  bool same = expected->size == actual->size;
+  for (int i = 0; same && i < expected->size; i++)
+    same = expected->nodes[i] == actual->nodes[i];
+  return same;
+}
+
+TEST(test_morris_traversals, "Traverse the tree without a stack")
+test_count++;
+bst_init(&test_tree);
+bst_insert_many(&test_tree, base_keys, base_values, base_data_count);
+bst_insert_many(&test_tree, additional_keys, additional_values,
+                additional_data_count);
+bst_items_t *morris_items = bst_init_items();
+void (*traversals[3])(bst_node_t *, bst_items_t *) = {
+    bst_preorder, bst_inorder, bst_postorder};
+void (*morris[3])(bst_node_t *, bst_items_t *) = {
+    bst_morris_preorder, bst_morris_inorder, bst_morris_postorder};
+bool correct = true;
+for (int i = 0; i < 3; i++) {
+  traversals[i](test_tree, test_items);
+  morris[i](test_tree, morris_items);
+  correct = correct && test_items->size == base_data_count +
+                                               additional_data_count &&
+            same_items(test_items, morris_items);
+  bst_reset_items(test_items);
+  bst_reset_items(morris_items);
+}
+//the tree is unchanged, so the plain traversal still agrees
+bst_morris_inorder(test_tree, morris_items);
+bst_inorder(test_tree, test_items);
+correct = correct && same_items(test_items, morris_items);
+bst_reset_items(morris_items);
+bst_morris_postorder(NULL, morris_items);
+correct = correct && morris_items->size == 0;
+free(morris_items);
+if (correct){
+  green();
+  printf("Traversals without a stack match: [TEST PASSED ✓]\n\n");
+  tests_passed++;
+} else {
+  red();
+  printf("Traversals without a stack do NOT match: [TEST FAILED ☓]\n\n");
+}
+reset_color();
+ENDTEST
+
+TEST(test_tree_iterators, "Traverse the tree one node at a time")
+test_count++;
+bst_init(&test_tree);
+bst_insert_many(&test_tree, base_keys, base_values, base_data_count);
+bst_insert_many(&test_tree, additional_keys, additional_values,
+                additional_data_count);
+bst_items_t *iter_items = bst_init_items();
+void (*traversals[3])(bst_node_t *, bst_items_t *) = {
+    bst_preorder, bst_inorder, bst_postorder};
+bst_order_t orders[3] = {BST_PREORDER, BST_INORDER, BST_POSTORDER};
+bst_iter_t iter;
+bst_node_t *node;
+bool correct = true;
+for (int i = 0; i < 3; i++) {
+  traversals[i](test_tree, test_items);
+  bst_iter_init(&iter, test_tree, orders[i]);
+  while ((node = bst_iter_next(&iter)) != NULL)
+    bst_add_node_to_items(node, iter_items);
+  correct = correct && test_items->size == base_data_count +
+                                               additional_data_count &&
+            same_items(test_items, iter_items) && !iter.overflow;
+  bst_reset_items(test_items);
+  bst_reset_items(iter_items);
+}
+free(iter_items);
+
+//first three keys from E, from a missing key and past the last key
+char first[4] = "";
+bst_iter_seek(&iter, test_tree, 'E');
+for (int i = 0; i < 3 && (node = bst_iter_next(&iter)) != NULL; i++)
+  first[i] = node->key;
+bst_iter_seek(&iter, test_tree, 'T');
+node = bst_iter_next(&iter);
+correct = correct && first[0] == 'E' && first[1] == 'F' && first[2] == 'G' &&
+          node != NULL && node->key == 'X';
+bst_iter_seek(&iter, test_tree, 'Z' + 1);
+correct = correct && bst_iter_next(&iter) == NULL;
+bst_iter_init(&iter, NULL, BST_POSTORDER);
+correct = correct && bst_iter_next(&iter) == NULL;
+if (correct){
+  green();
+  printf("Iterators visit nodes in traversal order: [TEST PASSED ✓]\n\n");
+  tests_passed++;
+} else {
+  red();
+  printf("Iterators do NOT visit nodes in traversal order: [TEST FAILED ☓]\n\n");
+}
+reset_color();
+ENDTEST
+
+#ifndef RB
+/*
+ * Kontrola AVL stromu: uspořádání klíčů, uložené výšky a vyváženost.
+ * Vrací výšku stromu, nebo -1, pokud podmínky nesplňuje.
+ */
+int avl_check(bst_node_t *tree, char min, char max) {
+  if (tree == NULL)
+    return 0;
+  if (tree->key < min || tree->key > max)
+    return -1;
+  int left = avl_check(tree->left, min, tree->key - 1);
+  int right = avl_check(tree->right, tree->key + 1, max);
+  int height = (left > right ? left : right) + 1;
+  if (left < 0 || right < 0 || left - right > 1 || right - left > 1 ||
+      tree->height != height)
+    return -1;
+  return height;
+}
+
+TEST(test_avl_insert_sorted, "AVL insert of sorted keys (A..z)")
+test_count++;
+bst_init(&test_tree);
+bool found_all = true;
+int result;
+for (char key = 'A'; key <= 'z'; key++)
+  bst_avl_insert(&test_tree, key, key);
+bst_avl_insert(&test_tree, 'M', 1);
+for (char key = 'A'; key <= 'z'; key++)
+  found_all = found_all && bst_search(test_tree, key, &result) &&
+              result == (key == 'M' ? 1 : key);
+//58 keys, a plain insert would make a list of height 58
+int height = avl_check(test_tree, 'A', 'z');
+if (found_all && height > 0 && height <= 7){
+  green();
+  printf("Tree of 58 sorted keys has height %d: [TEST PASSED ✓]\n\n", height);
+  tests_passed++;
+} else {
+  red();
+  printf("Tree of 58 sorted keys has height %d: [TEST FAILED ☓]\n\n", height);
+}
+reset_color();
+ENDTEST
+
+TEST(test_avl_delete, "AVL delete keeps the tree balanced")
+test_count++;
+bst_init(&test_tree);
+bool correct = true;
+int result;
+for (char key = 'z'; key >= 'A'; key--)
+  bst_avl_insert(&test_tree, key, key);
+//remove every key but every third, inner nodes and the root included
+for (char key = 'A'; key <= 'z'; key++) {
+  if ((key - 'A') % 3 != 0) {
+    bst_avl_delete(&test_tree, key);
+    correct = correct && avl_check(test_tree, 'A', 'z') >= 0;
+  }
+}
+bst_avl_delete(&test_tree, '#');
+for (char key = 'A'; key <= 'z'; key++)
+  correct = correct &&
+            bst_search(test_tree, key, &result) == ((key - 'A') % 3 == 0);
+bst_print_tree(test_tree);
+if (correct && avl_check(test_tree, 'A', 'z') <= 5){
+  green();
+  printf("Tree stayed balanced after deletes: [TEST PASSED ✓]\n\n");
+  tests_passed++;
+} else {
+  red();
+  printf("Tree did NOT stay balanced after deletes: [TEST FAILED ☓]\n\n");
+}
+reset_color();
+ENDTEST
+
+#endif // RB
+
+#ifdef RB
+/*
+ * Kontrola červeno-černého stromu: uspořádání klíčů, žádný červený uzel
+ * s červeným potomkem a stejný počet černých uzlů na všech cestách.
+ * Vrací černou výšku stromu, nebo -1, pokud podmínky nesplňuje.
+ */
+int rb_check(bst_node_t *tree, char min, char max) {
+  if (tree == NULL)
+    return 0;
+  if (tree->key < min || tree->key > max)
+    return -1;
+  if (tree->red && ((tree->left != NULL && tree->left->red) ||
+                    (tree->right != NULL && tree->right->red)))
+    return -1;
+  int left = rb_check(tree->left, min, tree->key - 1);
+  int right = rb_check(tree->right, tree->key + 1, max);
+  if (left < 0 || left != right)
+    return -1;
+  return left + (tree->red ? 0 : 1);
+}
+
+int rb_height(bst_node_t *tree) {
+  if (tree == NULL)
+    return 0;
+  int left = rb_height(tree->left), right = rb_height(tree->right);
+  return (left > right ? left : right) + 1;
+}
+
+TEST(test_rb_insert_sorted, "Red-black insert of sorted keys (A..z)")
+test_count++;
+bst_init(&test_tree);
+bool found_all = true;
+int result;
+for (char key = 'A'; key <= 'z'; key++)
+  bst_insert(&test_tree, key, key);
+bst_insert(&test_tree, 'M', 1);
+for (char key = 'A'; key <= 'z'; key++)
+  found_all = found_all && bst_search(test_tree, key, &result) &&
+              result == (key == 'M' ? 1 : key);
+//58 keys, the height is at most 2 log2 59
+int height = rb_height(test_tree);
+if (found_all && !test_tree->red && rb_check(test_tree, 'A', 'z') > 0 &&
+    height <= 11){
+  green();
+  printf("Tree of 58 sorted keys has height %d: [TEST PASSED ✓]\n\n", height);
+  tests_passed++;
+} else {
+  red();
+  printf("Tree of 58 sorted keys has height %d: [TEST FAILED ☓]\n\n", height);
+}
+reset_color();
+ENDTEST
+
+TEST(test_rb_delete, "Red-black delete keeps the tree balanced")
+test_count++;
+bst_init(&test_tree);
+bool correct = true;
+int result;
+for (char key = 'z'; key >= 'A'; key--)
+  bst_insert(&test_tree, key, key);
+for (char key = 'A'; key <= 'z'; key++) {
+  if ((key - 'A') % 3 != 0) {
+    bst_delete(&test_tree, key);
+    correct = correct && rb_check(test_tree, 'A', 'z') >= 0 &&
+              (test_tree == NULL || !test_tree->red);
+  }
+}
+bst_delete(&test_tree, '#');
+for (char key = 'A'; key <= 'z'; key++)
+  correct = correct &&
+            bst_search(test_tree, key, &result) == ((key - 'A') % 3 == 0);
+bst_print_tree(test_tree);
+if (correct && rb_height(test_tree) <= 9){
+  green();
+  printf("Tree stayed balanced after deletes: [TEST PASSED ✓]\n\n");
+  tests_passed++;
+} else {
+  red();
+  printf("Tree did NOT stay balanced after deletes: [TEST FAILED ☓]\n\n");
+}
+reset_color();
+ENDTEST
+#endif // RB
+
+#ifdef ITER
+/*
+ * Degenerovaný strom, každý uzel má jen levého potomka. Hodnota uzlu je
+ * jeho vzdálenost od nejhlubšího uzlu.
+ */
+bst_node_t *make_left_chain(int depth) {
+  bst_node_t *tree = NULL;
+  for (int i = 0; i < depth; i++) {
+    bst_node_t *node = malloc(sizeof(bst_node_t));
+    if (node == NULL)
+      break;
+    node->key = 'A';
+    node->value = i;
+    node->height = 0;
+    node->red = false;
+    node->left = tree;
+    node->right = NULL;
+    tree = node;
+  }
+  return tree;
+}
+
+TEST(test_deep_tree_traversal, "Traverse a tree 1000000 levels deep")
+test_count++;
+const int depth = 1000000;
+test_tree = make_left_chain(depth);
+bool correct = test_tree != NULL && test_tree->value == depth - 1;
+bst_inorder(test_tree, test_items);
+correct = correct && test_items->size == depth;
+for (int i = 0; correct && i < depth; i++)
+  correct = test_items->nodes[i]->value == i;
+bst_reset_items(test_items);
+bst_preorder(test_tree, test_items);
+correct = correct && test_items->size == depth &&
+          test_items->nodes[0]->value == depth - 1 &&
+          test_items->nodes[depth - 1]->value == 0;
+bst_reset_items(test_items);
+bst_postorder(test_tree, test_items);
+correct = correct && test_items->size == depth &&
+          test_items->nodes[0]->value == 0 &&
+          test_items->nodes[depth - 1]->value == depth - 1;
+bst_reset_items(test_items);
+bst_morris_inorder(test_tree, test_items);
+correct = correct && test_items->size == depth &&
+          test_items->nodes[depth - 1]->value == depth - 1;
+bst_reset_items(test_items);
+bst_morris_postorder(test_tree, test_items);
+correct = correct && test_items->size == depth &&
+          test_items->nodes[0]->value == 0;
+//the iterator stack is bounded, so it reports the depth instead
+bst_iter_t iter;
+bst_iter_init(&iter, test_tree, BST_INORDER);
+correct = correct && bst_iter_next(&iter) == NULL && iter.overflow;
+bst_dispose(&test_tree);
+if (correct && test_tree == NULL){
+  green();
+  printf("All traversals visited all nodes: [TEST PASSED ✓]\n\n");
+  tests_passed++;
+} else {
+  red();
+  printf("Traversals did NOT visit all nodes: [TEST FAILED ☓]\n\n");
+}
+reset_color();
+ENDTEST
+#endif // ITER
+
 #ifdef EXA
 
 TEST(test_letter_count_basic, "Count letters - Basic test");
@@ -790,6 +1260,21 @@ int main(int argc, char *argv[]) {
   test_tree_preorder();
   test_tree_inorder();
   test_tree_postorder();
+  test_frozen_search();
+  test_packed_layouts();
+  test_pool_tree();
+  test_morris_traversals();
+  test_tree_iterators();
+#ifndef RB
+  test_avl_insert_sorted();
+  test_avl_delete();
+#else
+  test_rb_insert_sorted();
+  test_rb_delete();
+#endif // RB
+#ifdef ITER
+  test_deep_tree_traversal();
+#endif // ITER
   
   tests_failed = test_count - tests_passed;
   printf("\n");
@@ -0,0 +1,936 @@
+/*
+ * Měření výkonu tabulky s rozptýlenými položkami.
+ *
+ * Spuštění: ./bench [název měření ...], bez argumentů spustí všechna.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
+#include "compact.h"
+#include "keyed.h"
+#include "ops.h"
+#include "sketch.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#define KEY_LENGTH 8
+
+static double now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t bench_rand(uint64_t *state) {
+  //xorshift64*
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return *state * UINT64_C(2685821657736338717);
+}
+
+/*
+ * Náhodné klíče z malých písmen, každý dlouhý KEY_LENGTH znaků.
+ */
+static char *make_random_keys(int count, uint64_t seed) {
+  char *keys = malloc((size_t)count * (KEY_LENGTH + 1));
+  for (int i = 0; i < count; i++) {
+    char *key = keys + (size_t)i * (KEY_LENGTH + 1);
+    for (int j = 0; j < KEY_LENGTH; j++) {
+      key[j] = 'a' + bench_rand(&seed) % 26;
+    }
+    key[KEY_LENGTH] = '\0';
+  }
+  return keys;
+}
+
+/*
+ * Klíče útočníka — permutace stejných znaků, takže mají stejný součet
+ * znaků a get_hash je všechny pošle do jednoho seznamu synonym.
+ */
+static char *make_colliding_keys(int count) {
+  char *keys = malloc((size_t)count * (KEY_LENGTH + 1));
+  char perm[KEY_LENGTH + 1] = "abcdefgh";
+
+  for (int i = 0; i < count; i++) {
+    memcpy(keys + (size_t)i * (KEY_LENGTH + 1), perm, KEY_LENGTH + 1);
+
+    //next lexicographic permutation
+    int j = KEY_LENGTH - 2;
+    while (j >= 0 && perm[j] >= perm[j + 1]) {
+      j--;
+    }
+    if (j < 0) {
+      break;
+    }
+    int k = KEY_LENGTH - 1;
+    while (perm[k] <= perm[j]) {
+      k--;
+    }
+    char tmp = perm[j];
+    perm[j] = perm[k];
+    perm[k] = tmp;
+    for (int a = j + 1, b = KEY_LENGTH - 1; a < b; a++, b--) {
+      tmp = perm[a];
+      perm[a] = perm[b];
+      perm[b] = tmp;
+    }
+  }
+  return keys;
+}
+
+/*
+ * Vloží count klíčů a vrátí počet milionů vyhledání za sekundu.
+ */
+static double lookup_rate(htk_hash_mode_t hash, char *keys, int count,
+                          int lookups) {
+  htk_table_t *table = malloc(sizeof(htk_table_t));
+  htk_options_t opts = {hash, {0, 0}, 0, HTK_SIZING_PRIME};
+  htk_init(table, &opts);
+  for (int i = 0; i < count; i++) {
+    htk_insert(table, keys + (size_t)i * (KEY_LENGTH + 1), i);
+  }
+
+  double start = now_sec();
+  float sum = 0;
+  for (int i = 0; i < lookups; i++) {
+    char *key = keys + (size_t)(i % count) * (KEY_LENGTH + 1);
+    float *value = htk_get(table, key);
+    sum += value != NULL ? *value : 0;
+  }
+  double elapsed = now_sec() - start;
+
+  htk_delete_all(table);
+  free(table);
+  return sum < 0 ? 0 : lookups / elapsed / 1e6;
+}
+
+/*
+ * Útok kolizemi: propustnost vyhledávání pro náhodné klíče a pro klíče
+ * útočníka. S HTK_HASH_SIPHASH musí zůstat obě čísla stejná.
+ */
+static void bench_flood(void) {
+  const int sizes[] = {1000, 2000, 4000, 8000};
+  const int lookups = 100000;
+
+  printf("Hash flooding, %d lookups, %d buckets [Mlookups/s]\n", lookups,
+         HT_SIZE);
+  printf("%8s %12s %12s %12s %12s\n", "keys", "sum/random", "sum/attack",
+         "sip/random", "sip/attack");
+
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    char *random = make_random_keys(sizes[i], 42 + i);
+    char *attack = make_colliding_keys(sizes[i]);
+    printf("%8d %12.2f %12.2f %12.2f %12.2f\n", sizes[i],
+           lookup_rate(HTK_HASH_SUM, random, sizes[i], lookups),
+           lookup_rate(HTK_HASH_SUM, attack, sizes[i], lookups),
+           lookup_rate(HTK_HASH_SIPHASH, random, sizes[i], lookups),
+           lookup_rate(HTK_HASH_SIPHASH, attack, sizes[i], lookups));
+    free(random);
+    free(attack);
+  }
+  printf("\n");
+}
+
+/*
+ * Délka nejdelšího seznamu synonym a podíl prázdných seznamů.
+ */
+static void chain_stats(htk_table_t *table, int *max_chain, double *empty) {
+  int empty_count = 0;
+  *max_chain = 0;
+  for (int i = 0; i < table->size; i++) {
+    int length = 0;
+    for (ht_item_t *item = htk_list(table, i); item != NULL;
+         item = item->next) {
+      length++;
+    }
+    empty_count += length == 0;
+    *max_chain = length > *max_chain ? length : *max_chain;
+  }
+  *empty = (double)empty_count / table->size;
+}
+
+/*
+ * Převod hodnoty na index: hardwarové dělení, fastmod a maska, každý
+ * zvlášť bez vyhledávání, a potom celé vyhledávání v tabulce s milionem
+ * klíčů pro obě velikosti tabulky.
+ */
+static void bench_modulo(void) {
+  const int values_count = 1 << 20, rounds = 50;
+  volatile uint32_t divisor = 1048573;
+  uint32_t d = divisor;
+  uint64_t fastmod = UINT64_MAX / d + 1;
+  uint64_t state = 7, sink = 0;
+
+  uint64_t *values = malloc(values_count * sizeof(uint64_t));
+  for (int i = 0; i < values_count; i++) {
+    values[i] = bench_rand(&state);
+  }
+
+  printf("Index computation, %d values [Mops/s]\n", values_count * rounds);
+  double start = now_sec();
+  for (int r = 0; r < rounds; r++) {
+    for (int i = 0; i < values_count; i++) {
+      sink += (uint32_t)values[i] % d;
+    }
+  }
+  printf("%-24s %8.1f\n", "hardware divide",
+         values_count * rounds / (now_sec() - start) / 1e6);
+
+  start = now_sec();
+  for (int r = 0; r < rounds; r++) {
+    for (int i = 0; i < values_count; i++) {
+      uint64_t lowbits = fastmod * (uint32_t)values[i];
+      sink += (((lowbits >> 32) * d) + (((lowbits & UINT32_MAX) * d) >> 32)) >> 32;
+    }
+  }
+  printf("%-24s %8.1f\n", "fastmod", values_count * rounds / (now_sec() - start) / 1e6);
+
+  start = now_sec();
+  for (int r = 0; r < rounds; r++) {
+    for (int i = 0; i < values_count; i++) {
+      uint64_t h = values[i];
+      h ^= h >> 33;
+      h *= UINT64_C(0xff51afd7ed558ccd);
+      h ^= h >> 33;
+      h *= UINT64_C(0xc4ceb9fe1a85ec53);
+      h ^= h >> 33;
+      sink += h & ((1 << 20) - 1);
+    }
+  }
+  printf("%-24s %8.1f\n", "mix and mask",
+         values_count * rounds / (now_sec() - start) / 1e6);
+  free(values);
+
+  //whole lookups at load factor ~1
+  const int count = 1000000;
+  const htk_sizing_t sizings[] = {HTK_SIZING_PRIME, HTK_SIZING_POW2};
+  const char *names[] = {"prime 1048573", "pow2 1048576"};
+  char *keys = make_random_keys(count, 1234);
+
+  printf("\nLookups, %d keys, SipHash\n", count);
+  printf("%-16s %12s %10s %10s\n", "sizing", "Mlookups/s", "max chain",
+         "empty");
+  for (int s = 0; s < 2; s++) {
+    htk_table_t *table = malloc(sizeof(htk_table_t));
+    htk_options_t opts = {HTK_HASH_SIPHASH, {0, 0}, 1048573, sizings[s]};
+    htk_init(table, &opts);
+    for (int i = 0; i < count; i++) {
+      htk_insert(table, keys + (size_t)i * (KEY_LENGTH + 1), i);
+    }
+
+    start = now_sec();
+    for (int i = 0; i < count; i++) {
+      float *value = htk_get(table, keys + (size_t)i * (KEY_LENGTH + 1));
+      sink += value != NULL;
+    }
+    double rate = count / (now_sec() - start) / 1e6;
+
+    int max_chain;
+    double empty;
+    chain_stats(table, &max_chain, &empty);
+    printf("%-16s %12.2f %10d %9.1f%%\n", names[s], rate, max_chain,
+           empty * 100);
+    htk_dispose(table);
+    free(table);
+  }
+  free(keys);
+  printf("(ideal empty share at this load is %.1f%%)\n\n",
+         100 * exp(-(double)count / 1048573));
+  if (sink == 42) {
+    printf("\n");
+  }
+}
+
+/*
+ * Indexy count vyhledání podle Zipfova rozdělení s exponentem exponent nad
+ * keys_count klíči. Pořadí popularity je náhodná permutace klíčů, takže
+ * oblíbené klíče nejsou vložené jako poslední (tj. na začátku seznamů).
+ */
+static int *make_zipf_lookups(int keys_count, int count, double exponent,
+                              uint64_t seed) {
+  double *cdf = malloc(keys_count * sizeof(double));
+  int *rank_to_key = malloc(keys_count * sizeof(int));
+  double sum = 0;
+  for (int i = 0; i < keys_count; i++) {
+    sum += 1 / pow(i + 1, exponent);
+    cdf[i] = sum;
+    rank_to_key[i] = i;
+  }
+  for (int i = keys_count - 1; i > 0; i--) {
+    int j = bench_rand(&seed) % (i + 1);
+    int tmp = rank_to_key[i];
+    rank_to_key[i] = rank_to_key[j];
+    rank_to_key[j] = tmp;
+  }
+
+  int *lookups = malloc(count * sizeof(int));
+  for (int i = 0; i < count; i++) {
+    double u = (bench_rand(&seed) >> 11) * 0x1.0p-53 * sum;
+    int low = 0, high = keys_count - 1;
+    while (low < high) {
+      int mid = (low + high) / 2;
+      if (cdf[mid] < u) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+    lookups[i] = rank_to_key[low];
+  }
+
+  free(cdf);
+  free(rank_to_key);
+  return lookups;
+}
+
+/*
+ * Samoorganizující se seznamy synonym pod Zipf(0.99) pro dlouhé seznamy
+ * (MAX_HT_SIZE seznamů) a pro zaplnění kolem jedné.
+ */
+static void bench_zipf(void) {
+  const int count = 20000, lookups_count = 2000000;
+  const int sizes[] = {MAX_HT_SIZE, count};
+  const htk_reorder_t policies[] = {HTK_REORDER_NONE, HTK_REORDER_MOVE_TO_FRONT,
+                                    HTK_REORDER_TRANSPOSE};
+  char *keys = make_random_keys(count, 99);
+  int *lookups = make_zipf_lookups(count, lookups_count, 0.99, 5);
+  uint64_t sink = 0;
+
+  printf("Zipf(0.99) lookups, %d keys [Mlookups/s]\n", count);
+  printf("%10s %12s %14s %12s\n", "buckets", "none", "move-to-front",
+         "transpose");
+  for (int s = 0; s < 2; s++) {
+    printf("%10d", sizes[s]);
+    for (int p = 0; p < 3; p++) {
+      htk_table_t *table = malloc(sizeof(htk_table_t));
+      htk_options_t opts = {HTK_HASH_SIPHASH, {0, 0}, sizes[s],
+                            HTK_SIZING_PRIME, policies[p]};
+      htk_init(table, &opts);
+      for (int i = 0; i < count; i++) {
+        htk_insert(table, keys + (size_t)i * (KEY_LENGTH + 1), i);
+      }
+
+      double start = now_sec();
+      for (int i = 0; i < lookups_count; i++) {
+        ht_item_t *item =
+            htk_search(table, keys + (size_t)lookups[i] * (KEY_LENGTH + 1));
+        sink += item != NULL;
+      }
+      printf(" %*.2f", p == 1 ? 14 : 12,
+             lookups_count / (now_sec() - start) / 1e6);
+
+      htk_dispose(table);
+      free(table);
+    }
+    printf("\n");
+  }
+  printf("\n");
+
+  free(keys);
+  free(lookups);
+  if (sink == 42) {
+    printf("\n");
+  }
+}
+
+/*
+ * Skutečná velikost bloku z malloc včetně hlavičky alokátoru.
+ */
+static size_t malloc_chunk(void *block, size_t requested) {
+#ifdef __GLIBC__
+  return malloc_usable_size(block) + sizeof(size_t);
+#else
+  return requested;
+#endif
+}
+
+/*
+ * Paměť na jeden prvek pro htk_table_t a htc_table_t s milionem klíčů.
+ * U htk_table_t se počítají i klíče, které tabulka sama nekopíruje, jako
+ * kdyby je volající držel v jednom souvislém poli.
+ */
+static void bench_memory(void) {
+  const int count = 1000000;
+  char *keys = make_random_keys(count, 77);
+  uint64_t sink = 0;
+
+  //classic table, one malloc per item
+  htk_table_t *table = malloc(sizeof(htk_table_t));
+  htk_options_t opts = {HTK_HASH_SIPHASH, {0, 0}, count, HTK_SIZING_POW2};
+  htk_init(table, &opts);
+  for (int i = 0; i < count; i++) {
+    htk_insert(table, keys + (size_t)i * (KEY_LENGTH + 1), i);
+  }
+  size_t classic = (size_t)table->size * sizeof(ht_item_t *) +
+                   (size_t)count * (KEY_LENGTH + 1);
+  for (int i = 0; i < table->size; i++) {
+    for (ht_item_t *item = htk_list(table, i); item != NULL;
+         item = item->next) {
+      classic += malloc_chunk(item, sizeof(ht_item_t));
+    }
+  }
+  double start = now_sec();
+  for (int i = 0; i < count; i++) {
+    sink += htk_get(table, keys + (size_t)i * (KEY_LENGTH + 1)) != NULL;
+  }
+  double classic_rate = count / (now_sec() - start) / 1e6;
+  htk_dispose(table);
+  free(table);
+
+  //compact table, arrays only
+  htc_table_t compact;
+  htc_init(&compact, count);
+  for (int i = 0; i < count; i++) {
+    htc_insert(&compact, keys + (size_t)i * (KEY_LENGTH + 1), i);
+  }
+  size_t packed = htc_memory(&compact);
+  start = now_sec();
+  for (int i = 0; i < count; i++) {
+    sink += htc_get(&compact, keys + (size_t)i * (KEY_LENGTH + 1)) != NULL;
+  }
+  double compact_rate = count / (now_sec() - start) / 1e6;
+  htc_dispose(&compact);
+
+  printf("Memory, %d keys of %d characters\n", count, KEY_LENGTH);
+  printf("%-12s %12s %16s %12s\n", "layout", "bytes/entry", "GB per 200M",
+         "Mlookups/s");
+  printf("%-12s %12.1f %16.1f %12.2f\n", "htk_table_t", (double)classic / count,
+         (double)classic / count * 200e6 / 1e9, classic_rate);
+  printf("%-12s %12.1f %16.1f %12.2f\n\n", "htc_table_t",
+         (double)packed / count, (double)packed / count * 200e6 / 1e9,
+         compact_rate);
+
+  free(keys);
+  if (sink == 42) {
+    printf("\n");
+  }
+}
+
+/*
+ * Vložení deseti milionů klíčů po jednom a hromadně. Klíče jsou odkazy do
+ * jednoho pole, takže se měří hlavně přístupy do tabulky.
+ */
+static void bench_bulk(void) {
+  const int count = 10000000;
+  char *keys = make_random_keys(count, 23);
+  char **pointers = malloc(count * sizeof(char *));
+  float *values = malloc(count * sizeof(float));
+  for (int i = 0; i < count; i++) {
+    pointers[i] = keys + (size_t)i * (KEY_LENGTH + 1);
+    values[i] = i;
+  }
+
+  printf("Insert %d keys into a table of %d lists\n", count, count);
+  printf("%-16s %12s %12s\n", "method", "seconds", "Minserts/s");
+  const char *names[] = {"htk_insert", "bulk 1 thread", "bulk 4 threads"};
+  for (int m = 0; m < 3; m++) {
+    htk_table_t *table = malloc(sizeof(htk_table_t));
+    htk_options_t opts = {HTK_HASH_SIPHASH, {0, 0}, count, HTK_SIZING_POW2,
+                          HTK_REORDER_NONE};
+    htk_init(table, &opts);
+    double start = now_sec();
+    if (m == 0) {
+      for (int i = 0; i < count; i++) {
+        htk_insert(table, pointers[i], values[i]);
+      }
+    } else {
+      htk_insert_bulk(table, pointers, values, count, m == 1 ? 1 : 4);
+    }
+    double seconds = now_sec() - start;
+    printf("%-16s %12.2f %12.2f\n", names[m], seconds, count / seconds / 1e6);
+    htk_dispose(table);
+    free(table);
+  }
+  printf("\n");
+
+  free(values);
+  free(pointers);
+  free(keys);
+}
+
+/*
+ * Rozptylovací hodnoty milionu klíčů: get_hash a htk_siphash po jednom
+ * proti htk_hash_batch s každou sadou instrukcí, potom htk_get proti
+ * htk_get_batch ve velké tabulce.
+ */
+static void bench_hash(void) {
+  const int count = 1000000, rounds = 10;
+  char *keys = make_random_keys(count, 5);
+  char **pointers = malloc(count * sizeof(char *));
+  uint64_t *hashes = malloc(count * sizeof(uint64_t));
+  float **values = malloc(count * sizeof(float *));
+  for (int i = 0; i < count; i++) {
+    pointers[i] = keys + (size_t)i * (KEY_LENGTH + 1);
+  }
+  htk_table_t *table = malloc(sizeof(htk_table_t));
+  htk_options_t opts = {HTK_HASH_SIPHASH, {0, 0}, count, HTK_SIZING_POW2,
+                        HTK_REORDER_NONE};
+  htk_init(table, &opts);
+  uint64_t sink = 0;
+
+  printf("Hash %d keys of %d characters\n", count, KEY_LENGTH);
+  printf("%-24s %12s\n", "method", "Mkeys/s");
+  double start = now_sec();
+  for (int r = 0; r < rounds; r++) {
+    for (int i = 0; i < count; i++) {
+      sink += get_hash(pointers[i]);
+    }
+  }
+  printf("%-24s %12.1f\n", "get_hash loop", rounds * count / (now_sec() - start) / 1e6);
+  start = now_sec();
+  for (int r = 0; r < rounds; r++) {
+    for (int i = 0; i < count; i++) {
+      sink += htk_siphash(table->seed, pointers[i], KEY_LENGTH);
+    }
+  }
+  printf("%-24s %12.1f\n", "htk_siphash loop",
+         rounds * count / (now_sec() - start) / 1e6);
+  const char *names[] = {"htk_hash_batch scalar", "htk_hash_batch SSE2",
+                         "htk_hash_batch AVX2"};
+  for (htk_simd_t simd = HTK_SIMD_SCALAR; simd <= HTK_SIMD_AVX2; simd++) {
+    HTK_SIMD = simd;
+    start = now_sec();
+    for (int r = 0; r < rounds; r++) {
+      htk_hash_batch(table, pointers, count, hashes);
+      sink += hashes[r];
+    }
+    printf("%-24s %12.1f\n", names[simd], rounds * count / (now_sec() - start) / 1e6);
+  }
+  HTK_SIMD = HTK_SIMD_AUTO;
+
+  //lookups in a table far bigger than the cache
+  htk_insert_bulk(table, pointers, (float *)hashes, count, 1);
+  uint64_t state = 3;
+  for (int i = 0; i < count; i++) {
+    int j = bench_rand(&state) % (i + 1);
+    char *tmp = pointers[i];
+    pointers[i] = pointers[j];
+    pointers[j] = tmp;
+  }
+  start = now_sec();
+  for (int i = 0; i < count; i++) {
+    sink += htk_get(table, pointers[i]) != NULL;
+  }
+  printf("%-24s %12.1f\n", "htk_get loop", count / (now_sec() - start) / 1e6);
+  start = now_sec();
+  htk_get_batch(table, pointers, count, values);
+  for (int i = 0; i < count; i++) {
+    sink += values[i] != NULL;
+  }
+  printf("%-24s %12.1f\n\n", "htk_get_batch",
+         count / (now_sec() - start) / 1e6);
+
+  htk_dispose(table);
+  free(table);
+  free(values);
+  free(hashes);
+  free(pointers);
+  free(keys);
+  if (sink == 42) {
+    printf("\n");
+  }
+}
+
+/*
+ * Klíče tří tvarů: krátké burzovní symboly, UUID a čísla v textu. Každý
+ * klíč zabírá width znaků včetně nuly.
+ */
+static char *make_shaped_keys(int shape, int count, int width) {
+  char *keys = malloc((size_t)count * width);
+  uint64_t state = 29 + shape;
+  for (int i = 0; i < count; i++) {
+    char *key = keys + (size_t)i * width;
+    if (shape == 0) {
+      int length = 3 + bench_rand(&state) % 3;
+      for (int j = 0; j < length; j++) {
+        key[j] = 'A' + bench_rand(&state) % 26;
+      }
+      key[length] = '\0';
+    } else if (shape == 1) {
+      uint64_t high = bench_rand(&state), low = bench_rand(&state);
+      snprintf(key, width, "%08x-%04x-%04x-%04x-%012llx",
+               (unsigned)(high >> 32), (unsigned)(high >> 16) & 0xffff,
+               (unsigned)high & 0xffff, (unsigned)(low >> 48),
+               (unsigned long long)(low & UINT64_C(0xffffffffffff)));
+    } else {
+      snprintf(key, width, "%d", 1000000 + i);
+    }
+  }
+  return keys;
+}
+
+/*
+ * Výběr rozptylovací funkce HTK_HASH_AUTO s allow_unkeyed pro tři tvary
+ * klíčů: měření ze vzorku a propustnost vyhledávání se zvolenou funkcí a
+ * se SipHash.
+ */
+static void bench_tune(void) {
+  const int count = 1000000, width = 40;
+  const char *shapes[] = {"tickers", "uuids", "numbers"};
+  const char *names[] = {"sum", "siphash", "fnv1a"};
+  char **pointers = malloc(count * sizeof(char *));
+
+  printf("Hash function choice from %d sampled keys, %d keys per shape\n",
+         HTK_TUNE_SAMPLE, count);
+  printf("%-8s %-8s %10s %10s %10s %10s\n", "keys", "hash", "ns/key",
+         "chains", "chosen", "Mlookups/s");
+  for (int shape = 0; shape < 3; shape++) {
+    char *keys = make_shaped_keys(shape, count, width);
+    for (int i = 0; i < count; i++) {
+      pointers[i] = keys + (size_t)i * width;
+    }
+
+    htk_hash_mode_t modes[] = {HTK_HASH_AUTO, HTK_HASH_SIPHASH};
+    for (int m = 0; m < 2; m++) {
+      htk_table_t *table = malloc(sizeof(htk_table_t));
+      htk_options_t opts = {modes[m], {0, 0}, count, HTK_SIZING_POW2,
+                            HTK_REORDER_NONE, HTK_PAGES_NORMAL, true};
+      htk_init(table, &opts);
+      for (int i = 0; i < count; i++) {
+        htk_insert(table, pointers[i], i);
+      }
+      double start = now_sec();
+      float sum = 0;
+      for (int i = 0; i < count; i++) {
+        float *value = htk_get(table, pointers[i]);
+        sum += value != NULL ? *value : 0;
+      }
+      double rate = sum < 0 ? 0 : count / (now_sec() - start) / 1e6;
+
+      htk_stats_t stats;
+      htk_stats(table, &stats);
+      if (modes[m] == HTK_HASH_AUTO) {
+        for (int h = HTK_HASH_SUM; h < HTK_HASH_AUTO; h++) {
+          printf("%-8s %-8s %10.2f %10.2f %10s\n", shapes[shape], names[h],
+                 stats.tuning.ns_per_key[h], stats.tuning.chain_ratio[h],
+                 h == (int)stats.hash ? "yes" : "");
+        }
+      }
+      printf("%-8s %-8s %10s %10.2f %10s %10.2f\n", shapes[shape],
+             modes[m] == HTK_HASH_AUTO ? "auto" : "siphash", "",
+             stats.chain_ratio, names[stats.hash], rate);
+      htk_dispose(table);
+      free(table);
+    }
+    free(keys);
+  }
+  printf("\n");
+  free(pointers);
+}
+
+/*
+ * Čítač výpadků datové TLB při čtení v tomto procesu, -1 pokud ho jádro
+ * nedovolí (perf_event_paranoid, kontejner, virtuální stroj bez PMU).
+ */
+static int tlb_counter_open(void) {
+#ifdef __linux__
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HW_CACHE;
+  attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+  return -1;
+#endif
+}
+
+static void tlb_counter_start(int fd) {
+#ifdef __linux__
+  if (fd >= 0) {
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+#endif
+}
+
+static long long tlb_counter_stop(int fd) {
+  long long count = -1;
+#ifdef __linux__
+  if (fd >= 0) {
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(fd, &count, sizeof(count)) != sizeof(count)) {
+      count = -1;
+    }
+  }
+#endif
+  return count;
+}
+
+/*
+ * Náhodné vyhledávání ve velké tabulce s prvky na obyčejných a na velkých
+ * stránkách: čas a výpadky datové TLB na jedno vyhledání.
+ */
+static void bench_tlb(void) {
+  const int count = 4000000;
+  char *keys = make_random_keys(count, 23);
+  int *order = malloc(count * sizeof(int));
+  uint64_t state = 11;
+  for (int i = 0; i < count; i++) {
+    order[i] = bench_rand(&state) % count;
+  }
+  const char *names[] = {"normal", "transparent", "explicit"};
+  int fd = tlb_counter_open();
+
+  printf("Random lookups in %d keys on huge pages%s\n", count,
+         fd < 0 ? ", dTLB counter not available" : "");
+  printf("%-12s %-12s %12s %16s\n", "requested", "buckets", "ns/lookup",
+         "dTLB misses/op");
+  for (htk_pages_t pages = HTK_PAGES_NORMAL; pages <= HTK_PAGES_EXPLICIT;
+       pages++) {
+    htk_table_t *table = malloc(sizeof(htk_table_t));
+    htk_options_t opts = {HTK_HASH_SIPHASH, {0, 0}, count, HTK_SIZING_POW2,
+                          HTK_REORDER_NONE, pages};
+    htk_init(table, &opts);
+    for (int i = 0; i < count; i++) {
+      htk_insert(table, keys + (size_t)i * (KEY_LENGTH + 1), i);
+    }
+
+    float sum = 0;
+    tlb_counter_start(fd);
+    double start = now_sec();
+    for (int i = 0; i < count; i++) {
+      float *value = htk_get(table, keys + (size_t)order[i] * (KEY_LENGTH + 1));
+      sum += value != NULL ? *value : 0;
+    }
+    double elapsed = now_sec() - start;
+    long long misses = tlb_counter_stop(fd);
+
+    printf("%-12s %-12s %12.1f", names[pages], names[table->items_pages],
+           sum < 0 ? 0 : elapsed / count * 1e9);
+    if (misses >= 0) {
+      printf(" %16.2f\n", (double)misses / count);
+    } else {
+      printf(" %16s\n", "n/a");
+    }
+    htk_dispose(table);
+    free(table);
+  }
+  printf("\n");
+
+  if (fd >= 0) {
+    close(fd);
+  }
+  free(order);
+  free(keys);
+}
+
+// Počty výskytů pro compare_counts_desc
+static const int *sorted_counts;
+
+static int compare_counts_desc(const void *a, const void *b) {
+  int x = sorted_counts[*(const int *)a], y = sorted_counts[*(const int *)b];
+  return (x < y) - (x > y);
+}
+
+/*
+ * Počítání výskytů klíčů se Zipfovým rozdělením: přesně v tabulce a
+ * přibližně ve sketchi s pevnou pamětí. Porovná paměť, rychlost, shodu
+ * sta nejčastějších klíčů a chybu odhadů.
+ */
+static void bench_sketch(void) {
+  const int keys_count = 1000000, events = 10000000, k = 100;
+  const size_t budget = (1 << 20) + k * sizeof(ht_sketch_entry_t);
+  char *keys = make_random_keys(keys_count, 61);
+  int *stream = make_zipf_lookups(keys_count, events, 1.1, 8);
+  int *counts = calloc(keys_count, sizeof(int));
+  for (int i = 0; i < events; i++) {
+    counts[stream[i]]++;
+  }
+
+  //exact counts, one item per distinct key
+  htk_table_t *table = malloc(sizeof(htk_table_t));
+  htk_options_t opts = {HTK_HASH_SIPHASH, {0, 0}, keys_count, HTK_SIZING_POW2};
+  htk_init(table, &opts);
+  double start = now_sec();
+  for (int i = 0; i < events; i++) {
+    char *key = keys + (size_t)stream[i] * (KEY_LENGTH + 1);
+    float *value = htk_get(table, key);
+    if (value != NULL) {
+      (*value)++;
+    } else {
+      htk_insert(table, key, 1);
+    }
+  }
+  double exact_rate = events / (now_sec() - start) / 1e6;
+  size_t distinct = 0;
+  for (int i = 0; i < keys_count; i++) {
+    distinct += counts[i] > 0;
+  }
+  size_t exact_memory = (size_t)table->size * sizeof(ht_item_t *) +
+                        distinct * (sizeof(ht_item_t) + KEY_LENGTH + 1);
+  htk_dispose(table);
+  free(table);
+
+  ht_sketch_t sketch;
+  ht_sketch_init(&sketch, budget, k, NULL);
+  start = now_sec();
+  for (int i = 0; i < events; i++) {
+    ht_sketch_increment(&sketch, keys + (size_t)stream[i] * (KEY_LENGTH + 1), 1);
+  }
+  double sketch_rate = events / (now_sec() - start) / 1e6;
+
+  //the true top k against the heap of the sketch
+  int *order = malloc(keys_count * sizeof(int));
+  for (int i = 0; i < keys_count; i++) {
+    order[i] = i;
+  }
+  sorted_counts = counts;
+  qsort(order, keys_count, sizeof(int), compare_counts_desc);
+  ht_sketch_entry_t *top = malloc(k * sizeof(ht_sketch_entry_t));
+  int n = ht_sketch_top_k(&sketch, top, k);
+  int hits = 0;
+  double top_error = 0;
+  for (int i = 0; i < k; i++) {
+    char *key = keys + (size_t)order[i] * (KEY_LENGTH + 1);
+    for (int j = 0; j < n; j++) {
+      hits += strcmp(top[j].key, key) == 0;
+    }
+    top_error += (double)(ht_sketch_estimate(&sketch, key) - counts[order[i]]) /
+                 counts[order[i]];
+  }
+  double over = 0;
+  for (int i = 0; i < keys_count; i++) {
+    if (counts[i] > 0) {
+      over += ht_sketch_estimate(&sketch, keys + (size_t)i * (KEY_LENGTH + 1)) -
+              counts[i];
+    }
+  }
+
+  printf("Counting %d Zipf events over %zu distinct keys\n", events, distinct);
+  printf("%-8s %12s %12s\n", "method", "memory [MB]", "Mevents/s");
+  printf("%-8s %12.1f %12.2f\n", "table", exact_memory / 1e6, exact_rate);
+  printf("%-8s %12.1f %12.2f\n", "sketch", ht_sketch_memory(&sketch) / 1e6,
+         sketch_rate);
+  printf("top %d recall %.2f, mean error in top %d %.4f%%, mean overcount %.2f\n\n",
+         k, (double)hits / k, k, top_error / k * 100, over / distinct);
+
+  ht_sketch_dispose(&sketch);
+  free(top);
+  free(order);
+  free(counts);
+  free(stream);
+  free(keys);
+}
+
+// Zdroj dávek nad polem klíčů pro bench_join
+typedef struct key_source {
+  char *keys;        // klíče za sebou po KEY_LENGTH + 1 znacích
+  const int *order;  // pořadí klíčů, NULL znamená postupně
+  int count;         // počet řádků
+  int position;      // další řádek
+} key_source_t;
+
+static int key_source_next(void *context, ht_batch_t *batch) {
+  key_source_t *source = context;
+  batch->count = 0;
+  while (source->position < source->count && batch->count < HT_BATCH_SIZE) {
+    int i = source->order ? source->order[source->position] : source->position;
+    batch->keys[batch->count] = source->keys + (size_t)i * (KEY_LENGTH + 1);
+    batch->values[batch->count] = i;
+    batch->count++;
+    source->position++;
+  }
+  return batch->count;
+}
+
+static void count_matches(void *context, const ht_matches_t *matches) {
+  *(size_t *)context += matches->count;
+}
+
+/*
+ * Spojení milionu řádků se čtyřmi miliony zkoušených řádků, polovina
+ * z nich má pár. Porovnává jednu velkou tabulku s tabulkami po oddílech.
+ */
+static void bench_join(void) {
+  const int build = 1000000, probes = 4000000;
+  char *keys = make_random_keys(2 * build, 91);
+  int *order = malloc(probes * sizeof(int));
+  uint64_t state = 17;
+  for (int i = 0; i < probes; i++) {
+    order[i] = bench_rand(&state) % (2 * build);
+  }
+
+  printf("Hash join, %d build rows, %d probe rows in batches of %d\n", build,
+         probes, HT_BATCH_SIZE);
+  printf("%-12s %12s %12s %14s\n", "layout", "partitions", "build [s]",
+         "Mprobes/s");
+  const char *names[] = {"one table", "partitioned"};
+  size_t budgets[] = {SIZE_MAX, HT_JOIN_CACHE_BYTES};
+  for (int b = 0; b < 2; b++) {
+    ht_join_t join;
+    ht_join_init(&join, budgets[b]);
+    key_source_t source = {keys, NULL, build, 0};
+    double start = now_sec();
+    ht_build_from_stream(&join, key_source_next, &source);
+    double built = now_sec() - start;
+
+    key_source_t probe = {keys, order, probes, 0};
+    size_t matches = 0;
+    start = now_sec();
+    ht_probe_stream(&join, key_source_next, &probe, count_matches, &matches);
+    double rate = probes / (now_sec() - start) / 1e6;
+    printf("%-12s %12d %12.2f %14.2f\n", names[b], join.partitions, built,
+           rate);
+    if (matches == 0) {
+      printf("No matches!\n");
+    }
+    ht_join_dispose(&join);
+  }
+  printf("\n");
+
+  free(order);
+  free(keys);
+}
+
+typedef struct bench {
+  const char *name;
+  void (*run)(void);
+} bench_t;
+
+static const bench_t BENCHES[] = {
+    {"flood", bench_flood},
+    {"modulo", bench_modulo},
+    {"zipf", bench_zipf},
+    {"memory", bench_memory},
+    {"join", bench_join},
+    {"bulk", bench_bulk},
+    {"hash", bench_hash},
+    {"tune", bench_tune},
+    {"tlb", bench_tlb},
+    {"sketch", bench_sketch},
+};
+
+int main(int argc, char *argv[]) {
+  int count = sizeof(BENCHES) / sizeof(BENCHES[0]);
+
+  for (int i = 0; i < count; i++) {
+    bool selected = argc == 1;
+    for (int j = 1; j < argc; j++) {
+      selected = selected || strcmp(argv[j], BENCHES[i].name) == 0;
+    }
+    if (selected) {
+      BENCHES[i].run();
+    }
+  }
+  return 0;
+}
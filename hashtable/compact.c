@@ -0,0 +1,317 @@
+/*
+ * Kompaktní tabulka s rozptýlenými položkami
+ *
+ * Varianta tabulky pro stovky milionů klíčů. Místo samostatně alokovaných
+ * prvků s 64-bitovými ukazateli používá jedno pole prvků s 32-bitovými
+ * indexy a jedno pole znaků se všemi klíči. Rozptylovací funkce je
+ * SipHash s náhodným klíčem tabulky, velikost je mocnina dvou a tabulka se
+ * při zaplnění nad jedna zdvojnásobí.
+ *
+ * Ukazatele vrácené funkcemi htc_search a htc_get platí jen do dalšího
+ * vložení prvku, pole prvků se při růstu realokuje.
+ */
+
+#include "compact.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Index seznamu synonym pro klíč délky len.
+ */
+static uint32_t htc_bucket(const htc_table_t *table, const char *key,
+                           size_t len) {
+  return htk_siphash(table->seed, key, len) & (table->size - 1);
+}
+
+/*
+ * Inicializace tabulky.
+ *
+ * Velikost se zaokrouhlí nahoru na mocninu dvou. Vrací false, pokud se
+ * nepodaří alokovat pole seznamů.
+ */
+bool htc_init(htc_table_t *table, uint32_t size) {
+
+  //round the size up to a power of two
+  uint32_t pow2 = 1;
+  while (pow2 < size && pow2 < (UINT32_C(1) << 31)) {
+    pow2 *= 2;
+  }
+
+  //all the lists are empty
+  table->buckets = malloc(pow2 * sizeof(uint32_t));
+  if (table->buckets == NULL) {
+    return false;
+  }
+  memset(table->buckets, 0xff, pow2 * sizeof(uint32_t));
+  table->size = pow2;
+
+  //no items and no keys yet
+  table->items = NULL;
+  table->used = 0;
+  table->capacity = 0;
+  table->count = 0;
+  table->free = HTC_NIL;
+  table->keys = NULL;
+  table->keys_used = 0;
+  table->keys_capacity = 0;
+  table->keys_dead = 0;
+  htk_random_seed(table->seed);
+  return true;
+}
+
+/*
+ * Vyhledání prvku v tabulce.
+ *
+ * V případě úspěchu vrací ukazatel na nalezený prvek; v opačném případě vrací
+ * hodnotu NULL.
+ */
+htc_item_t *htc_search(htc_table_t *table, const char *key) {
+  uint32_t index = table->buckets[htc_bucket(table, key, strlen(key))];
+
+  //search in the list by indices
+  while (index != HTC_NIL) {
+    htc_item_t *item = &table->items[index];
+    if (strcmp(table->keys + item->key, key) == 0) {
+      return item;
+    }
+    index = item->next;
+  }
+
+  return NULL;
+}
+
+/*
+ * Zdvojnásobí počet seznamů a znovu zařadí všechny prvky.
+ */
+static void htc_grow_buckets(htc_table_t *table) {
+  uint32_t size = table->size * 2;
+  uint32_t *buckets = realloc(table->buckets, size * sizeof(uint32_t));
+  if (buckets == NULL) {
+    return;
+  }
+  memset(buckets, 0xff, size * sizeof(uint32_t));
+  table->buckets = buckets;
+  table->size = size;
+
+  //relink every item that is in use
+  for (uint32_t i = 0; i < table->used; i++) {
+    htc_item_t *item = &table->items[i];
+    if (item->key == HTC_NIL) {
+      continue;
+    }
+    const char *key = table->keys + item->key;
+    uint32_t bucket = htc_bucket(table, key, strlen(key));
+    item->next = buckets[bucket];
+    buckets[bucket] = i;
+  }
+}
+
+/*
+ * Přesune klíče existujících prvků na začátek pole klíčů, čímž uvolní
+ * místo po klíčích smazaných prvků.
+ */
+static void htc_compact_keys(htc_table_t *table) {
+  char *keys = malloc(table->keys_capacity);
+  if (keys == NULL) {
+    return;
+  }
+
+  uint32_t used = 0;
+  for (uint32_t i = 0; i < table->used; i++) {
+    htc_item_t *item = &table->items[i];
+    if (item->key == HTC_NIL) {
+      continue;
+    }
+    size_t length = strlen(table->keys + item->key) + 1;
+    memcpy(keys + used, table->keys + item->key, length);
+    item->key = used;
+    used += length;
+  }
+
+  free(table->keys);
+  table->keys = keys;
+  table->keys_used = used;
+  table->keys_dead = 0;
+}
+
+/*
+ * Zkopíruje klíč do pole klíčů a vrátí jeho posun, nebo HTC_NIL, pokud
+ * na něj není místo.
+ */
+static uint32_t htc_store_key(htc_table_t *table, const char *key) {
+  size_t length = strlen(key) + 1;
+
+  //reuse the space of deleted keys before growing
+  if (table->keys_used + length > table->keys_capacity &&
+      table->keys_dead >= table->keys_used / 2) {
+    htc_compact_keys(table);
+  }
+
+  if (table->keys_used + length > table->keys_capacity) {
+    uint64_t capacity = table->keys_capacity ? table->keys_capacity : 256;
+    while (capacity < table->keys_used + length) {
+      capacity *= 2;
+    }
+    if (capacity > UINT32_MAX) {
+      capacity = UINT32_MAX;
+    }
+    if (table->keys_used + length > capacity) {
+      return HTC_NIL;
+    }
+
+    char *keys = realloc(table->keys, capacity);
+    if (keys == NULL) {
+      return HTC_NIL;
+    }
+    table->keys = keys;
+    table->keys_capacity = capacity;
+  }
+
+  uint32_t offset = table->keys_used;
+  memcpy(table->keys + offset, key, length);
+  table->keys_used += length;
+  return offset;
+}
+
+/*
+ * Vrátí index volného prvku, nebo HTC_NIL, pokud žádný není.
+ */
+static uint32_t htc_alloc_item(htc_table_t *table) {
+
+  //take a deleted item first
+  if (table->free != HTC_NIL) {
+    uint32_t index = table->free;
+    table->free = table->items[index].next;
+    return index;
+  }
+
+  //grow the array of items
+  if (table->used == table->capacity) {
+    uint64_t capacity = table->capacity ? (uint64_t)table->capacity * 2 : 16;
+    if (capacity > HTC_NIL) {
+      capacity = HTC_NIL;
+    }
+    if (capacity == table->capacity) {
+      return HTC_NIL;
+    }
+
+    htc_item_t *items = realloc(table->items, capacity * sizeof(htc_item_t));
+    if (items == NULL) {
+      return HTC_NIL;
+    }
+    table->items = items;
+    table->capacity = capacity;
+  }
+
+  return table->used++;
+}
+
+/*
+ * Vložení nového prvku do tabulky.
+ *
+ * Pokud prvek s daným klíčem už v tabulce existuje, nahradí se jeho hodnota.
+ * Klíč se do tabulky kopíruje. Pokud se nepodaří alokovat paměť, tabulka
+ * zůstane beze změny.
+ */
+void htc_insert(htc_table_t *table, const char *key, float value) {
+
+  //if the item is found, change its value
+  htc_item_t *found = htc_search(table, key);
+  if (found != NULL) {
+    found->value = value;
+    return;
+  }
+
+  //keep the load factor at most one
+  if (table->count >= table->size && table->size < (UINT32_C(1) << 31)) {
+    htc_grow_buckets(table);
+  }
+
+  //store the key, then take an item
+  uint32_t offset = htc_store_key(table, key);
+  if (offset == HTC_NIL) {
+    return;
+  }
+  uint32_t index = htc_alloc_item(table);
+  if (index == HTC_NIL) {
+    table->keys_used = offset;
+    return;
+  }
+
+  //add the new item to the beginning of the list
+  uint32_t bucket = htc_bucket(table, key, strlen(key));
+  htc_item_t *item = &table->items[index];
+  item->key = offset;
+  item->value = value;
+  item->next = table->buckets[bucket];
+  table->buckets[bucket] = index;
+  table->count++;
+}
+
+/*
+ * Získání hodnoty z tabulky.
+ *
+ * V případě úspěchu vrací funkce ukazatel na hodnotu prvku, v opačném
+ * případě hodnotu NULL.
+ */
+float *htc_get(htc_table_t *table, const char *key) {
+  htc_item_t *item = htc_search(table, key);
+  return item != NULL ? &item->value : NULL;
+}
+
+/*
+ * Smazání prvku z tabulky.
+ *
+ * Prvek se vrátí do seznamu volných prvků, místo po jeho klíči se uvolní při
+ * příštím setřesení pole klíčů. Pokud prvek neexistuje, funkce nedělá nic.
+ */
+void htc_delete(htc_table_t *table, const char *key) {
+  size_t length = strlen(key);
+  uint32_t *link = &table->buckets[htc_bucket(table, key, length)];
+
+  //find the link that points to the item
+  while (*link != HTC_NIL) {
+    htc_item_t *item = &table->items[*link];
+    if (strcmp(table->keys + item->key, key) == 0) {
+      uint32_t index = *link;
+      *link = item->next;
+
+      //put the item on the free list
+      item->key = HTC_NIL;
+      item->next = table->free;
+      table->free = index;
+      table->keys_dead += length + 1;
+      table->count--;
+      return;
+    }
+    link = &item->next;
+  }
+}
+
+/*
+ * Zrušení tabulky a uvolnění všech jejích polí.
+ */
+void htc_dispose(htc_table_t *table) {
+  free(table->buckets);
+  free(table->items);
+  free(table->keys);
+  table->buckets = NULL;
+  table->items = NULL;
+  table->keys = NULL;
+  table->size = 0;
+  table->used = 0;
+  table->capacity = 0;
+  table->count = 0;
+  table->free = HTC_NIL;
+  table->keys_used = 0;
+  table->keys_capacity = 0;
+  table->keys_dead = 0;
+}
+
+/*
+ * Počet bajtů alokovaných pro tabulku včetně klíčů.
+ */
+size_t htc_memory(const htc_table_t *table) {
+  return (size_t)table->size * sizeof(uint32_t) +
+         (size_t)table->capacity * sizeof(htc_item_t) + table->keys_capacity;
+}
@@ -0,0 +1,48 @@
+/*
+ * Hlavičkový súbor pre kompaktnú tabuľku s rozptýlenými položkami.
+ *
+ * Prvky sú v jednom súvislom poli a odkazujú na seba 32-bitovými indexmi,
+ * kľúče sú skopírované za sebou do spoločného poľa znakov. Prvok má 12 bajtov
+ * namiesto 24 bajtov ht_item_t a samostatnej alokácie pre každý prvok.
+ */
+
+#ifndef IAL_HASHTABLE_COMPACT_H
+#define IAL_HASHTABLE_COMPACT_H
+
+#include "keyed.h"
+
+// Index, ktorý neukazuje na žiadny prvok
+#define HTC_NIL UINT32_MAX
+
+// Prvok kompaktnej tabuľky
+typedef struct htc_item {
+  uint32_t key;  // posun kľúča v poli keys, HTC_NIL pre voľný prvok
+  uint32_t next; // index ďalšieho synonyma alebo HTC_NIL
+  float value;   // hodnota prvku
+} htc_item_t;
+
+// Kompaktná tabuľka
+typedef struct htc_table {
+  uint32_t *buckets;      // index prvého synonyma každého zoznamu
+  uint32_t size;          // počet zoznamov, mocnina dvoch
+  htc_item_t *items;      // všetky prvky
+  uint32_t used;          // počet použitých prvkov poľa items
+  uint32_t capacity;      // počet alokovaných prvkov poľa items
+  uint32_t count;         // počet prvkov v tabuľke
+  uint32_t free;          // zoznam uvoľnených prvkov
+  char *keys;             // kľúče ukončené nulou, za sebou
+  uint32_t keys_used;     // použité bajty poľa keys
+  uint32_t keys_capacity; // alokované bajty poľa keys
+  uint32_t keys_dead;     // bajty kľúčov zmazaných prvkov
+  uint64_t seed[2];       // kľúč rozptylovacej funkcie
+} htc_table_t;
+
+bool htc_init(htc_table_t *table, uint32_t size);
+htc_item_t *htc_search(htc_table_t *table, const char *key);
+void htc_insert(htc_table_t *table, const char *key, float value);
+float *htc_get(htc_table_t *table, const char *key);
+void htc_delete(htc_table_t *table, const char *key);
+void htc_dispose(htc_table_t *table);
+size_t htc_memory(const htc_table_t *table);
+
+#endif
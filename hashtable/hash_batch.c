@@ -0,0 +1,317 @@
+/*
+ * Dávkový výpočet rozptylovací funkce
+ *
+ * SipHash jednoho krátkého klíče je řetěz závislých operací.
+ * htk_hash_batch proto počítá několik klíčů najednou, každý v jednom
+ * 64-bitovém pruhu vektorového registru, a dvě nezávislé sady registrů
+ * prokládá: osm klíčů s AVX2, čtyři s SSE2. Klíče mohou mít různou
+ * délku, pruh, jehož klíč už skončil, si ponechá stav přes masku.
+ *
+ * Výsledek je vždy stejný jako u htk_siphash. Vektorová jádra se používají
+ * jen na vyžádání přes HTK_SIMD: SSE2 nemá rotaci ani porovnání
+ * 64-bitových čísel a se dvěma pruhy prohrává se skalárním kódem, AVX2 je
+ * rychlejší jen na některých procesorech a jinde o několik procent
+ * pomalejší. Instrukce procesoru se zjistí jednou při zavedení programu,
+ * jádro se pak jen vybere z konstantní tabulky bez zápisu do globálních
+ * proměnných, takže dávky mohou běžet ve více vláknech.
+ */
+
+#include "keyed.h"
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HTK_X86 1
+#include <immintrin.h>
+#endif
+
+htk_simd_t HTK_SIMD = HTK_SIMD_AUTO;
+
+static const uint64_t SIP_INIT[4] = {
+    UINT64_C(0x736f6d6570736575), UINT64_C(0x646f72616e646f6d),
+    UINT64_C(0x6c7967656e657261), UINT64_C(0x7465646279746573)};
+
+/*
+ * Blok number klíče délky len. Plné bloky se čtou přímo, poslední blok
+ * obsahuje zbylé bajty a délku klíče jako u htk_siphash, za ním jsou nuly.
+ */
+static inline uint64_t sip_block(const char *key, size_t len,
+                                 size_t number) {
+  uint64_t m = 0;
+  if (number > len / 8) {
+    return 0;
+  }
+  if (number < len / 8) {
+    memcpy(&m, key + 8 * number, sizeof(m));
+    return m;
+  }
+  m = (uint64_t)len << 56;
+  for (size_t i = 0; i < (len & 7); i++) {
+    m |= (uint64_t)(unsigned char)key[8 * number + i] << (8 * i);
+  }
+  return m;
+}
+
+#ifdef HTK_X86
+
+#define ROTL256(x, b)                                                          \
+  _mm256_or_si256(_mm256_slli_epi64(x, b), _mm256_srli_epi64(x, 64 - (b)))
+#define ROTL256_32(x) _mm256_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1))
+#define ROTL256_16(x)                                                          \
+  _mm256_shuffle_epi8(x, _mm256_set_epi8(13, 12, 11, 10, 9, 8, 15, 14, 5, 4,  \
+                                         3, 2, 1, 0, 7, 6, 13, 12, 11, 10, 9, \
+                                         8, 15, 14, 5, 4, 3, 2, 1, 0, 7, 6))
+
+#define SIPROUND256(v0, v1, v2, v3)                                            \
+  do {                                                                         \
+    v0 = _mm256_add_epi64(v0, v1);                                             \
+    v1 = ROTL256(v1, 13);                                                      \
+    v1 = _mm256_xor_si256(v1, v0);                                             \
+    v0 = ROTL256_32(v0);                                                       \
+    v2 = _mm256_add_epi64(v2, v3);                                             \
+    v3 = ROTL256_16(v3);                                                       \
+    v3 = _mm256_xor_si256(v3, v2);                                             \
+    v0 = _mm256_add_epi64(v0, v3);                                             \
+    v3 = ROTL256(v3, 21);                                                      \
+    v3 = _mm256_xor_si256(v3, v0);                                             \
+    v2 = _mm256_add_epi64(v2, v1);                                             \
+    v1 = ROTL256(v1, 17);                                                      \
+    v1 = _mm256_xor_si256(v1, v2);                                             \
+    v2 = ROTL256_32(v2);                                                       \
+  } while (0)
+
+/*
+ * SipHash-1-3 osmi klíčů ve dvou sadách pruhů AVX2. Dvě nezávislé sady
+ * se prokládají, takže procesor nečeká na výsledek předchozí instrukce.
+ */
+__attribute__((target("avx2"))) static void
+siphash_avx2(const uint64_t seed[2], char **keys, uint64_t *out) {
+  size_t len[8], low = SIZE_MAX, high = 0;
+  for (int lane = 0; lane < 8; lane++) {
+    len[lane] = strlen(keys[lane]);
+    low = len[lane] < low ? len[lane] : low;
+    high = len[lane] > high ? len[lane] : high;
+  }
+
+  __m256i v[2][4], last[2];
+  for (int g = 0; g < 2; g++) {
+    v[g][0] = _mm256_set1_epi64x(seed[0] ^ SIP_INIT[0]);
+    v[g][1] = _mm256_set1_epi64x(seed[1] ^ SIP_INIT[1]);
+    v[g][2] = _mm256_set1_epi64x(seed[0] ^ SIP_INIT[2]);
+    v[g][3] = _mm256_set1_epi64x(seed[1] ^ SIP_INIT[3]);
+    last[g] = _mm256_set_epi64x(len[4 * g + 3] / 8, len[4 * g + 2] / 8,
+                                len[4 * g + 1] / 8, len[4 * g] / 8);
+  }
+
+  //block k of every lane, lanes past their last block keep the state
+  for (size_t k = 0; k <= high / 8; k++) {
+    for (int g = 0; g < 2; g++) {
+      char **group = keys + 4 * g;
+      size_t *lengths = len + 4 * g;
+      __m256i vm = _mm256_set_epi64x(sip_block(group[3], lengths[3], k),
+                                     sip_block(group[2], lengths[2], k),
+                                     sip_block(group[1], lengths[1], k),
+                                     sip_block(group[0], lengths[0], k));
+      __m256i o0 = v[g][0], o1 = v[g][1], o2 = v[g][2], o3 = v[g][3];
+
+      v[g][3] = _mm256_xor_si256(v[g][3], vm);
+      SIPROUND256(v[g][0], v[g][1], v[g][2], v[g][3]);
+      v[g][0] = _mm256_xor_si256(v[g][0], vm);
+
+      //mask is all ones in the lanes past their last block
+      if (k > low / 8) {
+        __m256i mask = _mm256_cmpgt_epi64(_mm256_set1_epi64x(k), last[g]);
+        v[g][0] = _mm256_blendv_epi8(v[g][0], o0, mask);
+        v[g][1] = _mm256_blendv_epi8(v[g][1], o1, mask);
+        v[g][2] = _mm256_blendv_epi8(v[g][2], o2, mask);
+        v[g][3] = _mm256_blendv_epi8(v[g][3], o3, mask);
+      }
+    }
+  }
+
+  //finalization is the same for all the lanes
+  for (int g = 0; g < 2; g++) {
+    v[g][2] = _mm256_xor_si256(v[g][2], _mm256_set1_epi64x(0xff));
+  }
+  for (int r = 0; r < 3; r++) {
+    SIPROUND256(v[0][0], v[0][1], v[0][2], v[0][3]);
+    SIPROUND256(v[1][0], v[1][1], v[1][2], v[1][3]);
+  }
+  for (int g = 0; g < 2; g++) {
+    __m256i hash = _mm256_xor_si256(_mm256_xor_si256(v[g][0], v[g][1]),
+                                    _mm256_xor_si256(v[g][2], v[g][3]));
+    _mm256_storeu_si256((__m256i *)(out + 4 * g), hash);
+  }
+}
+
+#define ROTL128(x, b)                                                          \
+  _mm_or_si128(_mm_slli_epi64(x, b), _mm_srli_epi64(x, 64 - (b)))
+#define ROTL128_32(x) _mm_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1))
+
+#define SIPROUND128(v0, v1, v2, v3)                                            \
+  do {                                                                         \
+    v0 = _mm_add_epi64(v0, v1);                                                \
+    v1 = ROTL128(v1, 13);                                                      \
+    v1 = _mm_xor_si128(v1, v0);                                                \
+    v0 = ROTL128_32(v0);                                                       \
+    v2 = _mm_add_epi64(v2, v3);                                                \
+    v3 = ROTL128(v3, 16);                                                      \
+    v3 = _mm_xor_si128(v3, v2);                                                \
+    v0 = _mm_add_epi64(v0, v3);                                                \
+    v3 = ROTL128(v3, 21);                                                      \
+    v3 = _mm_xor_si128(v3, v0);                                                \
+    v2 = _mm_add_epi64(v2, v1);                                                \
+    v1 = ROTL128(v1, 17);                                                      \
+    v1 = _mm_xor_si128(v1, v2);                                                \
+    v2 = ROTL128_32(v2);                                                       \
+  } while (0)
+
+// Výběr podle masky bez SSE4.1
+#define SELECT128(mask, new, old)                                              \
+  _mm_or_si128(_mm_and_si128(mask, new), _mm_andnot_si128(mask, old))
+
+/*
+ * SipHash-1-3 čtyř klíčů ve dvou sadách pruhů SSE2, prokládaných stejně
+ * jako u AVX2.
+ */
+__attribute__((target("sse2"))) static void
+siphash_sse2(const uint64_t seed[2], char **keys, uint64_t *out) {
+  size_t len[4], low = SIZE_MAX, high = 0;
+  for (int lane = 0; lane < 4; lane++) {
+    len[lane] = strlen(keys[lane]);
+    low = len[lane] < low ? len[lane] : low;
+    high = len[lane] > high ? len[lane] : high;
+  }
+
+  __m128i v[2][4];
+  for (int g = 0; g < 2; g++) {
+    v[g][0] = _mm_set1_epi64x(seed[0] ^ SIP_INIT[0]);
+    v[g][1] = _mm_set1_epi64x(seed[1] ^ SIP_INIT[1]);
+    v[g][2] = _mm_set1_epi64x(seed[0] ^ SIP_INIT[2]);
+    v[g][3] = _mm_set1_epi64x(seed[1] ^ SIP_INIT[3]);
+  }
+
+  for (size_t k = 0; k <= high / 8; k++) {
+    for (int g = 0; g < 2; g++) {
+      char **group = keys + 2 * g;
+      size_t *lengths = len + 2 * g;
+      __m128i vm = _mm_set_epi64x(sip_block(group[1], lengths[1], k),
+                                  sip_block(group[0], lengths[0], k));
+      __m128i o0 = v[g][0], o1 = v[g][1], o2 = v[g][2], o3 = v[g][3];
+
+      v[g][3] = _mm_xor_si128(v[g][3], vm);
+      SIPROUND128(v[g][0], v[g][1], v[g][2], v[g][3]);
+      v[g][0] = _mm_xor_si128(v[g][0], vm);
+
+      //no 64-bit compare in SSE2, the mask is built from the lengths
+      if (k > low / 8) {
+        __m128i mask = _mm_set_epi64x(k <= lengths[1] / 8 ? -1 : 0,
+                                      k <= lengths[0] / 8 ? -1 : 0);
+        v[g][0] = SELECT128(mask, v[g][0], o0);
+        v[g][1] = SELECT128(mask, v[g][1], o1);
+        v[g][2] = SELECT128(mask, v[g][2], o2);
+        v[g][3] = SELECT128(mask, v[g][3], o3);
+      }
+    }
+  }
+
+  for (int g = 0; g < 2; g++) {
+    v[g][2] = _mm_xor_si128(v[g][2], _mm_set1_epi64x(0xff));
+  }
+  for (int r = 0; r < 3; r++) {
+    SIPROUND128(v[0][0], v[0][1], v[0][2], v[0][3]);
+    SIPROUND128(v[1][0], v[1][1], v[1][2], v[1][3]);
+  }
+  for (int g = 0; g < 2; g++) {
+    __m128i hash = _mm_xor_si128(_mm_xor_si128(v[g][0], v[g][1]),
+                                 _mm_xor_si128(v[g][2], v[g][3]));
+    _mm_storeu_si128((__m128i *)(out + 2 * g), hash);
+  }
+}
+
+#endif
+
+#ifdef HTK_X86
+
+// Jádro pro několik klíčů najednou, NULL pro skalární kód
+typedef struct htk_kernel {
+  void (*hash)(const uint64_t seed[2], char **keys, uint64_t *out);
+  size_t lanes; // počet klíčů jednoho volání
+} htk_kernel_t;
+
+// Jádra indexovaná sadou instrukcí, mimo HTK_SIMD_AUTO
+static const htk_kernel_t HTK_KERNELS[HTK_SIMD_AUTO] = {
+    {NULL, 1}, {siphash_sse2, 4}, {siphash_avx2, 8}};
+
+// Nejvyšší sada, kterou procesor má, zapsaná jen při zavedení programu
+static htk_simd_t htk_simd_supported = HTK_SIMD_SCALAR;
+
+/*
+ * Zjištění instrukcí procesoru jednou při zavedení programu, dřív než
+ * htk_hash_batch může běžet ve více vláknech.
+ */
+__attribute__((constructor)) static void htk_simd_init(void) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse2")) {
+    htk_simd_supported = HTK_SIMD_SSE2;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    htk_simd_supported = HTK_SIMD_AVX2;
+  }
+}
+
+/*
+ * Jádro pro htk_hash_batch podle HTK_SIMD. Vynucená sada se omezí na to,
+ * co procesor umí, HTK_SIMD_AUTO zůstává u skalárního kódu. Jen čte
+ * neměnná data, takže ji lze volat z více vláken najednou.
+ */
+static const htk_kernel_t *htk_simd_kernel(void) {
+  htk_simd_t level = HTK_SIMD;
+  if (level >= HTK_SIMD_AUTO) {
+    level = HTK_SIMD_SCALAR;
+  }
+  level = level < htk_simd_supported ? level : htk_simd_supported;
+  return &HTK_KERNELS[level];
+}
+
+#endif
+
+/*
+ * Rozptylovací hodnoty n klíčů podle funkce tabulky, stejné jako při
+ * htk_search. Tabulky s HTK_HASH_SIPHASH počítají několik klíčů najednou,
+ * ostatní funkce po jednom.
+ */
+void htk_hash_batch(htk_table_t *table, char **keys, size_t n, uint64_t *out) {
+  size_t i = 0;
+
+  if (table->hash == HTK_HASH_SUM) {
+    for (; i < n; i++) {
+      unsigned result = 1;
+      for (const char *c = keys[i]; *c != '\0'; c++) {
+        result += (unsigned char)*c;
+      }
+      out[i] = result;
+    }
+    return;
+  }
+  if (table->hash == HTK_HASH_FNV1A) {
+    for (; i < n; i++) {
+      out[i] = htk_fnv1a(table->seed[0], keys[i], strlen(keys[i]));
+    }
+    return;
+  }
+
+#ifdef HTK_X86
+  const htk_kernel_t *kernel = htk_simd_kernel();
+  if (kernel->hash != NULL) {
+    for (; i + kernel->lanes <= n; i += kernel->lanes) {
+      kernel->hash(table->seed, keys + i, out + i);
+    }
+  }
+#endif
+
+  //the rest one by one
+  for (; i < n; i++) {
+    out[i] = htk_siphash(table->seed, keys[i], strlen(keys[i]));
+  }
+}
@@ -0,0 +1,263 @@
+/*
+ * Hlavičkový súbor pre C++ obal tabuľky s rozptýlenými položkami.
+ *
+ * ial::HashTable<V> vlastní tabuľku aj kópie kľúčov a dá sa len presúvať,
+ * nie kopírovať. Hľadá sa podľa std::string_view bez dočasného reťazca.
+ * Hodnota V sa ukladá do poľa float prvku, musí byť preto triviálne
+ * kopírovateľná a nie väčšia ako float. Vyžaduje C++17.
+ */
+
+#ifndef IAL_HASHTABLE_HPP
+#define IAL_HASHTABLE_HPP
+
+#include "keyed.h"
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace ial {
+
+template <typename V> class HashTable {
+  static_assert(std::is_trivially_copyable_v<V> && sizeof(V) <= sizeof(float),
+                "V must be trivially copyable and fit into a float");
+
+public:
+  using key_type = std::string_view;
+  using mapped_type = V;
+  using value_type = std::pair<std::string_view, V>;
+  using size_type = std::size_t;
+
+  // Iterátor cez všetky prvky, poradie je podľa zoznamov synoným
+  class const_iterator {
+  public:
+    //operator* returns a temporary pair, so it is not a forward iterator
+    using iterator_category = std::input_iterator_tag;
+    using value_type = HashTable::value_type;
+    using difference_type = std::ptrdiff_t;
+    using reference = value_type;
+
+    // Ukazovateľ na dočasnú dvojicu pre operator->
+    struct pointer {
+      value_type pair;
+      const value_type *operator->() const { return &pair; }
+    };
+
+    const_iterator() = default;
+
+    reference operator*() const { return {item_->key, load(item_->value)}; }
+    pointer operator->() const { return {**this}; }
+    std::string_view key() const { return item_->key; }
+    V value() const { return load(item_->value); }
+
+    const_iterator &operator++() {
+      item_ = item_->next;
+      skip_empty();
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    bool operator==(const const_iterator &other) const {
+      return item_ == other.item_;
+    }
+    bool operator!=(const const_iterator &other) const {
+      return item_ != other.item_;
+    }
+
+  private:
+    friend class HashTable;
+
+    const_iterator(const htk_table_t *table, int bucket, ht_item_t *item)
+        : table_(table), bucket_(bucket), item_(item) {
+      skip_empty();
+    }
+
+    // Presun na prvý prvok ďalšieho neprázdneho zoznamu
+    void skip_empty() {
+      while (item_ == nullptr && table_ != nullptr &&
+             ++bucket_ < table_->size) {
+        item_ = htk_list(table_, bucket_);
+      }
+    }
+
+    const htk_table_t *table_ = nullptr;
+    int bucket_ = 0;
+    ht_item_t *item_ = nullptr;
+  };
+
+  using iterator = const_iterator;
+
+  explicit HashTable(int buckets = 1024,
+                     htk_hash_mode_t hash = HTK_HASH_SIPHASH) {
+    htk_options_t opts = {hash, {0, 0}, buckets, HTK_SIZING_POW2,
+                          HTK_REORDER_NONE};
+    init(opts);
+  }
+
+  explicit HashTable(const htk_options_t &opts) { init(opts); }
+
+  HashTable(const HashTable &) = delete;
+  HashTable &operator=(const HashTable &) = delete;
+
+  HashTable(HashTable &&other) noexcept
+      : table_(std::exchange(other.table_, nullptr)),
+        size_(std::exchange(other.size_, 0)) {}
+
+  HashTable &operator=(HashTable &&other) noexcept {
+    if (this != &other) {
+      destroy();
+      table_ = std::exchange(other.table_, nullptr);
+      size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+  }
+
+  ~HashTable() { destroy(); }
+
+  size_type size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  // Podkladová C tabuľka, nullptr po presune
+  htk_table_t *c_table() { return table_; }
+
+  const_iterator begin() const {
+    if (table_ == nullptr) {
+      return end();
+    }
+    return const_iterator(table_, 0, htk_list(table_, 0));
+  }
+  const_iterator end() const { return const_iterator(); }
+
+  const_iterator find(std::string_view key) const {
+    ht_item_t *item = search(key);
+    if (item == nullptr) {
+      return end();
+    }
+    int bucket = htk_index_n(table_, key.data(), key.size());
+    return const_iterator(table_, bucket, item);
+  }
+
+  bool contains(std::string_view key) const { return search(key) != nullptr; }
+
+  // Hodnota kľúča do out, false ak kľúč v tabuľke nie je
+  bool get(std::string_view key, V &out) const {
+    ht_item_t *item = search(key);
+    if (item == nullptr) {
+      return false;
+    }
+    out = load(item->value);
+    return true;
+  }
+
+  /*
+   * Vloží kľúč alebo zmení jeho hodnotu. Vráti true, ak bol kľúč nový.
+   * Kľúče tabuľky končia nulou, kľúč s nulou vnútri preto vyhodí
+   * std::invalid_argument. Pri nedostatku pamäte vyhodí std::bad_alloc.
+   */
+  bool insert_or_assign(std::string_view key, V value) {
+    if (std::memchr(key.data(), '\0', key.size()) != nullptr) {
+      throw std::invalid_argument("key contains a NUL character");
+    }
+    ht_item_t *item = search(key);
+    if (item != nullptr) {
+      item->value = store(value);
+      return false;
+    }
+
+    char *copy = new char[key.size() + 1];
+    std::memcpy(copy, key.data(), key.size());
+    copy[key.size()] = '\0';
+    htk_insert(table_, copy, store(value));
+    if (htk_search_n(table_, copy, key.size()) == nullptr) {
+      delete[] copy;
+      throw std::bad_alloc();
+    }
+    size_++;
+    return true;
+  }
+
+  // Zmaže kľúč aj jeho kópiu, vráti počet zmazaných prvkov
+  size_type erase(std::string_view key) {
+    ht_item_t *item = search(key);
+    if (item == nullptr) {
+      return 0;
+    }
+    char *owned = item->key;
+    htk_delete(table_, owned);
+    delete[] owned;
+    size_--;
+    return 1;
+  }
+
+  void clear() {
+    if (table_ == nullptr) {
+      return;
+    }
+    free_keys();
+    htk_delete_all(table_);
+    size_ = 0;
+  }
+
+private:
+  static float store(V value) {
+    float raw = 0;
+    std::memcpy(&raw, &value, sizeof(V));
+    return raw;
+  }
+
+  static V load(float raw) {
+    V value;
+    std::memcpy(&value, &raw, sizeof(V));
+    return value;
+  }
+
+  void init(const htk_options_t &opts) {
+    //the C table holds its small-table lists inline, almost a kilobyte,
+    //so it stays on the heap and a move only passes the pointer
+    table_ = new htk_table_t;
+    htk_init(table_, &opts);
+  }
+
+  // Hľadanie v const metódach, zoznamy sa nepreusporiadajú
+  ht_item_t *search(std::string_view key) const {
+    if (table_ == nullptr) {
+      return nullptr;
+    }
+    return htk_find_n(table_, key.data(), key.size());
+  }
+
+  void free_keys() {
+    for (int i = 0; i < table_->size; i++) {
+      for (ht_item_t *item = htk_list(table_, i); item != nullptr;
+           item = item->next) {
+        delete[] item->key;
+      }
+    }
+  }
+
+  void destroy() {
+    if (table_ == nullptr) {
+      return;
+    }
+    free_keys();
+    htk_dispose(table_);
+    delete table_;
+    table_ = nullptr;
+  }
+
+  htk_table_t *table_ = nullptr;
+  size_type size_ = 0;
+};
+
+} // namespace ial
+
+#endif
@@ -0,0 +1,1414 @@
+/*
+ * Tabulka s rozptýlenými položkami s klíčovanou rozptylovací funkcí
+ *
+ * Seznamy synonym jsou explicitně zřetězené stejně jako v hashtable.c a
+ * prvky mají stejný typ ht_item_t. Tabulka si ale pamatuje vlastní velikost,
+ * rozptylovací funkci a její tajný klíč, takže útočník nedokáže vyrobit
+ * klíče se stejným indexem. Z hashtable.c používá jen HT_SIZE, ten na ní
+ * nezávisí.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include "keyed.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+// Blok prvků z hromadného vkládání nebo z velké stránky
+struct htk_slab {
+  struct htk_slab *next; // další blok tabulky
+  size_t count;          // počet použitých prvků bloku
+  size_t capacity;       // počet prvků, pro které je blok alokovaný
+  htk_pages_t pages;     // jak je blok alokovaný
+  ht_item_t items[];     // prvky
+};
+
+// Velká stránka na x86-64, alokace přes mmap se na ni zaokrouhlují
+#define HTK_HUGE_PAGE_SIZE ((size_t)2 * 1024 * 1024)
+
+// MAP_HUGETLB bez velikosti bere výchozí velkou stránku systému, ta může
+// mít i 1 GiB, proto se velikost 2^21 bajtů žádá výslovně
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+#define HTK_MAP_HUGE_2MB (MAP_HUGETLB | (21 << MAP_HUGE_SHIFT))
+#endif
+
+// Počet klíčů, pro které se najednou počítá rozptylovací hodnota
+#define HTK_HASH_BATCH 64
+
+// Počet měření každé funkce v htk_tune, platí nejrychlejší
+#define HTK_TUNE_ROUNDS 5
+
+// Součet rozptylovacích hodnot z htk_tune, aby je překladač nevynechal
+static volatile uint64_t htk_tune_sink;
+
+#ifdef __GNUC__
+#define HTK_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define HTK_PREFETCH(address) (void)(address)
+#endif
+
+#define ROTL64(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+
+#define SIPROUND                                                               \
+  do {                                                                         \
+    v0 += v1;                                                                  \
+    v1 = ROTL64(v1, 13);                                                       \
+    v1 ^= v0;                                                                  \
+    v0 = ROTL64(v0, 32);                                                       \
+    v2 += v3;                                                                  \
+    v3 = ROTL64(v3, 16);                                                       \
+    v3 ^= v2;                                                                  \
+    v0 += v3;                                                                  \
+    v3 = ROTL64(v3, 21);                                                       \
+    v3 ^= v0;                                                                  \
+    v2 += v1;                                                                  \
+    v1 = ROTL64(v1, 17);                                                       \
+    v1 ^= v2;                                                                  \
+    v2 = ROTL64(v2, 32);                                                       \
+  } while (0)
+
+/*
+ * SipHash-1-3 klíče key délky len s tajným klíčem seed.
+ *
+ * Na rozdíl od součtu znaků nedokáže útočník bez znalosti seed vyrobit
+ * velké množství klíčů se stejným indexem.
+ */
+uint64_t htk_siphash(const uint64_t seed[2], const char *key, size_t len) {
+  uint64_t v0 = seed[0] ^ UINT64_C(0x736f6d6570736575);
+  uint64_t v1 = seed[1] ^ UINT64_C(0x646f72616e646f6d);
+  uint64_t v2 = seed[0] ^ UINT64_C(0x6c7967656e657261);
+  uint64_t v3 = seed[1] ^ UINT64_C(0x7465646279746573);
+  const char *end = key + (len & ~(size_t)7);
+
+  //compress all the full 8 byte blocks
+  for (; key != end; key += 8) {
+    uint64_t m;
+    memcpy(&m, key, sizeof(m));
+    v3 ^= m;
+    SIPROUND;
+    v0 ^= m;
+  }
+
+  //the last block holds the remaining bytes and the length
+  uint64_t b = (uint64_t)len << 56;
+  for (size_t i = 0; i < (len & 7); i++) {
+    b |= (uint64_t)(unsigned char)key[i] << (8 * i);
+  }
+  v3 ^= b;
+  SIPROUND;
+  v0 ^= b;
+
+  //finalization
+  v2 ^= 0xff;
+  SIPROUND;
+  SIPROUND;
+  SIPROUND;
+  return v0 ^ v1 ^ v2 ^ v3;
+}
+
+/*
+ * FNV-1a klíče key délky len, počáteční hodnota je posunutá o seed.
+ *
+ * Pro krátké klíče je rychlejší než SipHash, ale seed útočníkovi nebrání
+ * v hledání kolizí. Hodí se jen pro klíče z důvěryhodného zdroje.
+ */
+uint64_t htk_fnv1a(uint64_t seed, const char *key, size_t len) {
+  uint64_t hash = UINT64_C(0xcbf29ce484222325) ^ seed;
+  for (size_t i = 0; i < len; i++) {
+    hash ^= (unsigned char)key[i];
+    hash *= UINT64_C(0x100000001b3);
+  }
+  return hash;
+}
+
+/*
+ * Vygeneruje náhodný klíč tabulky.
+ *
+ * Pokud není dostupný /dev/urandom, klíč se odvodí z času a adresy, což
+ * je slabší, ale pořád neznámé dopředu.
+ */
+void htk_random_seed(uint64_t seed[2]) {
+  FILE *urandom = fopen("/dev/urandom", "rb");
+  if (urandom != NULL) {
+    size_t read = fread(seed, sizeof(uint64_t), 2, urandom);
+    fclose(urandom);
+    if (read == 2) {
+      return;
+    }
+  }
+
+  //splitmix64 over whatever entropy we have
+  uint64_t x = (uint64_t)time(NULL) ^ ((uint64_t)clock() << 32) ^
+               (uint64_t)(uintptr_t)seed;
+  for (int i = 0; i < 2; i++) {
+    x += UINT64_C(0x9e3779b97f4a7c15);
+    uint64_t z = x;
+    z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+    seed[i] = z ^ (z >> 31);
+  }
+}
+
+/*
+ * Rozptylovací hodnota klíče podle rozptylovací funkce tabulky.
+ */
+static uint64_t htk_hash(const htk_table_t *table, const char *key,
+                         size_t len) {
+  if (table->hash == HTK_HASH_SIPHASH) {
+    return htk_siphash(table->seed, key, len);
+  }
+  if (table->hash == HTK_HASH_FNV1A) {
+    return htk_fnv1a(table->seed[0], key, len);
+  }
+
+  //same sum as get_hash, but never negative for non-ASCII keys
+  unsigned result = 1;
+  for (size_t i = 0; i < len; i++) {
+    result += (unsigned char)key[i];
+  }
+  return result;
+}
+
+/*
+ * Převod rozptylovací hodnoty na index bez celočíselného dělení.
+ *
+ * HTK_SIZING_POW2 hodnotu nejdřív promíchá (fmix64 z MurmurHash3), aby
+ * maska nevybírala jen spodní bity slabé funkce jako součet znaků.
+ * HTK_SIZING_PRIME počítá přesně (hash % size) pomocí předpočítané
+ * konstanty (Lemire, Kaser, Kurz: Faster Remainder by Direct Computation).
+ */
+static int htk_bucket_of(htk_sizing_t sizing, int size, uint64_t fastmod,
+                         uint64_t hash) {
+  if (sizing == HTK_SIZING_POW2) {
+    hash ^= hash >> 33;
+    hash *= UINT64_C(0xff51afd7ed558ccd);
+    hash ^= hash >> 33;
+    hash *= UINT64_C(0xc4ceb9fe1a85ec53);
+    hash ^= hash >> 33;
+    return hash & (uint64_t)(size - 1);
+  }
+
+  //fold to 32 bits, sums of short keys stay the same as before
+  uint32_t folded = (uint32_t)(hash ^ (hash >> 32));
+
+  //high 64 bits of (fastmod * folded) * size, split to avoid __int128
+  uint64_t lowbits = fastmod * folded;
+  uint64_t high = (lowbits >> 32) * (uint64_t)size;
+  uint64_t low = (lowbits & UINT32_MAX) * (uint64_t)size;
+  return (high + (low >> 32)) >> 32;
+}
+
+static int htk_bucket(const htk_table_t *table, uint64_t hash) {
+  return htk_bucket_of(table->sizing, table->size, table->fastmod, hash);
+}
+
+/*
+ * Index klíče v tabulce.
+ */
+static int htk_index(htk_table_t *table, const char *key) {
+  return htk_bucket(table, htk_hash(table, key, strlen(key)));
+}
+
+/*
+ * Index seznamu synonym pro prvních len znaků key, key nemusí končit nulou.
+ */
+int htk_index_n(htk_table_t *table, const char *key, size_t len) {
+  return htk_bucket(table, htk_hash(table, key, len));
+}
+
+/*
+ * Pole seznamů synonym, malé tabulky ho mají přímo ve struktuře.
+ *
+ * Tabulka si nepamatuje ukazatel do sebe sama, takže ji lze zkopírovat
+ * nebo přesunout jako hodnotu.
+ */
+static ht_item_t **htk_lists(htk_table_t *table) {
+  return table->heap_items != NULL ? table->heap_items : table->inline_items;
+}
+
+/*
+ * První prvek seznamu synonym s indexem index.
+ */
+ht_item_t *htk_list(const htk_table_t *table, int index) {
+  return table->heap_items != NULL ? table->heap_items[index]
+                                   : table->inline_items[index];
+}
+
+/*
+ * Nejmenší prvočíslo, které není menší než n.
+ */
+static int next_prime(int n) {
+  for (;; n++) {
+    bool prime = n >= 2;
+    for (int d = 2; prime && d <= n / d; d++) {
+      prime = n % d != 0;
+    }
+    if (prime) {
+      return n;
+    }
+  }
+}
+
+/*
+ * Alokace bytes bajtů na stránkách podle pages, do *got zapíše skutečný
+ * způsob alokace.
+ *
+ * HTK_PAGES_EXPLICIT zkusí MAP_HUGETLB se stránkami velikosti
+ * HTK_HUGE_PAGE_SIZE, které musí být rezervované v
+ * /sys/kernel/mm/hugepages/hugepages-2048kB, potom transparentní velké
+ * stránky a nakonec malloc. Blok z mmap začíná na hranici velké stránky,
+ * jinak by ho jádro velkými stránkami pokrýt nemohlo. Bloky menší než
+ * polovina velké stránky se vždy alokují přes malloc.
+ */
+static void *htk_alloc_pages(htk_pages_t pages, size_t bytes,
+                             htk_pages_t *got) {
+  *got = HTK_PAGES_NORMAL;
+  if (pages == HTK_PAGES_NORMAL || bytes < HTK_HUGE_PAGE_SIZE / 2) {
+    return malloc(bytes);
+  }
+  size_t length = (bytes + HTK_HUGE_PAGE_SIZE - 1) & ~(HTK_HUGE_PAGE_SIZE - 1);
+
+#ifdef HTK_MAP_HUGE_2MB
+  if (pages == HTK_PAGES_EXPLICIT) {
+    void *block = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | HTK_MAP_HUGE_2MB, -1, 0);
+    if (block != MAP_FAILED) {
+      *got = HTK_PAGES_EXPLICIT;
+      return block;
+    }
+  }
+#endif
+
+  //map one huge page more and trim both ends to the boundary
+  char *raw = mmap(NULL, length + HTK_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED) {
+    return malloc(bytes);
+  }
+  uintptr_t mask = HTK_HUGE_PAGE_SIZE - 1;
+  char *block = (char *)(((uintptr_t)raw + mask) & ~mask);
+  size_t head = block - raw;
+  if (head > 0) {
+    munmap(raw, head);
+  }
+  if (head < HTK_HUGE_PAGE_SIZE) {
+    munmap(block + length, HTK_HUGE_PAGE_SIZE - head);
+  }
+
+#ifdef MADV_HUGEPAGE
+  //only a hint, the kernel may still back the block with small pages
+  madvise(block, length, MADV_HUGEPAGE);
+#endif
+  *got = HTK_PAGES_TRANSPARENT;
+  return block;
+}
+
+/*
+ * Uvolnění bloku z htk_alloc_pages se stejnou velikostí bytes.
+ */
+static void htk_free_pages(void *block, size_t bytes, htk_pages_t got) {
+  if (got == HTK_PAGES_NORMAL) {
+    free(block);
+    return;
+  }
+  munmap(block, (bytes + HTK_HUGE_PAGE_SIZE - 1) & ~(HTK_HUGE_PAGE_SIZE - 1));
+}
+
+/*
+ * Blok pro capacity prvků na stránkách tabulky, zatím bez použitých prvků.
+ */
+static htk_slab_t *htk_alloc_slab(htk_table_t *table, size_t capacity) {
+  htk_pages_t got;
+  htk_slab_t *slab = htk_alloc_pages(
+      table->pages, sizeof(htk_slab_t) + capacity * sizeof(ht_item_t), &got);
+  if (slab != NULL) {
+    slab->next = NULL;
+    slab->count = 0;
+    slab->capacity = capacity;
+    slab->pages = got;
+  }
+  return slab;
+}
+
+static void htk_free_slab(htk_slab_t *slab) {
+  htk_free_pages(slab, sizeof(htk_slab_t) + slab->capacity * sizeof(ht_item_t),
+                 slab->pages);
+}
+
+/*
+ * Nový prvek, přednostně smazaný prvek.
+ *
+ * Tabulky na velkých stránkách berou všechny prvky z bloků, ostatní
+ * alokují každý prvek zvlášť. První blok má místo pro tolik prvků, kolik
+ * má tabulka seznamů, každý další dvakrát víc, nejvýš jednu velkou
+ * stránku. Malá tabulka tak nezabere celou velkou stránku hned prvním
+ * vložením.
+ */
+static ht_item_t *htk_take_item(htk_table_t *table) {
+  ht_item_t *item = table->free_items;
+  if (item != NULL) {
+    table->free_items = item->next;
+    return item;
+  }
+  if (table->pages == HTK_PAGES_NORMAL) {
+    return malloc(sizeof(ht_item_t));
+  }
+
+  //items are carved from the first block, full blocks stay behind it
+  htk_slab_t *slab = table->slabs;
+  if (slab == NULL || slab->count == slab->capacity) {
+    size_t most = (HTK_HUGE_PAGE_SIZE - sizeof(htk_slab_t)) / sizeof(ht_item_t);
+    size_t capacity = slab != NULL ? 2 * slab->capacity : (size_t)table->size;
+    slab = htk_alloc_slab(table, capacity < most ? capacity : most);
+    if (slab == NULL) {
+      return NULL;
+    }
+    slab->next = table->slabs;
+    table->slabs = slab;
+  }
+  return &slab->items[slab->count++];
+}
+
+/*
+ * Uvolnění prvku v konstantním čase.
+ *
+ * Dokud tabulka nemá žádný blok, jsou všechny její prvky alokované zvlášť a
+ * prvek se hned uvolní. Jinak se jen vrátí do seznamu volných prvků a použije
+ * se pro další vkládání, i když byl alokovaný zvlášť. Takové prvky odliší od
+ * prvků bloků a uvolní až htk_delete_all.
+ */
+static void htk_release_item(htk_table_t *table, ht_item_t *item) {
+  if (table->slabs == NULL) {
+    free(item);
+    return;
+  }
+  item->next = table->free_items;
+  table->free_items = item;
+}
+
+static int htk_compare_slabs(const void *a, const void *b) {
+  uintptr_t x = (uintptr_t)*(htk_slab_t *const *)a;
+  uintptr_t y = (uintptr_t)*(htk_slab_t *const *)b;
+  return (x > y) - (x < y);
+}
+
+static bool htk_slab_contains(const htk_slab_t *slab, const ht_item_t *item) {
+  uintptr_t address = (uintptr_t)item;
+  return address >= (uintptr_t)slab->items &&
+         address < (uintptr_t)(slab->items + slab->count);
+}
+
+/*
+ * Zda prvek leží v některém bloku tabulky.
+ *
+ * Bloky seřazené podle adresy (sorted, count) se prohledají půlením. Bez
+ * seřazeného pole se prochází seznam bloků.
+ */
+static bool htk_slab_owns(htk_table_t *table, htk_slab_t **sorted,
+                          size_t count, const ht_item_t *item) {
+  if (sorted == NULL) {
+    for (htk_slab_t *slab = table->slabs; slab != NULL; slab = slab->next) {
+      if (htk_slab_contains(slab, item)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  //the last block that starts below the item
+  size_t low = 0, high = count;
+  while (low < high) {
+    size_t middle = low + (high - low) / 2;
+    if ((uintptr_t)sorted[middle] < (uintptr_t)item) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low > 0 && htk_slab_contains(sorted[low - 1], item);
+}
+
+/*
+ * Uvolnění prvků alokovaných zvlášť ze seznamu volných prvků.
+ *
+ * Pro n prvků a b bloků trvá O(b log b + n log b). Tabulky na velkých
+ * stránkách mají všechny prvky v blocích a nedělají nic.
+ */
+static void htk_free_loose_items(htk_table_t *table) {
+  if (table->pages != HTK_PAGES_NORMAL) {
+    return;
+  }
+
+  size_t count = 0;
+  for (htk_slab_t *slab = table->slabs; slab != NULL; slab = slab->next) {
+    count++;
+  }
+  htk_slab_t **sorted = malloc(count * sizeof(htk_slab_t *));
+  if (sorted != NULL) {
+    count = 0;
+    for (htk_slab_t *slab = table->slabs; slab != NULL; slab = slab->next) {
+      sorted[count++] = slab;
+    }
+    qsort(sorted, count, sizeof(htk_slab_t *), htk_compare_slabs);
+  }
+
+  ht_item_t *tmp = table->free_items;
+  while (tmp != NULL) {
+    ht_item_t *next = tmp->next;
+    if (!htk_slab_owns(table, sorted, count, tmp)) {
+      free(tmp);
+    }
+    tmp = next;
+  }
+  table->free_items = NULL;
+  free(sorted);
+}
+
+/*
+ * Velikost zaokrouhlená nahoru podle způsobu výpočtu indexu.
+ */
+static int htk_round_size(htk_sizing_t sizing, int size) {
+  if (sizing == HTK_SIZING_POW2) {
+    int pow2 = 1;
+    while (pow2 < size) {
+      pow2 *= 2;
+    }
+    return pow2;
+  }
+  return next_prime(size);
+}
+
+/*
+ * Inicializace tabulky se zvolenou rozptylovací funkcí, zavolá se před
+ * prvním použitím tabulky. Bez opts (NULL) dostane tabulka velikost HT_SIZE
+ * a SipHash s náhodným klíčem.
+ *
+ * Pro klíče, které přicházejí zvenčí, použijte HTK_HASH_SIPHASH — každá
+ * tabulka pak dostane vlastní náhodný klíč (pokud ho opts nezadává) a útočník
+ * nedokáže poslat klíče, které by skončily ve stejném seznamu synonym.
+ *
+ * Velikost se zaokrouhlí nahoru na prvočíslo (HTK_SIZING_PRIME) nebo na
+ * mocninu dvou (HTK_SIZING_POW2). Tabulky větší než MAX_HT_SIZE alokují pole
+ * seznamů na haldě a je nutné je uvolnit funkcí htk_dispose; pokud alokace
+ * selže, tabulka bude mít velikost MAX_HT_SIZE.
+ *
+ * S opts->pages jiným než HTK_PAGES_NORMAL leží pole seznamů i prvky na
+ * velkých stránkách, pokud je jádro poskytne, a velká tabulka pak při
+ * náhodném přístupu méně často míjí TLB. Skutečný způsob alokace pole je v
+ * table->items_pages.
+ */
+void htk_init(htk_table_t *table, const htk_options_t *opts) {
+  static const htk_options_t defaults = {HTK_HASH_SIPHASH, {0, 0}, 0,
+                                         HTK_SIZING_PRIME};
+  if (opts == NULL) {
+    opts = &defaults;
+  }
+
+  //round the size up for the chosen index computation
+  int size = htk_round_size(opts->sizing,
+                            opts->size > 0 ? opts->size : HT_SIZE);
+
+  //use the inline array when the table is small enough
+  table->pages = opts->pages;
+  table->items_pages = HTK_PAGES_NORMAL;
+  table->heap_items = NULL;
+  if (size > MAX_HT_SIZE) {
+    table->heap_items = htk_alloc_pages(table->pages,
+                                        size * sizeof(ht_item_t *),
+                                        &table->items_pages);
+    if (table->heap_items == NULL) {
+      size = opts->sizing == HTK_SIZING_POW2 ? 64 : MAX_HT_SIZE;
+    }
+  }
+  table->size = size;
+  table->sizing = opts->sizing;
+  table->fastmod = UINT64_MAX / (uint64_t)size + 1;
+
+  //set the hash function and its key, automatic choice starts with SipHash
+  //and without unkeyed candidates there is nothing to choose from
+  table->reorder = opts->reorder;
+  table->hash = opts->hash == HTK_HASH_AUTO ? HTK_HASH_SIPHASH : opts->hash;
+  table->allow_unkeyed = opts->allow_unkeyed;
+  table->tune_left =
+      opts->hash == HTK_HASH_AUTO && opts->allow_unkeyed ? HTK_TUNE_SAMPLE : 0;
+  memset(&table->tuning, 0, sizeof(table->tuning));
+  table->seed[0] = opts->seed[0];
+  table->seed[1] = opts->seed[1];
+  if (table->hash == HTK_HASH_SIPHASH && table->seed[0] == 0 &&
+      table->seed[1] == 0) {
+    htk_random_seed(table->seed);
+  }
+  table->slabs = NULL;
+  table->free_items = NULL;
+
+  //initialize the table
+  //set all the values to NULL
+  ht_item_t **lists = htk_lists(table);
+  for (int i = 0; i < table->size; i++) {
+    lists[i] = NULL;
+  }
+}
+
+/*
+ * Vyhledání prvku v tabulce.
+ *
+ * V případě úspěchu vrací ukazatel na nalezený prvek; v opačném případě vrací
+ * hodnotu NULL.
+ *
+ * Tabulky s HTK_REORDER_MOVE_TO_FRONT přesunou nalezený prvek na začátek
+ * seznamu synonym, tabulky s HTK_REORDER_TRANSPOSE ho prohodí s předchůdcem.
+ * Často hledané klíče se tak při nerovnoměrném přístupu najdou hned prvním
+ * porovnáním.
+ */
+ht_item_t *htk_search(htk_table_t *table, char *key) {
+
+  //check if the table is initialized
+  //if not, return NULL
+  if (table == NULL) {
+    return NULL;
+  }
+
+  return htk_search_n(table, key, strlen(key));
+}
+
+/*
+ * Vyhledání prvku podle prvních len znaků key, key nemusí končit nulou.
+ *
+ * Klíče v tabulce jsou řetězce ukončené nulou, klíč s nulou uvnitř se
+ * proto nenajde nikdy.
+ */
+ht_item_t *htk_search_n(htk_table_t *table, const char *key, size_t len) {
+  if (table == NULL || memchr(key, '\0', len) != NULL) {
+    return NULL;
+  }
+
+  //get the list of synonyms for the key
+  uint64_t hash = htk_hash(table, key, len);
+  ht_item_t **head = &htk_lists(table)[htk_bucket(table, hash)];
+  ht_item_t *tmp = *head;
+  ht_item_t *prev = NULL;
+  ht_item_t *prev_prev = NULL;
+
+  //search in the list, while the item is not NULL
+  while (tmp != NULL) {
+    //if the key is the same, return the item
+    //strncmp stops at the end of a shorter key, so tmp->key[len] exists
+    if (strncmp(tmp->key, key, len) == 0 && tmp->key[len] == '\0') {
+      break;
+    }
+
+    //else, go to the next item
+    prev_prev = prev;
+    prev = tmp;
+    tmp = tmp->next;
+  }
+
+  //if the item is found deeper in the list, move it forward
+  if (tmp != NULL && prev != NULL) {
+    if (table->reorder == HTK_REORDER_MOVE_TO_FRONT) {
+      prev->next = tmp->next;
+      tmp->next = *head;
+      *head = tmp;
+    } else if (table->reorder == HTK_REORDER_TRANSPOSE) {
+      prev->next = tmp->next;
+      tmp->next = prev;
+      if (prev_prev == NULL) {
+        *head = tmp;
+      } else {
+        prev_prev->next = tmp;
+      }
+    }
+  }
+
+  //if the item is not found, tmp is NULL
+  return tmp;
+}
+
+/*
+ * Vyhledání prvku jako htk_search_n, ale bez přeuspořádání seznamu, takže
+ * tabulku nemění ani s HTK_REORDER_MOVE_TO_FRONT nebo HTK_REORDER_TRANSPOSE.
+ */
+ht_item_t *htk_find_n(const htk_table_t *table, const char *key, size_t len) {
+  if (table == NULL || memchr(key, '\0', len) != NULL) {
+    return NULL;
+  }
+
+  uint64_t hash = htk_hash(table, key, len);
+  ht_item_t *tmp = htk_list(table, htk_bucket(table, hash));
+  while (tmp != NULL &&
+         (strncmp(tmp->key, key, len) != 0 || tmp->key[len] != '\0')) {
+    tmp = tmp->next;
+  }
+  return tmp;
+}
+
+/*
+ * Vyhledání n klíčů najednou, out[i] je výsledek htk_search pro keys[i].
+ *
+ * Klíče se zpracují po HTK_HASH_BATCH: nejdřív se spočítají všechny
+ * rozptylovací hodnoty přes htk_hash_batch, potom se přednačtou začátky
+ * seznamů a první prvky a teprve potom se seznamy prochází, takže čekání
+ * na paměť se u různých klíčů překrývá. Seznamy se nepřeuspořádávají.
+ */
+void htk_search_batch(htk_table_t *table, char **keys, size_t n,
+                      ht_item_t **out) {
+  ht_item_t **lists = htk_lists(table);
+  uint64_t hashes[HTK_HASH_BATCH];
+  int buckets[HTK_HASH_BATCH];
+
+  for (size_t done = 0; done < n; done += HTK_HASH_BATCH) {
+    size_t count = n - done < HTK_HASH_BATCH ? n - done : HTK_HASH_BATCH;
+    htk_hash_batch(table, keys + done, count, hashes);
+    for (size_t j = 0; j < count; j++) {
+      buckets[j] = htk_bucket(table, hashes[j]);
+      HTK_PREFETCH(&lists[buckets[j]]);
+    }
+    for (size_t j = 0; j < count; j++) {
+      HTK_PREFETCH(lists[buckets[j]]);
+    }
+
+    for (size_t j = 0; j < count; j++) {
+      ht_item_t *tmp = lists[buckets[j]];
+      while (tmp != NULL && strcmp(tmp->key, keys[done + j]) != 0) {
+        tmp = tmp->next;
+      }
+      out[done + j] = tmp;
+    }
+  }
+}
+
+/*
+ * Získání hodnot n klíčů najednou, out[i] je výsledek htk_get pro keys[i].
+ */
+void htk_get_batch(htk_table_t *table, char **keys, size_t n, float **out) {
+  ht_item_t *items[HTK_HASH_BATCH];
+
+  for (size_t done = 0; done < n; done += HTK_HASH_BATCH) {
+    size_t count = n - done < HTK_HASH_BATCH ? n - done : HTK_HASH_BATCH;
+    htk_search_batch(table, keys + done, count, items);
+    for (size_t j = 0; j < count; j++) {
+      out[done + j] = items[j] != NULL ? &items[j]->value : NULL;
+    }
+  }
+}
+
+static double htk_tune_now(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+ * Výběr rozptylovací funkce podle vzorku klíčů.
+ *
+ * Pro každou funkci změří čas výpočtu na klíč a rozptyl délek seznamů po
+ * rozdělení vzorku do tabulky velké jako vzorek se stejným výpočtem
+ * indexu. Podíl rozptylu a průměrné délky je pro dobrou funkci kolem 1.
+ * Vybere nejrychlejší funkci, jejíž podíl je nejvýš o polovinu horší než
+ * nejlepší, a prvky tabulky přeřadí. Měření zůstanou v table->tuning.
+ *
+ * HTK_HASH_SUM ani HTK_HASH_FNV1A nemají tajný klíč a útočník pro ně snadno
+ * najde kolidující klíče. Vybrat je lze jen v tabulce s allow_unkeyed,
+ * jinak zůstane SipHash.
+ *
+ * Změna funkce zneplatní kurzory z htk_iter_cursor. Vrací zvolenou funkci;
+ * při prázdném vzorku nebo nedostatku paměti zůstane funkce stejná.
+ */
+htk_hash_mode_t htk_tune(htk_table_t *table, char **keys, size_t n) {
+  table->tune_left = 0;
+
+  //a bigger sample would only take longer
+  n = n > HTK_TUNE_SAMPLE * 64 ? HTK_TUNE_SAMPLE * 64 : n;
+  if (n == 0) {
+    return table->hash;
+  }
+
+  int size = htk_round_size(table->sizing, n);
+  size_t *lengths = malloc(n * sizeof(size_t));
+  int *chains = malloc(size * sizeof(int));
+  if (lengths == NULL || chains == NULL) {
+    free(lengths);
+    free(chains);
+    return table->hash;
+  }
+  for (size_t i = 0; i < n; i++) {
+    lengths[i] = strlen(keys[i]);
+  }
+
+  //SipHash may win, so it needs a secret key
+  if (table->seed[0] == 0 && table->seed[1] == 0) {
+    htk_random_seed(table->seed);
+  }
+
+  htk_hash_mode_t current = table->hash;
+  uint64_t fastmod = UINT64_MAX / (uint64_t)size + 1;
+  double load = (double)n / size;
+  uint64_t sink = 0;
+  for (htk_hash_mode_t hash = HTK_HASH_SUM; hash < HTK_HASH_AUTO; hash++) {
+    table->hash = hash;
+
+    //the fastest of a few rounds, the first one brings the keys to the cache
+    double fastest = 0;
+    for (int r = 0; r < HTK_TUNE_ROUNDS; r++) {
+      double start = htk_tune_now();
+      for (size_t i = 0; i < n; i++) {
+        sink += htk_hash(table, keys[i], lengths[i]);
+      }
+      double elapsed = htk_tune_now() - start;
+      fastest = r == 0 || elapsed < fastest ? elapsed : fastest;
+    }
+    table->tuning.ns_per_key[hash] = fastest / n;
+
+    //chain lengths of the sample alone
+    memset(chains, 0, size * sizeof(int));
+    for (size_t i = 0; i < n; i++) {
+      uint64_t value = htk_hash(table, keys[i], lengths[i]);
+      chains[htk_bucket_of(table->sizing, size, fastmod, value)]++;
+    }
+    double variance = 0;
+    for (int b = 0; b < size; b++) {
+      variance += (chains[b] - load) * (chains[b] - load);
+    }
+    table->tuning.chain_ratio[hash] = variance / size / load;
+  }
+  table->tuning.sample = n;
+  htk_tune_sink = sink;
+  free(lengths);
+  free(chains);
+
+  //the fastest allowed function with chains close to the best allowed ones,
+  //SipHash is always allowed and always qualifies without other candidates
+  const double *ratio = table->tuning.chain_ratio;
+  double best_ratio = ratio[HTK_HASH_SIPHASH];
+  for (htk_hash_mode_t hash = HTK_HASH_SUM; hash < HTK_HASH_AUTO; hash++) {
+    if (table->allow_unkeyed && ratio[hash] < best_ratio) {
+      best_ratio = ratio[hash];
+    }
+  }
+  htk_hash_mode_t best = HTK_HASH_SIPHASH;
+  for (htk_hash_mode_t hash = HTK_HASH_SUM; hash < HTK_HASH_AUTO; hash++) {
+    bool allowed = hash == HTK_HASH_SIPHASH || table->allow_unkeyed;
+    if (allowed && ratio[hash] <= 1.5 * best_ratio &&
+        (ratio[best] > 1.5 * best_ratio ||
+         table->tuning.ns_per_key[hash] < table->tuning.ns_per_key[best])) {
+      best = hash;
+    }
+  }
+
+  //same size, so the items are relinked in place
+  table->hash = best;
+  if (best != current) {
+    htk_resize(table, table->size);
+  }
+  return best;
+}
+
+/*
+ * Výběr funkce pro HTK_HASH_AUTO podle klíčů, které už jsou v tabulce.
+ */
+static void htk_tune_table(htk_table_t *table) {
+  char **keys = malloc(HTK_TUNE_SAMPLE * sizeof(char *));
+  if (keys == NULL) {
+    return;
+  }
+  size_t n = 0;
+  for (int i = 0; i < table->size && n < HTK_TUNE_SAMPLE; i++) {
+    for (ht_item_t *item = htk_list(table, i);
+         item != NULL && n < HTK_TUNE_SAMPLE; item = item->next) {
+      keys[n++] = item->key;
+    }
+  }
+  htk_tune(table, keys, n);
+  free(keys);
+}
+
+/*
+ * Statistiky tabulky: funkce, počet prvků a rozložení délek seznamů.
+ */
+void htk_stats(const htk_table_t *table, htk_stats_t *stats) {
+  stats->hash = table->hash;
+  stats->size = table->size;
+  stats->count = 0;
+  stats->empty = 0;
+  stats->max_chain = 0;
+  stats->tuning = table->tuning;
+
+  double sum_squares = 0;
+  for (int i = 0; i < table->size; i++) {
+    int length = 0;
+    for (ht_item_t *item = htk_list(table, i); item != NULL;
+         item = item->next) {
+      length++;
+    }
+    stats->count += length;
+    stats->empty += length == 0;
+    stats->max_chain = length > stats->max_chain ? length : stats->max_chain;
+    sum_squares += (double)length * length;
+  }
+
+  //variance over mean, about 1 for a random spread
+  double load = (double)stats->count / table->size;
+  stats->chain_ratio =
+      load > 0 ? (sum_squares / table->size - load * load) / load : 0;
+}
+
+/*
+ * Vložení nového prvku do tabulky.
+ *
+ * Pokud prvek s daným klíčem už v tabulce existuje, nahradí se jeho hodnota.
+ * Nový prvek se vloží na začátek seznamu synonym. Klíč se nekopíruje, musí
+ * platit, dokud je prvek v tabulce.
+ */
+void htk_insert(htk_table_t *table, char *key, float value) {
+
+  //search for the item
+  ht_item_t *tmp = htk_search(table, key);
+
+  //if the item is found, change its value
+  if (tmp != NULL) {
+    tmp->value = value;
+    return;
+  }
+
+  //else, create a new item
+  int index = htk_index(table, key);
+  ht_item_t *new_item = htk_take_item(table);
+
+  if(new_item == NULL) {
+    return;
+  }
+
+  //set the values
+  new_item->key = key;
+  new_item->value = value;
+  new_item->next = NULL;
+
+  //add the new item to the beginning of the list, which may be empty
+  ht_item_t **head = &htk_lists(table)[index];
+  new_item->next = *head;
+  *head = new_item;
+
+  //pick the hash function once the sample is complete
+  if (table->tune_left > 0 && --table->tune_left == 0) {
+    htk_tune_table(table);
+  }
+}
+
+// Práce jednoho vlákna hromadného vkládání
+typedef struct htk_bulk_job {
+  htk_table_t *table;    // plněná tabulka
+  char **keys;           // vstupní klíče
+  uint32_t *buckets;     // index seznamu pro každý klíč nebo prvek
+  ht_item_t *items;      // prvky bloku seřazené podle oddílů
+  size_t from;           // první klíč nebo prvek vlákna
+  size_t to;             // za posledním klíčem nebo prvkem vlákna
+  ht_item_t *free_items; // prvky, které jen změnily hodnotu existujícího klíče
+} htk_bulk_job_t;
+
+/*
+ * První fáze: index seznamu pro každý klíč, čte se jen postupně.
+ */
+static void *htk_bulk_hash(void *arg) {
+  htk_bulk_job_t *job = arg;
+  uint64_t hashes[HTK_HASH_BATCH];
+  for (size_t i = job->from; i < job->to; i += HTK_HASH_BATCH) {
+    size_t n = job->to - i < HTK_HASH_BATCH ? job->to - i : HTK_HASH_BATCH;
+    htk_hash_batch(job->table, job->keys + i, n, hashes);
+    for (size_t j = 0; j < n; j++) {
+      job->buckets[i + j] = htk_bucket(job->table, hashes[j]);
+    }
+  }
+  return NULL;
+}
+
+/*
+ * Třetí fáze: zařazení prvků jednoho rozsahu oddílů do seznamů. Seznamy
+ * oddílu i jeho prvky se vejdou do cache a různá vlákna mění různé seznamy.
+ */
+static void *htk_bulk_link(void *arg) {
+  htk_bulk_job_t *job = arg;
+  ht_item_t **lists = htk_lists(job->table);
+  job->free_items = NULL;
+
+  for (size_t j = job->from; j < job->to; j++) {
+    ht_item_t *item = &job->items[j];
+    ht_item_t *tmp = lists[job->buckets[j]];
+    while (tmp != NULL && strcmp(tmp->key, item->key) != 0) {
+      tmp = tmp->next;
+    }
+
+    //same as htk_insert, the last value of a key wins
+    if (tmp != NULL) {
+      tmp->value = item->value;
+      item->next = job->free_items;
+      job->free_items = item;
+    } else {
+      item->next = lists[job->buckets[j]];
+      lists[job->buckets[j]] = item;
+    }
+  }
+  return NULL;
+}
+
+/*
+ * Oddíl seznamu bucket, každý oddíl je rozsah width po sobě jdoucích seznamů.
+ *
+ * Počítá se bez dělení: pro width mocninu dvou posunem o shift, jinak
+ * násobením reciprocal = 2^64 / width zaokrouhleným nahoru, které je pro
+ * 32bitový bucket přesné (Lemire, Kaser, Kurz).
+ */
+static uint32_t htk_bulk_partition(uint32_t bucket, int shift,
+                                   uint64_t reciprocal) {
+  if (shift >= 0) {
+    return bucket >> shift;
+  }
+
+  //high 64 bits of reciprocal * bucket, split to avoid __int128
+  uint64_t low = (reciprocal & UINT32_MAX) * bucket;
+  uint64_t high = (reciprocal >> 32) * bucket;
+  return (uint32_t)((high + (low >> 32)) >> 32);
+}
+
+/*
+ * Spustí work pro každou práci, první v aktuálním vlákně. Pokud se vlákno
+ * nepodaří vytvořit, jeho práce proběhne také v aktuálním vlákně.
+ */
+static void htk_bulk_run(void *(*work)(void *), htk_bulk_job_t *jobs,
+                         int threads) {
+  pthread_t ids[HTK_BULK_MAX_THREADS];
+  bool started[HTK_BULK_MAX_THREADS] = {false};
+
+  for (int t = 1; t < threads; t++) {
+    started[t] = pthread_create(&ids[t], NULL, work, &jobs[t]) == 0;
+  }
+  work(&jobs[0]);
+  for (int t = 1; t < threads; t++) {
+    if (started[t]) {
+      pthread_join(ids[t], NULL);
+    } else {
+      work(&jobs[t]);
+    }
+  }
+}
+
+/*
+ * Hromadné vložení count prvků, výsledek je stejný jako u htk_insert
+ * v pořadí vstupu.
+ *
+ * Vkládání po jednom prvku skáče náhodně po tabulce mnohem větší než
+ * cache. Tady se nejdřív spočítají indexy všech klíčů, potom se prvky
+ * rozdělí podle rozsahu indexů do oddílů velkých zhruba
+ * HTK_BULK_CACHE_BYTES a do seznamů se zařazují oddíl po oddílu. Do paměti
+ * se tak kromě rozdělení přistupuje postupně. Všechny prvky jsou v jednom
+ * bloku; htk_delete ho neuvolní, smazané prvky se použijí pro další
+ * vkládání. Indexy a zařazování může počítat threads vláken.
+ *
+ * Vrací false, pokud se nepodaří alokovat pomocná pole; tabulka potom
+ * zůstane beze změny.
+ */
+bool htk_insert_bulk(htk_table_t *table, char **keys, const float *values,
+                     size_t count, int threads) {
+  if (count == 0) {
+    return true;
+  }
+  if (table->tune_left > 0) {
+    htk_tune(table, keys, count < HTK_TUNE_SAMPLE ? count : HTK_TUNE_SAMPLE);
+  }
+  threads = threads < 1 ? 1 : threads;
+  threads = threads > HTK_BULK_MAX_THREADS ? HTK_BULK_MAX_THREADS : threads;
+
+  //partitions are ranges of lists, small enough for the cache
+  size_t bytes = (size_t)table->size * sizeof(ht_item_t *) +
+                 count * sizeof(ht_item_t);
+  int bits = 0;
+  while (bits < 16 && (bytes >> bits) > HTK_BULK_CACHE_BYTES &&
+         (1 << (bits + 1)) <= table->size) {
+    bits++;
+  }
+  int partitions = 1 << bits;
+
+  //a partition is a range of width lists, the last one may be shorter
+  uint32_t width = ((uint32_t)table->size + partitions - 1) >> bits;
+  int shift = -1;
+  uint64_t reciprocal = 0;
+  if ((width & (width - 1)) == 0) {
+    shift = 0;
+    while ((UINT32_C(1) << shift) < width) {
+      shift++;
+    }
+  } else {
+    reciprocal = UINT64_MAX / width + 1;
+  }
+
+  uint32_t *buckets = malloc(count * sizeof(uint32_t));
+  uint32_t *sorted = malloc(count * sizeof(uint32_t));
+  size_t *starts = calloc(partitions + 1, sizeof(size_t));
+  htk_slab_t *slab = htk_alloc_slab(table, count);
+  if (buckets == NULL || sorted == NULL || starts == NULL || slab == NULL) {
+    free(buckets);
+    free(sorted);
+    free(starts);
+    if (slab != NULL) {
+      htk_free_slab(slab);
+    }
+    return false;
+  }
+
+  //hash all the keys in order
+  htk_bulk_job_t jobs[HTK_BULK_MAX_THREADS];
+  for (int t = 0; t < threads; t++) {
+    jobs[t] = (htk_bulk_job_t){table, keys, buckets, slab->items,
+                              count * t / threads, count * (t + 1) / threads,
+                              NULL};
+  }
+  htk_bulk_run(htk_bulk_hash, jobs, threads);
+
+  //scatter the items by partition, stable, so the input order is kept
+  for (size_t i = 0; i < count; i++) {
+    starts[htk_bulk_partition(buckets[i], shift, reciprocal) + 1]++;
+  }
+  for (int p = 0; p < partitions; p++) {
+    starts[p + 1] += starts[p];
+  }
+  for (size_t i = 0; i < count; i++) {
+    size_t j = starts[htk_bulk_partition(buckets[i], shift, reciprocal)]++;
+    slab->items[j].key = keys[i];
+    slab->items[j].value = values[i];
+    sorted[j] = buckets[i];
+  }
+  free(buckets);
+
+  //link partition by partition, each thread gets a range of partitions
+  //after the scatter starts[p] is where partition p + 1 begins
+  for (int t = 0; t < threads; t++) {
+    int first = partitions * t / threads, last = partitions * (t + 1) / threads;
+    jobs[t].buckets = sorted;
+    jobs[t].from = first == 0 ? 0 : starts[first - 1];
+    jobs[t].to = last == 0 ? 0 : starts[last - 1];
+  }
+  htk_bulk_run(htk_bulk_link, jobs, threads);
+  free(sorted);
+  free(starts);
+
+  //the block belongs to the table, duplicates can be reused
+  //a partly used first block keeps its place for htk_take_item
+  slab->count = count;
+  htk_slab_t **link = &table->slabs;
+  if (*link != NULL && (*link)->count < (*link)->capacity) {
+    link = &(*link)->next;
+  }
+  slab->next = *link;
+  *link = slab;
+  for (int t = 0; t < threads; t++) {
+    while (jobs[t].free_items != NULL) {
+      ht_item_t *item = jobs[t].free_items;
+      jobs[t].free_items = item->next;
+      item->next = table->free_items;
+      table->free_items = item;
+    }
+  }
+  return true;
+}
+
+/*
+ * Změna počtu seznamů synonym.
+ *
+ * Velikost se zaokrouhlí stejně jako v htk_init a všechny prvky se
+ * přeřadí do nových seznamů. Vrací false, pokud se nepodaří alokovat nové
+ * pole; tabulka potom zůstane beze změny. Při stejné velikosti se prvky
+ * přeřadí na místě a funkce neselže. Kurzory z htk_iter_cursor zůstávají
+ * u tabulek s HTK_SIZING_POW2 platné.
+ */
+bool htk_resize(htk_table_t *table, int size) {
+  size = htk_round_size(table->sizing, size > 0 ? size : 1);
+
+  //allocate first, so a failure leaves the table as it was
+  ht_item_t **heap_items = NULL;
+  htk_pages_t items_pages = HTK_PAGES_NORMAL;
+  if (size == table->size) {
+    heap_items = table->heap_items;
+    items_pages = table->items_pages;
+  } else if (size > MAX_HT_SIZE) {
+    heap_items = htk_alloc_pages(table->pages, size * sizeof(ht_item_t *),
+                                 &items_pages);
+    if (heap_items == NULL) {
+      return false;
+    }
+  }
+
+  //unlink all the items into one list, the old array may be the new one
+  ht_item_t **lists = htk_lists(table);
+  ht_item_t *all = NULL;
+  for (int i = 0; i < table->size; i++) {
+    ht_item_t *tmp = lists[i];
+    while (tmp != NULL) {
+      ht_item_t *next = tmp->next;
+      tmp->next = all;
+      all = tmp;
+      tmp = next;
+    }
+  }
+  if (table->heap_items != NULL && table->heap_items != heap_items) {
+    htk_free_pages(table->heap_items, table->size * sizeof(ht_item_t *),
+                   table->items_pages);
+  }
+
+  table->heap_items = heap_items;
+  table->items_pages = items_pages;
+  table->size = size;
+  table->fastmod = UINT64_MAX / (uint64_t)size + 1;
+  lists = htk_lists(table);
+  for (int i = 0; i < size; i++) {
+    lists[i] = NULL;
+  }
+
+  //link them again by the new index
+  while (all != NULL) {
+    ht_item_t *next = all->next;
+    int index = htk_index(table, all->key);
+    all->next = lists[index];
+    lists[index] = all;
+    all = next;
+  }
+  return true;
+}
+
+/*
+ * Bitově obrácené číslo.
+ */
+static uint64_t htk_reverse_bits(uint64_t v) {
+  v = ((v >> 1) & UINT64_C(0x5555555555555555)) |
+      ((v & UINT64_C(0x5555555555555555)) << 1);
+  v = ((v >> 2) & UINT64_C(0x3333333333333333)) |
+      ((v & UINT64_C(0x3333333333333333)) << 2);
+  v = ((v >> 4) & UINT64_C(0x0f0f0f0f0f0f0f0f)) |
+      ((v & UINT64_C(0x0f0f0f0f0f0f0f0f)) << 4);
+  v = ((v >> 8) & UINT64_C(0x00ff00ff00ff00ff)) |
+      ((v & UINT64_C(0x00ff00ff00ff00ff)) << 8);
+  v = ((v >> 16) & UINT64_C(0x0000ffff0000ffff)) |
+      ((v & UINT64_C(0x0000ffff0000ffff)) << 16);
+  return (v >> 32) | (v << 32);
+}
+
+/*
+ * Kurzor seznamu, který se projde po seznamu s kurzorem cursor.
+ *
+ * U HTK_SIZING_POW2 se kurzor zvyšuje v obráceném pořadí bitů jako SCAN
+ * v Redisu: seznam i se při zdvojnásobení rozdělí na i a i + size, které
+ * mají v obráceném pořadí sousední kurzory, takže žádný prvek nevypadne.
+ * Po projití všech seznamů se kurzor vrátí na 0.
+ */
+static uint64_t htk_next_cursor(const htk_table_t *table, uint64_t cursor) {
+  if (table->sizing != HTK_SIZING_POW2) {
+    return cursor + 1 < (uint64_t)table->size ? cursor + 1 : 0;
+  }
+  cursor |= ~(uint64_t)(table->size - 1);
+  cursor = htk_reverse_bits(cursor);
+  cursor++;
+  return htk_reverse_bits(cursor);
+}
+
+/*
+ * Index seznamu pro kurzor.
+ */
+static int htk_cursor_index(const htk_table_t *table, uint64_t cursor) {
+  if (table->sizing == HTK_SIZING_POW2) {
+    return cursor & (uint64_t)(table->size - 1);
+  }
+  return cursor;
+}
+
+/*
+ * Začátek procházení tabulky od kurzoru, 0 znamená od začátku.
+ *
+ * Iterátor nic nealokuje a nic nezamyká. Po změně tabulky nebo po
+ * htk_resize se nesmí použít dál, ale lze pokračovat novým iterátorem od
+ * htk_iter_cursor. U HTK_SIZING_POW2 se tak vrátí každý prvek, který v
+ * tabulce byl po celou dobu, aspoň jednou; zopakovat se může zbytek
+ * rozpracovaného seznamu a při zmenšení tabulky celé seznamy. U
+ * HTK_SIZING_PRIME to platí jen, pokud se mezitím nezměnila velikost.
+ */
+void htk_iter_begin(htk_iter_t *iter, htk_table_t *table, uint64_t cursor) {
+  iter->table = table;
+  iter->done = cursor == HTK_ITER_END;
+
+  //a cursor past the end of a smaller prime table starts over
+  if (iter->done || (table->sizing != HTK_SIZING_POW2 &&
+                     cursor >= (uint64_t)table->size)) {
+    cursor = 0;
+  }
+  iter->cursor = cursor;
+  iter->item =
+      iter->done ? NULL : htk_list(table, htk_cursor_index(table, cursor));
+}
+
+/*
+ * Další prvek tabulky, NULL po projití všech seznamů.
+ */
+ht_item_t *htk_iter_next(htk_iter_t *iter) {
+  htk_table_t *table = iter->table;
+
+  //skip to the next list with items
+  while (iter->item == NULL && !iter->done) {
+    iter->cursor = htk_next_cursor(table, iter->cursor);
+    iter->done = iter->cursor == 0;
+    if (!iter->done) {
+      iter->item = htk_list(table, htk_cursor_index(table, iter->cursor));
+    }
+  }
+
+  ht_item_t *item = iter->item;
+  if (item != NULL) {
+    iter->item = item->next;
+  }
+  return item;
+}
+
+/*
+ * Zda iterátor vrátil celý seznam synonym a stojí na jeho konci.
+ *
+ * Jen na konci seznamu ukazuje htk_iter_cursor dál; přerušení uprostřed
+ * seznamu vrátí kurzor téhož seznamu a ten se projde znovu od začátku.
+ * Kdo pokračuje po částech, má proto končit na hranici seznamu, jinak se
+ * u seznamu delšího než část nikdy nepohne.
+ */
+bool htk_iter_at_list_end(const htk_iter_t *iter) {
+  return iter->item == NULL;
+}
+
+/*
+ * Kurzor pro pokračování novým iterátorem, HTK_ITER_END po projití celé
+ * tabulky.
+ *
+ * Ukazuje na rozpracovaný seznam, pokud z něj zbývají prvky, jinak na
+ * následující seznam. Rozpracovaný první seznam má kurzor 0 stejně jako
+ * začátek, proto konec nemůže být 0 jako u SCAN.
+ */
+uint64_t htk_iter_cursor(const htk_iter_t *iter) {
+  if (iter->done) {
+    return HTK_ITER_END;
+  }
+  if (iter->item != NULL) {
+    return iter->cursor;
+  }
+  uint64_t next = htk_next_cursor(iter->table, iter->cursor);
+  return next == 0 ? HTK_ITER_END : next;
+}
+
+/*
+ * Získání hodnoty z tabulky.
+ *
+ * V případě úspěchu vrací funkce ukazatel na hodnotu prvku, v opačném
+ * případě hodnotu NULL. Seznam se přeuspořádá stejně jako v htk_search.
+ */
+float *htk_get(htk_table_t *table, char *key) {
+
+  //search for the item
+  ht_item_t *tmp = htk_search(table, key);
+
+  //if the item is found, return its value
+  if (tmp != NULL) {
+    return &tmp->value;
+  }
+
+  //else, return NULL
+  return NULL;
+}
+
+/*
+ * Smazání prvku z tabulky.
+ *
+ * Prvek se uvolní, nebo pokud má tabulka bloky prvků, vrátí se do seznamu
+ * volných prvků. Pokud prvek neexistuje, funkce nedělá nic.
+ */
+void htk_delete(htk_table_t *table, char *key) {
+
+  //set the item and the previous item
+  ht_item_t **head = &htk_lists(table)[htk_index(table, key)];
+  ht_item_t *tmp = *head;
+  ht_item_t *prev = NULL;
+
+  //search in the list, while the item is not NULL
+  while (tmp != NULL) {
+
+    //if the key is the same, delete the item
+    //and make the previous item point to the next item
+    if (strcmp(tmp->key, key) == 0) {
+
+      if (prev == NULL) {
+        *head = tmp->next;
+      } else {
+        prev->next = tmp->next;
+      }
+
+      htk_release_item(table, tmp);
+      return;
+    }
+
+    //else, go to the next item
+    prev = tmp;
+    tmp = tmp->next;
+
+  }
+}
+
+/*
+ * Smazání všech prvků z tabulky.
+ *
+ * Funkce korektně uvolní všechny alokované zdroje a uvede tabulku do stavu po 
+ * inicializaci.
+ */
+void htk_delete_all(htk_table_t *table) {
+  ht_item_t **lists = htk_lists(table);
+
+  //for all the items in the table
+  for (int i = 0; i < table->size; i++) {
+
+    //set the temporary item
+    ht_item_t *tmp = lists[i];
+
+    //for all the items in the list 
+    while (tmp != NULL) {
+
+      //delete the item and go to the next item
+      ht_item_t *next = tmp->next;
+      htk_release_item(table, tmp);
+      tmp = next;
+
+    }
+
+    //set the item to NULL
+    lists[i] = NULL;
+    
+  }
+
+  //items allocated one by one are told apart from the blocks, which go last
+  htk_free_loose_items(table);
+  while (table->slabs != NULL) {
+    htk_slab_t *next = table->slabs->next;
+    htk_free_slab(table->slabs);
+    table->slabs = next;
+  }
+  table->free_items = NULL;
+}
+
+/*
+ * Zrušení tabulky.
+ *
+ * Jako htk_delete_all, navíc uvolní pole seznamů velkých tabulek. Před dalším
+ * použitím je nutné tabulku znovu inicializovat.
+ */
+void htk_dispose(htk_table_t *table) {
+  htk_delete_all(table);
+
+  if (table->heap_items != NULL) {
+    htk_free_pages(table->heap_items, table->size * sizeof(ht_item_t *),
+                   table->items_pages);
+  }
+  table->heap_items = NULL;
+  table->items_pages = HTK_PAGES_NORMAL;
+}
@@ -0,0 +1,167 @@
+/*
+ * Hlavičkový súbor pre tabuľku s rozptýlenými položkami s kľúčovanou
+ * rozptylovacou funkciou. Prvky majú typ ht_item_t z hashtable.h, tabuľka
+ * je ale samostatný typ a hashtable.c od nej nezávisí.
+ */
+
+#ifndef IAL_HASHTABLE_KEYED_H
+#define IAL_HASHTABLE_KEYED_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "hashtable.h"
+
+/*
+ * Inštrukcie pre htk_hash_batch, predvolene skalárny kód. Pre účely
+ * testovania a meraní je možné vynútiť vektorové, ak ich procesor má, ale
+ * nie počas hromadného vkladania v iných vláknach.
+ */
+typedef enum htk_simd {
+  HTK_SIMD_SCALAR, // po jednom kľúči
+  HTK_SIMD_SSE2,   // štyri kľúče naraz v dvoch sadách registrov
+  HTK_SIMD_AVX2,   // osem kľúčov naraz v dvoch sadách registrov
+  HTK_SIMD_AUTO    // zatiaľ ako HTK_SIMD_SCALAR, vektorové jadrá sa
+                   // samy nevyberajú, AVX2 nie je rýchlejšie všade
+} htk_simd_t;
+
+extern htk_simd_t HTK_SIMD;
+
+// Rozptylovacia funkcia tabuľky
+typedef enum htk_hash_mode {
+  HTK_HASH_SUM,     // súčet znakov kľúča, rovnaký ako get_hash
+  HTK_HASH_SIPHASH, // SipHash-1-3 s tajným kľúčom tabuľky
+  HTK_HASH_FNV1A,   // FNV-1a, rýchla pre krátke kľúče, nie proti útokom
+  HTK_HASH_AUTO     // výber podľa vzorky prvých kľúčov, len v htk_options_t;
+                    // bez allow_unkeyed zostáva SipHash
+} htk_hash_mode_t;
+
+// Počet kľúčov vzorky pre HTK_HASH_AUTO
+#define HTK_TUNE_SAMPLE 1024
+
+// Výsledky výberu rozptylovacej funkcie, polia sú indexované funkciou
+typedef struct htk_tuning {
+  int sample;                        // počet kľúčov vzorky, 0 bez výberu
+  double ns_per_key[HTK_HASH_AUTO];  // čas výpočtu na kľúč
+  double chain_ratio[HTK_HASH_AUTO]; // rozptyl dĺžok zoznamov / priemer
+} htk_tuning_t;
+
+// Spôsob prevodu rozptylovacej hodnoty na index bez delenia
+typedef enum htk_sizing {
+  HTK_SIZING_PRIME, // veľkosť je prvočíslo, index cez Lemireho fastmod
+  HTK_SIZING_POW2   // veľkosť je mocnina dvoch, index cez miešanie a masku
+} htk_sizing_t;
+
+// Preusporiadanie zoznamu synoným po úspešnom vyhľadaní
+typedef enum htk_reorder {
+  HTK_REORDER_NONE,          // poradie podľa vkladania
+  HTK_REORDER_MOVE_TO_FRONT, // nájdený prvok na začiatok zoznamu
+  HTK_REORDER_TRANSPOSE      // nájdený prvok o jedno miesto dopredu
+} htk_reorder_t;
+
+// Stránky pre pole zoznamov a bloky prvkov veľkých tabuliek
+typedef enum htk_pages {
+  HTK_PAGES_NORMAL,      // malloc, každý prvok zvlášť
+  HTK_PAGES_TRANSPARENT, // mmap s madvise(MADV_HUGEPAGE), prvky v blokoch
+  HTK_PAGES_EXPLICIT     // mmap s MAP_HUGETLB po 2 MiB, inak ako TRANSPARENT
+} htk_pages_t;
+
+// Nastavenia tabuľky pre htk_init
+typedef struct htk_options {
+  htk_hash_mode_t hash;  // rozptylovacia funkcia
+  uint64_t seed[2];      // kľúč pre HTK_HASH_SIPHASH, {0, 0} znamená náhodný
+  int size;              // požadovaná veľkosť, 0 znamená HT_SIZE
+  htk_sizing_t sizing;   // zaokrúhlenie veľkosti a výpočet indexu
+  htk_reorder_t reorder; // samoorganizácia zoznamov pri htk_search
+  htk_pages_t pages;     // stránky pre pole zoznamov a prvky
+  bool allow_unkeyed;    // výber smie zvoliť funkciu bez tajného kľúča
+} htk_options_t;
+
+// Pamäť jedného oddielu pri hromadnom vkladaní, zhruba veľkosť L2
+#define HTK_BULK_CACHE_BYTES (256 * 1024)
+
+// Najviac vlákien hromadného vkladania
+#define HTK_BULK_MAX_THREADS 64
+
+// Blok prvkov z jedného hromadného vkladania, definovaný v keyed.c
+typedef struct htk_slab htk_slab_t;
+
+// Tabuľka, do veľkosti MAX_HT_SIZE bez alokácie poľa
+typedef struct htk_table {
+  ht_item_t **heap_items;               // zoznamy veľkých tabuliek, inak NULL
+  ht_item_t *inline_items[MAX_HT_SIZE]; // zoznamy malých tabuliek
+  int size;                             // počet používaných zoznamov
+  htk_sizing_t sizing;                  // výpočet indexu
+  uint64_t fastmod;                     // 2^64 / size pre HTK_SIZING_PRIME
+  htk_hash_mode_t hash;                 // rozptylovacia funkcia
+  uint64_t seed[2];                     // kľúč rozptylovacej funkcie
+  htk_reorder_t reorder;                // samoorganizácia zoznamov
+  htk_pages_t pages;                    // požadované stránky
+  htk_pages_t items_pages;              // skutočné stránky poľa heap_items
+  htk_slab_t *slabs;                    // bloky prvkov
+  ht_item_t *free_items;                // zmazané prvky na znovupoužitie
+  int tune_left;                        // vloženia do výberu pri HTK_HASH_AUTO
+  bool allow_unkeyed;                   // výber aj medzi SUM a FNV1A
+  htk_tuning_t tuning;                  // posledný výber funkcie
+} htk_table_t;
+
+// Štatistiky tabuľky z htk_stats
+typedef struct htk_stats {
+  htk_hash_mode_t hash; // aktuálna rozptylovacia funkcia
+  int size;             // počet zoznamov
+  size_t count;         // počet prvkov
+  int empty;            // počet prázdnych zoznamov
+  int max_chain;        // dĺžka najdlhšieho zoznamu
+  double chain_ratio;   // rozptyl dĺžok zoznamov / priemerná dĺžka, ideál 1
+  htk_tuning_t tuning;  // výber funkcie, ak prebehol
+} htk_stats_t;
+
+// Kurzor po prejdení celej tabuľky, začiatok je 0
+#define HTK_ITER_END UINT64_MAX
+
+// Iterátor cez všetky prvky tabuľky s kurzorom na pokračovanie
+typedef struct htk_iter {
+  htk_table_t *table; // prechádzaná tabuľka
+  uint64_t cursor;    // kurzor aktuálneho zoznamu
+  ht_item_t *item;    // ďalší prvok aktuálneho zoznamu
+  bool done;          // všetky zoznamy sú prejdené
+} htk_iter_t;
+
+uint64_t htk_siphash(const uint64_t seed[2], const char *key, size_t len);
+uint64_t htk_fnv1a(uint64_t seed, const char *key, size_t len);
+void htk_random_seed(uint64_t seed[2]);
+int htk_index_n(htk_table_t *table, const char *key, size_t len);
+ht_item_t *htk_list(const htk_table_t *table, int index);
+void htk_init(htk_table_t *table, const htk_options_t *opts);
+ht_item_t *htk_search(htk_table_t *table, char *key);
+ht_item_t *htk_search_n(htk_table_t *table, const char *key, size_t len);
+ht_item_t *htk_find_n(const htk_table_t *table, const char *key, size_t len);
+void htk_hash_batch(htk_table_t *table, char **keys, size_t n, uint64_t *out);
+void htk_search_batch(htk_table_t *table, char **keys, size_t n,
+                      ht_item_t **out);
+void htk_get_batch(htk_table_t *table, char **keys, size_t n, float **out);
+void htk_insert(htk_table_t *table, char *key, float data);
+bool htk_insert_bulk(htk_table_t *table, char **keys, const float *values,
+                     size_t count, int threads);
+float *htk_get(htk_table_t *table, char *key);
+void htk_delete(htk_table_t *table, char *key);
+void htk_delete_all(htk_table_t *table);
+bool htk_resize(htk_table_t *table, int size);
+htk_hash_mode_t htk_tune(htk_table_t *table, char **keys, size_t n);
+void htk_stats(const htk_table_t *table, htk_stats_t *stats);
+void htk_iter_begin(htk_iter_t *iter, htk_table_t *table, uint64_t cursor);
+ht_item_t *htk_iter_next(htk_iter_t *iter);
+bool htk_iter_at_list_end(const htk_iter_t *iter);
+uint64_t htk_iter_cursor(const htk_iter_t *iter);
+void htk_dispose(htk_table_t *table);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,291 @@
+/*
+ * Generátor zátěže pro server s tabulkou
+ *
+ * Každý klient nejdřív vloží své klíče a potom pro každou hloubku
+ * pipeliningu posílá dávky požadavků (9 GET na 1 SET) a měří dobu od
+ * odeslání dávky do přijetí poslední odpovědi. Klienti běží jako
+ * samostatné procesy, každou hloubku začínají společně na bariéře a
+ * výsledky posílají rodiči rourou. Propustnost je počet požadavků všech
+ * klientů děleno dobou od prvního začátku do posledního konce. Klienti
+ * posílají jen svůj 99. percentil, vypíše se proto jejich průměr, ne
+ * percentil všech dávek.
+ *
+ * Spuštění: ./loadgen [cesta k socketu] [počet klientů] [požadavků na hloubku]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
+#include "protocol.h"
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// Počet klíčů jednoho klienta
+#define LOADGEN_KEYS 10000
+
+// Nejdelší klíč včetně nuly
+#define LOADGEN_KEY_SIZE 24
+
+static const int DEPTHS[] = {1, 2, 4, 8, 16, 32, 64, 128};
+#define DEPTHS_COUNT (int)(sizeof(DEPTHS) / sizeof(DEPTHS[0]))
+
+// Výsledek jednoho klienta pro jednu hloubku
+typedef struct result {
+  double start;        // začátek první dávky
+  double end;          // konec poslední dávky
+  double mean_latency; // průměrná doba dávky [µs]
+  double p99_latency;  // 99. percentil doby dávky [µs]
+} result_t;
+
+static double now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+static int connect_to(const char *path) {
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd != -1 &&
+      connect(fd, (struct sockaddr *)&address, sizeof(address)) == -1) {
+    close(fd);
+    fd = -1;
+  }
+  return fd;
+}
+
+static bool send_all(int fd, const char *buffer, size_t length) {
+  while (length > 0) {
+    ssize_t sent = send(fd, buffer, length, 0);
+    if (sent <= 0) {
+      return false;
+    }
+    buffer += sent;
+    length -= sent;
+  }
+  return true;
+}
+
+static bool receive_all(int fd, char *buffer, size_t length) {
+  while (length > 0) {
+    ssize_t received = recv(fd, buffer, length, 0);
+    if (received <= 0) {
+      return false;
+    }
+    buffer += received;
+    length -= received;
+  }
+  return true;
+}
+
+/*
+ * Přidá požadavek na konec dávky a vrátí novou délku dávky.
+ */
+static size_t append_request(char *batch, size_t length, uint8_t op,
+                             const char *key, float value) {
+  kv_request_t request = {op, 0, strlen(key), value};
+  memcpy(batch + length, &request, sizeof(request));
+  memcpy(batch + length + sizeof(request), key, request.key_length);
+  return length + sizeof(request) + request.key_length;
+}
+
+/*
+ * Jeden klient: vloží klíče a změří všechny hloubky.
+ *
+ * I po chybě projde všechny bariéry, aby na něj ostatní klienti nečekali.
+ * Doby se počítají jen z dávek, které opravdu doběhly.
+ */
+static bool run_client(const char *path, int client, int requests,
+                       pthread_barrier_t *barrier,
+                       result_t results[DEPTHS_COUNT]) {
+  int fd = connect_to(path);
+
+  int max_depth = DEPTHS[DEPTHS_COUNT - 1];
+  char (*keys)[LOADGEN_KEY_SIZE] = malloc(LOADGEN_KEYS * sizeof(*keys));
+  char *batch = malloc(max_depth * (sizeof(kv_request_t) + LOADGEN_KEY_SIZE));
+  kv_response_t *responses = malloc(max_depth * sizeof(kv_response_t));
+  double *latencies = malloc(requests * sizeof(double));
+  bool ok = fd != -1 && keys != NULL && batch != NULL && responses != NULL &&
+            latencies != NULL;
+
+  for (int i = 0; ok && i < LOADGEN_KEYS; i++) {
+    snprintf(keys[i], LOADGEN_KEY_SIZE, "c%d:k%d", client, i);
+  }
+
+  //load the keys, pipelined by the largest depth
+  for (int i = 0; ok && i < LOADGEN_KEYS; i += max_depth) {
+    int count = LOADGEN_KEYS - i < max_depth ? LOADGEN_KEYS - i : max_depth;
+    size_t length = 0;
+    for (int j = 0; j < count; j++) {
+      length = append_request(batch, length, KV_SET, keys[i + j], i + j);
+    }
+    ok = send_all(fd, batch, length) &&
+         receive_all(fd, (char *)responses, count * sizeof(kv_response_t));
+  }
+
+  //measure every depth with the same number of requests
+  unsigned state = client * 7919 + 1;
+  for (int d = 0; d < DEPTHS_COUNT; d++) {
+    int depth = DEPTHS[d], batches = requests / depth;
+
+    //wait for the others even after an error, so they do not hang
+    pthread_barrier_wait(barrier);
+    results[d].start = now_sec();
+
+    int completed = 0;
+    for (int b = 0; ok && b < batches; b++) {
+      size_t length = 0;
+      for (int j = 0; j < depth; j++) {
+        state = state * 1103515245 + 12345;
+        int key = (state >> 8) % LOADGEN_KEYS;
+        length = append_request(batch, length, (state >> 4) % 10 ? KV_GET : KV_SET,
+                                keys[key], key);
+      }
+
+      double sent = now_sec();
+      ok = send_all(fd, batch, length) &&
+           receive_all(fd, (char *)responses, depth * sizeof(kv_response_t));
+      if (ok) {
+        latencies[completed++] = (now_sec() - sent) * 1e6;
+      }
+    }
+
+    results[d].end = now_sec();
+    results[d].mean_latency = 0;
+    results[d].p99_latency = 0;
+    if (completed > 0) {
+      double sum = 0;
+      for (int b = 0; b < completed; b++) {
+        sum += latencies[b];
+      }
+      qsort(latencies, completed, sizeof(double), compare_doubles);
+      results[d].mean_latency = sum / completed;
+      results[d].p99_latency = latencies[(int)(completed * 0.99)];
+    }
+  }
+
+  free(keys);
+  free(batch);
+  free(responses);
+  free(latencies);
+  if (fd != -1) {
+    close(fd);
+  }
+  return ok;
+}
+
+int main(int argc, char *argv[]) {
+  const char *path = argc > 1 ? argv[1] : KV_SOCKET_PATH;
+  int clients = argc > 2 ? atoi(argv[2]) : 1;
+  int requests = argc > 3 ? atoi(argv[3]) : 200000;
+  if (clients < 1 || requests < DEPTHS[DEPTHS_COUNT - 1]) {
+    fprintf(stderr, "Usage: %s [socket] [clients] [requests per depth]\n",
+            argv[0]);
+    return 1;
+  }
+
+  //one process per client, results come back through a pipe
+  int pipes[2];
+  pthread_barrier_t *barrier =
+      mmap(NULL, sizeof(pthread_barrier_t), PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (pipe(pipes) == -1 || barrier == MAP_FAILED) {
+    perror("Cannot start clients");
+    return 1;
+  }
+  pthread_barrierattr_t attr;
+  pthread_barrierattr_init(&attr);
+  pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+  pthread_barrier_init(barrier, &attr, clients);
+  pthread_barrierattr_destroy(&attr);
+
+  pid_t *children = malloc(clients * sizeof(pid_t));
+  if (children == NULL) {
+    perror("Cannot start clients");
+    return 1;
+  }
+  for (int c = 0; c < clients; c++) {
+    children[c] = fork();
+    if (children[c] == 0) {
+      close(pipes[0]);
+      result_t results[DEPTHS_COUNT];
+      bool ok = run_client(path, c, requests, barrier, results);
+      if (ok) {
+        ok = write(pipes[1], results, sizeof(results)) == sizeof(results);
+      }
+      _exit(ok ? 0 : 1);
+    }
+
+    //the started clients would wait on the barrier for the missing ones
+    if (children[c] == -1) {
+      perror("Cannot start clients");
+      for (int started = 0; started < c; started++) {
+        kill(children[started], SIGKILL);
+      }
+      while (wait(NULL) > 0) {
+      }
+      free(children);
+      return 1;
+    }
+  }
+  free(children);
+  close(pipes[1]);
+
+  //span from the first start to the last end, average the latencies
+  result_t total[DEPTHS_COUNT];
+  int reported = 0;
+  result_t results[DEPTHS_COUNT];
+  while (read(pipes[0], results, sizeof(results)) == sizeof(results)) {
+    for (int d = 0; d < DEPTHS_COUNT; d++) {
+      if (reported == 0) {
+        total[d] = results[d];
+        continue;
+      }
+      total[d].start = results[d].start < total[d].start ? results[d].start
+                                                          : total[d].start;
+      total[d].end = results[d].end > total[d].end ? results[d].end
+                                                   : total[d].end;
+      total[d].mean_latency += results[d].mean_latency;
+      total[d].p99_latency += results[d].p99_latency;
+    }
+    reported++;
+  }
+  while (wait(NULL) > 0) {
+  }
+  if (reported == 0) {
+    fprintf(stderr, "No client finished, is the server running on %s?\n",
+            path);
+    return 1;
+  }
+
+  printf("%d client(s), %d requests per depth, 90%% GET / 10%% SET\n",
+         reported, requests);
+  printf("%6s %14s %18s %22s\n", "depth", "Krequests/s", "mean batch [us]",
+         "mean client p99 [us]");
+  for (int d = 0; d < DEPTHS_COUNT; d++) {
+    double sent = (double)reported * (requests / DEPTHS[d]) * DEPTHS[d];
+    printf("%6d %14.1f %18.1f %22.1f\n", DEPTHS[d],
+           sent / (total[d].end - total[d].start) / 1e3,
+           total[d].mean_latency / reported, total[d].p99_latency / reported);
+  }
+  return reported == clients ? 0 : 1;
+}
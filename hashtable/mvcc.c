@@ -0,0 +1,406 @@
+/*
+ * Tabulka s rozptýlenými položkami s verzemi prvků a snímky
+ *
+ * Zapisovatel drží zámek tabulky a každou změnou zvýší číslo verze. Prvek
+ * se nikdy nemění na místě: vložení přidá novou verzi na začátek seznamu
+ * synonym s born rovným nové verzi, nahrazení i smazání jen zapíše starému
+ * prvku died. Snímka s verzí s vidí prvky, pro které born <= s < died.
+ *
+ * Mrtvé prvky čekají ve frontě seřazené podle died. Jakmile je nevidí ani
+ * nejstarší otevřená snímka, odpojí se ze seznamu. Čtenář, který na nich
+ * právě stojí, ale může jít dál po jejich next, proto se odpojené prvky
+ * označí novou verzí a uvolní se, až budou všechny otevřené snímky aspoň
+ * tak nové. Snímka pořízená po odpojení se k prvku nemůže dostat.
+ *
+ * Snímka si zapíše verzi do volného místa v poli snapshots a pak ověří, že
+ * se verze mezitím nezměnila. Pokud by úklid místo přehlédl, proběhl před
+ * zápisem a verze by se při něm zvýšila, takže snímka verzi zopakuje.
+ *
+ * Tabulka neroste, počet seznamů se určí při inicializaci. Úklid spouští
+ * jen zapisovatel, po HTV_COLLECT_INTERVAL změnách nebo voláním
+ * htv_collect. Rozptylovací funkce je vždy SipHash, změna funkce by
+ * přeřadila prvky, po kterých právě jdou čtenáři snímek.
+ */
+
+#include "mvcc.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Index seznamu synonym pro klíč délky len.
+ */
+static uint32_t htv_bucket(const htv_table_t *table, const char *key,
+                           size_t len) {
+  return htk_siphash(table->seed, key, len) & (table->size - 1);
+}
+
+/*
+ * Inicializace tabulky.
+ *
+ * Velikost se zaokrouhlí nahoru na mocninu dvou. Vrací false, pokud se
+ * nepodaří alokovat pole seznamů nebo vytvořit zámek.
+ */
+bool htv_init(htv_table_t *table, uint32_t size) {
+
+  //round the size up to a power of two
+  uint32_t pow2 = 1;
+  while (pow2 < size && pow2 < (UINT32_C(1) << 31)) {
+    pow2 *= 2;
+  }
+
+  //all the lists are empty
+  table->buckets = calloc(pow2, sizeof(htv_item_t *));
+  if (table->buckets == NULL) {
+    return false;
+  }
+  if (pthread_mutex_init(&table->lock, NULL) != 0) {
+    free(table->buckets);
+    return false;
+  }
+  table->size = pow2;
+  htk_random_seed(table->seed);
+
+  //version 0 marks a free snapshot slot, so the table starts at 1
+  table->version = 1;
+  memset(table->snapshots, 0, sizeof(table->snapshots));
+  table->dead_head = NULL;
+  table->dead_tail = NULL;
+  table->retired_head = NULL;
+  table->retired_tail = NULL;
+  table->count = 0;
+  table->versions = 0;
+  table->writes = 0;
+  return true;
+}
+
+/*
+ * Platná verze klíče v poslední verzi tabulky, jen pro zapisovatele.
+ */
+static htv_item_t *htv_find_alive(htv_table_t *table, uint32_t bucket,
+                                  const char *key) {
+  for (htv_item_t *item = table->buckets[bucket]; item != NULL;
+       item = item->next) {
+    if (item->died == HTV_ALIVE && strcmp(item->key, key) == 0) {
+      return item;
+    }
+  }
+  return NULL;
+}
+
+/*
+ * Verze nejstarší otevřené snímky, bez snímek poslední verze.
+ */
+static uint64_t htv_oldest(htv_table_t *table) {
+  uint64_t oldest = table->version;
+  for (int i = 0; i < HTV_MAX_SNAPSHOTS; i++) {
+    uint64_t version = __atomic_load_n(&table->snapshots[i], __ATOMIC_SEQ_CST);
+    if (version != 0 && version < oldest) {
+      oldest = version;
+    }
+  }
+  return oldest;
+}
+
+/*
+ * Odpojení prvku ze seznamu. Jeho next zůstává pro čtenáře, kteří na něm
+ * stojí.
+ */
+static void htv_unlink(htv_table_t *table, htv_item_t *item) {
+  uint32_t bucket = htv_bucket(table, item->key, strlen(item->key));
+  htv_item_t **link = &table->buckets[bucket];
+  while (*link != item) {
+    link = &(*link)->next;
+  }
+  __atomic_store_n(link, item->next, __ATOMIC_RELEASE);
+}
+
+/*
+ * Úklid pod zámkem zapisovatele, vrací počet uvolněných prvků.
+ */
+static size_t htv_collect_locked(htv_table_t *table) {
+  table->writes = 0;
+  uint64_t oldest = htv_oldest(table);
+
+  //unlink the versions that no open snapshot can see
+  bool unlinked = false;
+  while (table->dead_head != NULL && table->dead_head->died <= oldest) {
+    htv_item_t *item = table->dead_head;
+    table->dead_head = item->dead_next;
+    htv_unlink(table, item);
+    item->retired = table->version + 1;
+    item->dead_next = NULL;
+    if (table->retired_tail != NULL) {
+      table->retired_tail->dead_next = item;
+    } else {
+      table->retired_head = item;
+    }
+    table->retired_tail = item;
+    unlinked = true;
+  }
+  if (table->dead_head == NULL) {
+    table->dead_tail = NULL;
+  }
+
+  //snapshots taken from now on cannot reach the unlinked items
+  if (unlinked) {
+    __atomic_store_n(&table->version, table->version + 1, __ATOMIC_SEQ_CST);
+    oldest = htv_oldest(table);
+  }
+
+  //free the unlinked items no reader can stand on anymore
+  size_t freed = 0;
+  while (table->retired_head != NULL &&
+         table->retired_head->retired <= oldest) {
+    htv_item_t *item = table->retired_head;
+    table->retired_head = item->dead_next;
+    free(item->key);
+    free(item);
+    table->versions--;
+    freed++;
+  }
+  if (table->retired_head == NULL) {
+    table->retired_tail = NULL;
+  }
+  return freed;
+}
+
+/*
+ * Ukončení platnosti prvku ve verzi version.
+ */
+static void htv_kill(htv_table_t *table, htv_item_t *item, uint64_t version) {
+  __atomic_store_n(&item->died, version, __ATOMIC_RELAXED);
+  item->dead_next = NULL;
+  if (table->dead_tail != NULL) {
+    table->dead_tail->dead_next = item;
+  } else {
+    table->dead_head = item;
+  }
+  table->dead_tail = item;
+}
+
+/*
+ * Zveřejnění nové verze, případně s úklidem.
+ */
+static void htv_publish(htv_table_t *table, uint64_t version) {
+  __atomic_store_n(&table->version, version, __ATOMIC_SEQ_CST);
+  if (++table->writes >= HTV_COLLECT_INTERVAL) {
+    htv_collect_locked(table);
+  }
+}
+
+/*
+ * Vložení nového prvku do tabulky.
+ *
+ * Tabulka si klíč zkopíruje. Pokud klíč už v tabulce je, vznikne jeho nová
+ * verze a stará zůstane viditelná pro starší snímky. Vrací false, pokud se
+ * nepodaří alokovat prvek.
+ */
+bool htv_insert(htv_table_t *table, const char *key, float value) {
+  size_t length = strlen(key);
+  uint32_t bucket = htv_bucket(table, key, length);
+
+  //allocate outside the lock
+  htv_item_t *item = malloc(sizeof(htv_item_t));
+  char *copy = malloc(length + 1);
+  if (item == NULL || copy == NULL) {
+    free(item);
+    free(copy);
+    return false;
+  }
+  memcpy(copy, key, length + 1);
+
+  pthread_mutex_lock(&table->lock);
+  uint64_t version = table->version + 1;
+  htv_item_t *old = htv_find_alive(table, bucket, key);
+
+  //the new version goes first, older snapshots skip it by born
+  item->key = copy;
+  item->value = value;
+  item->born = version;
+  item->died = HTV_ALIVE;
+  item->retired = 0;
+  item->dead_next = NULL;
+  item->next = table->buckets[bucket];
+  __atomic_store_n(&table->buckets[bucket], item, __ATOMIC_RELEASE);
+  table->versions++;
+
+  if (old != NULL) {
+    htv_kill(table, old, version);
+  } else {
+    table->count++;
+  }
+  htv_publish(table, version);
+  pthread_mutex_unlock(&table->lock);
+  return true;
+}
+
+/*
+ * Smazání prvku z tabulky.
+ *
+ * Prvek zůstane viditelný pro snímky pořízené před smazáním. Pokud prvek
+ * neexistuje, funkce nedělá nic.
+ */
+void htv_delete(htv_table_t *table, const char *key) {
+  uint32_t bucket = htv_bucket(table, key, strlen(key));
+
+  pthread_mutex_lock(&table->lock);
+  htv_item_t *item = htv_find_alive(table, bucket, key);
+  if (item != NULL) {
+    uint64_t version = table->version + 1;
+    htv_kill(table, item, version);
+    table->count--;
+    htv_publish(table, version);
+  }
+  pthread_mutex_unlock(&table->lock);
+}
+
+/*
+ * Uvolnění verzí, které už žádná snímka nevidí.
+ *
+ * Zapisovatel funkci volá sám po HTV_COLLECT_INTERVAL změnách. Po uvolnění
+ * poslední snímky ji lze zavolat, aby se paměť vrátila hned. Vrací počet
+ * uvolněných prvků.
+ */
+size_t htv_collect(htv_table_t *table) {
+  pthread_mutex_lock(&table->lock);
+  size_t freed = htv_collect_locked(table);
+  pthread_mutex_unlock(&table->lock);
+  return freed;
+}
+
+/*
+ * Pořízení snímky poslední verze tabulky, bez zámku.
+ *
+ * Snímka drží staré verze prvků v paměti, dokud se neuvolní funkcí
+ * htv_snapshot_release. Vrací false, pokud je otevřeno už
+ * HTV_MAX_SNAPSHOTS snímek.
+ */
+bool htv_snapshot_take(htv_table_t *table, htv_snapshot_t *snapshot) {
+  uint64_t version = __atomic_load_n(&table->version, __ATOMIC_SEQ_CST);
+
+  for (int i = 0; i < HTV_MAX_SNAPSHOTS; i++) {
+    uint64_t expected = 0;
+    if (!__atomic_compare_exchange_n(&table->snapshots[i], &expected, version,
+                                     false, __ATOMIC_SEQ_CST,
+                                     __ATOMIC_RELAXED)) {
+      continue;
+    }
+
+    //a collection that missed the slot has moved the version since
+    uint64_t current;
+    while ((current = __atomic_load_n(&table->version, __ATOMIC_SEQ_CST)) !=
+           version) {
+      version = current;
+      __atomic_store_n(&table->snapshots[i], version, __ATOMIC_SEQ_CST);
+    }
+
+    snapshot->table = table;
+    snapshot->version = version;
+    snapshot->slot = i;
+    return true;
+  }
+  return false;
+}
+
+/*
+ * Zda je prvek platný ve verzi version.
+ */
+static bool htv_visible(const htv_item_t *item, uint64_t version) {
+  return item->born <= version &&
+         version < __atomic_load_n(&item->died, __ATOMIC_RELAXED);
+}
+
+/*
+ * Získání hodnoty klíče ve verzi snímky, bez zámku.
+ *
+ * Pokud klíč ve snímce existuje, zapíše jeho hodnotu do value a vrací true.
+ */
+bool htv_snapshot_get(const htv_snapshot_t *snapshot, const char *key,
+                      float *value) {
+  htv_table_t *table = snapshot->table;
+  uint32_t bucket = htv_bucket(table, key, strlen(key));
+
+  htv_item_t *item = __atomic_load_n(&table->buckets[bucket], __ATOMIC_ACQUIRE);
+  while (item != NULL) {
+    if (htv_visible(item, snapshot->version) && strcmp(item->key, key) == 0) {
+      *value = item->value;
+      return true;
+    }
+    item = __atomic_load_n(&item->next, __ATOMIC_ACQUIRE);
+  }
+  return false;
+}
+
+/*
+ * Uvolnění snímky. Prvky vrácené ze snímky se po ní už nesmí použít.
+ */
+void htv_snapshot_release(htv_snapshot_t *snapshot) {
+  __atomic_store_n(&snapshot->table->snapshots[snapshot->slot], 0,
+                   __ATOMIC_RELEASE);
+  snapshot->table = NULL;
+}
+
+/*
+ * Začátek procházení prvků platných ve snímce.
+ */
+void htv_iter_begin(htv_iter_t *iter, const htv_snapshot_t *snapshot) {
+  iter->snapshot = snapshot;
+  iter->bucket = 0;
+  iter->item = __atomic_load_n(&snapshot->table->buckets[0], __ATOMIC_ACQUIRE);
+}
+
+/*
+ * Další prvek platný ve snímce, NULL po projití celé tabulky.
+ *
+ * Každý klíč snímky se vrátí právě jednou, bez ohledu na souběžné změny.
+ */
+htv_item_t *htv_iter_next(htv_iter_t *iter) {
+  htv_table_t *table = iter->snapshot->table;
+
+  for (;;) {
+    while (iter->item == NULL) {
+      if (++iter->bucket >= table->size) {
+        return NULL;
+      }
+      iter->item =
+          __atomic_load_n(&table->buckets[iter->bucket], __ATOMIC_ACQUIRE);
+    }
+
+    htv_item_t *item = iter->item;
+    iter->item = __atomic_load_n(&item->next, __ATOMIC_ACQUIRE);
+    if (htv_visible(item, iter->snapshot->version)) {
+      return item;
+    }
+  }
+}
+
+/*
+ * Zrušení tabulky, žádná snímka nesmí být otevřená.
+ */
+void htv_dispose(htv_table_t *table) {
+  for (uint32_t i = 0; i < table->size; i++) {
+    htv_item_t *item = table->buckets[i];
+    while (item != NULL) {
+      htv_item_t *next = item->next;
+      free(item->key);
+      free(item);
+      item = next;
+    }
+  }
+  while (table->retired_head != NULL) {
+    htv_item_t *next = table->retired_head->dead_next;
+    free(table->retired_head->key);
+    free(table->retired_head);
+    table->retired_head = next;
+  }
+
+  free(table->buckets);
+  pthread_mutex_destroy(&table->lock);
+  table->buckets = NULL;
+  table->size = 0;
+  table->dead_head = NULL;
+  table->dead_tail = NULL;
+  table->retired_tail = NULL;
+  table->count = 0;
+  table->versions = 0;
+}
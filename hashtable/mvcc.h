@@ -0,0 +1,79 @@
+/*
+ * Hlavičkový súbor pre tabuľku s verziami prvkov a snímkami.
+ *
+ * Každá zmena tabuľky vytvorí novú verziu. Snímka si zapamätá verziu, v
+ * ktorej vznikla, a vidí len prvky platné v tejto verzii, aj keď
+ * zapisovateľ medzitým vkladá a maže. Čitatelia snímok nezamykajú, staré
+ * verzie prvkov sa uvoľnia, až keď ich žiadna otvorená snímka nevidí.
+ */
+
+#ifndef IAL_HASHTABLE_MVCC_H
+#define IAL_HASHTABLE_MVCC_H
+
+#include "keyed.h"
+#include <pthread.h>
+
+// Počet naraz otvorených snímok
+#define HTV_MAX_SNAPSHOTS 64
+
+// Počet zmien, po ktorých zapisovateľ sám zavolá htv_collect
+#define HTV_COLLECT_INTERVAL 1024
+
+// Verzia died prvku, ktorý ešte nebol zmazaný ani nahradený
+#define HTV_ALIVE UINT64_MAX
+
+// Verzia prvku
+typedef struct htv_item {
+  char *key;                  // kópia kľúča
+  float value;                // hodnota prvku
+  uint64_t born;              // prvá verzia, v ktorej je prvok platný
+  uint64_t died;              // prvá verzia, v ktorej už platný nie je
+  uint64_t retired;           // verzia, v ktorej bol odpojený zo zoznamu
+  struct htv_item *next;      // ďalšie synonymum alebo staršia verzia
+  struct htv_item *dead_next; // ďalší prvok vo fronte mŕtvych alebo odpojených
+} htv_item_t;
+
+// Tabuľka s verziami, jeden zapisovateľ naraz a ľubovoľne veľa čitateľov
+typedef struct htv_table {
+  htv_item_t **buckets;                  // prvá verzia každého zoznamu
+  uint32_t size;                         // počet zoznamov, mocnina dvoch
+  uint64_t seed[2];                      // kľúč rozptylovacej funkcie
+  uint64_t version;                      // posledná zverejnená verzia
+  uint64_t snapshots[HTV_MAX_SNAPSHOTS]; // verzie otvorených snímok, 0 je voľné
+  pthread_mutex_t lock;                  // zámok zapisovateľov
+  htv_item_t *dead_head;                 // nahradené a zmazané prvky podľa died
+  htv_item_t *dead_tail;                 // koniec fronty mŕtvych
+  htv_item_t *retired_head;              // odpojené prvky podľa retired
+  htv_item_t *retired_tail;              // koniec fronty odpojených
+  size_t count;                          // počet kľúčov v poslednej verzii
+  size_t versions;                       // počet alokovaných prvkov
+  unsigned writes;                       // zmeny od posledného htv_collect
+} htv_table_t;
+
+// Snímka tabuľky
+typedef struct htv_snapshot {
+  htv_table_t *table; // tabuľka snímky
+  uint64_t version;   // verzia, ktorú snímka vidí
+  int slot;           // miesto v table->snapshots
+} htv_snapshot_t;
+
+// Iterátor cez prvky platné v snímke
+typedef struct htv_iter {
+  const htv_snapshot_t *snapshot; // prechádzaná snímka
+  uint32_t bucket;                // aktuálny zoznam
+  htv_item_t *item;               // ďalší prvok aktuálneho zoznamu
+} htv_iter_t;
+
+bool htv_init(htv_table_t *table, uint32_t size);
+bool htv_insert(htv_table_t *table, const char *key, float value);
+void htv_delete(htv_table_t *table, const char *key);
+size_t htv_collect(htv_table_t *table);
+bool htv_snapshot_take(htv_table_t *table, htv_snapshot_t *snapshot);
+bool htv_snapshot_get(const htv_snapshot_t *snapshot, const char *key,
+                      float *value);
+void htv_snapshot_release(htv_snapshot_t *snapshot);
+void htv_iter_begin(htv_iter_t *iter, const htv_snapshot_t *snapshot);
+htv_item_t *htv_iter_next(htv_iter_t *iter);
+void htv_dispose(htv_table_t *table);
+
+#endif
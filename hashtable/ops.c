@@ -0,0 +1,431 @@
+/*
+ * Operátory spojení a seskupení nad tabulkou s rozptýlenými položkami
+ *
+ * Hashovací spojení nejdřív načte celou sestavovanou stranu a podle její
+ * velikosti zvolí počet oddílů tak, aby se tabulka jednoho oddílu vešla do
+ * cache. Oddíl určují horní bity SipHash klíče, řádky se do tabulek vkládají
+ * seřazené podle oddílů. Zkoušená strana se čte po dávkách, každá dávka se
+ * stejně seřadí podle oddílů a do tabulek se hledá oddíl po oddílu přes
+ * htk_search_batch, takže se mezi tabulkami neskáče u každého řádku.
+ *
+ * Seskupení sčítá hodnoty přímo v prvcích tabulky přes ukazatel z htk_get.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "ops.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Nejvýše 2^10 oddílů spojení
+#define HT_JOIN_MAX_BITS 10
+
+// Velikost kusu paměti pro kopie klíčů
+#define HT_CHUNK_SIZE 65536
+
+// Kus paměti pro kopie klíčů
+struct ht_chunk {
+  struct ht_chunk *next; // předchozí kus
+  size_t used;           // počet použitých bajtů
+  size_t size;           // velikost data
+  char data[];           // klíče ukončené nulou
+};
+
+/*
+ * Zkopíruje klíč do kusů paměti operátoru. Vrací NULL, pokud se nepodaří
+ * alokovat nový kus.
+ */
+static char *copy_key(ht_chunk_t **chunks, const char *key) {
+  size_t len = strlen(key) + 1;
+  ht_chunk_t *chunk = *chunks;
+
+  //start a new chunk when the key does not fit
+  if (chunk == NULL || chunk->size - chunk->used < len) {
+    size_t size = len > HT_CHUNK_SIZE ? len : HT_CHUNK_SIZE;
+    chunk = malloc(sizeof(ht_chunk_t) + size);
+    if (chunk == NULL) {
+      return NULL;
+    }
+    chunk->next = *chunks;
+    chunk->used = 0;
+    chunk->size = size;
+    *chunks = chunk;
+  }
+
+  char *copy = chunk->data + chunk->used;
+  memcpy(copy, key, len);
+  chunk->used += len;
+  return copy;
+}
+
+static void free_chunks(ht_chunk_t **chunks) {
+  while (*chunks != NULL) {
+    ht_chunk_t *next = (*chunks)->next;
+    free(*chunks);
+    *chunks = next;
+  }
+}
+
+/*
+ * Otevření zdroje z CSV souboru.
+ *
+ * Soubor zůstává ve vlastnictví volajícího. Sloupce jsou odděleny čárkou,
+ * uvozovky se nezpracovávají. Řádky bez obou sloupců nebo s hodnotou, která
+ * není číslo, se přeskočí, takže se přeskočí i řádek s názvy sloupců.
+ */
+void ht_csv_open(ht_csv_t *csv, FILE *file, int key_column, int value_column) {
+  csv->file = file;
+  csv->key_column = key_column;
+  csv->value_column = value_column;
+  csv->line = NULL;
+  csv->line_size = 0;
+  csv->text = NULL;
+  csv->text_size = 0;
+}
+
+/*
+ * Načtení další dávky z CSV souboru, funkce typu ht_source_t.
+ *
+ * Klíče dávky jsou v bufferu zdroje a platí do dalšího volání.
+ */
+int ht_csv_next(void *context, ht_batch_t *batch) {
+  ht_csv_t *csv = context;
+  size_t offsets[HT_BATCH_SIZE];
+  size_t used = 0;
+  batch->count = 0;
+
+  while (batch->count < HT_BATCH_SIZE &&
+         getline(&csv->line, &csv->line_size, csv->file) != -1) {
+
+    //find both columns
+    char *key = NULL, *value = NULL;
+    size_t key_length = 0;
+    char *field = csv->line;
+    for (int column = 0; field != NULL && (key == NULL || value == NULL);
+         column++) {
+      char *end = field + strcspn(field, ",\r\n");
+      if (column == csv->key_column) {
+        key = field;
+        key_length = end - field;
+      }
+      if (column == csv->value_column) {
+        value = field;
+      }
+      field = *end == ',' ? end + 1 : NULL;
+    }
+    if (key == NULL || value == NULL) {
+      continue;
+    }
+
+    //the whole value column must be a number
+    char *value_end;
+    float number = strtof(value, &value_end);
+    if (value_end == value || strchr(",\r\n", *value_end) == NULL) {
+      continue;
+    }
+
+    //keep the key, the buffer may move, so remember only the offset
+    if (used + key_length + 1 > csv->text_size) {
+      size_t size = csv->text_size ? csv->text_size : 4096;
+      while (size < used + key_length + 1) {
+        size *= 2;
+      }
+      char *text = realloc(csv->text, size);
+      if (text == NULL) {
+        break;
+      }
+      csv->text = text;
+      csv->text_size = size;
+    }
+    memcpy(csv->text + used, key, key_length);
+    csv->text[used + key_length] = '\0';
+    offsets[batch->count] = used;
+    batch->values[batch->count] = number;
+    batch->count++;
+    used += key_length + 1;
+  }
+
+  for (int i = 0; i < batch->count; i++) {
+    batch->keys[i] = csv->text + offsets[i];
+  }
+  return batch->count;
+}
+
+/*
+ * Uvolnění bufferů zdroje, soubor se nezavírá.
+ */
+void ht_csv_close(ht_csv_t *csv) {
+  free(csv->line);
+  free(csv->text);
+  csv->line = NULL;
+  csv->text = NULL;
+}
+
+/*
+ * Oddíl spojení pro klíč.
+ */
+static int ht_partition(const ht_join_t *join, const char *key) {
+  if (join->partitions == 1) {
+    return 0;
+  }
+  return htk_siphash(join->seed, key, strlen(key)) >> join->shift;
+}
+
+/*
+ * Inicializace spojení.
+ *
+ * cache_bytes je paměť, do které se má vejít tabulka jednoho oddílu,
+ * 0 znamená HT_JOIN_CACHE_BYTES.
+ */
+void ht_join_init(ht_join_t *join, size_t cache_bytes) {
+  join->cache_bytes = cache_bytes > 0 ? cache_bytes : HT_JOIN_CACHE_BYTES;
+  join->tables = NULL;
+  join->partitions = 0;
+  join->shift = 64;
+  join->rows = 0;
+  join->chunks = NULL;
+  htk_random_seed(join->seed);
+}
+
+/*
+ * Sestavení tabulek spojení z celého zdroje.
+ *
+ * Volá se jednou po ht_join_init. Klíče se zkopírují. Při opakovaném klíči
+ * platí poslední hodnota jako u htk_insert. Vrací false, pokud dojde paměť;
+ * spojení je potom nutné zrušit.
+ */
+bool ht_build_from_stream(ht_join_t *join, ht_source_t next, void *context) {
+  char **keys = NULL;
+  float *values = NULL;
+  size_t rows = 0, capacity = 0, key_bytes = 0;
+  bool ok = true;
+
+  //stage the whole build side, the partition count depends on its size
+  ht_batch_t batch;
+  int count;
+  while (ok && (count = next(context, &batch)) > 0) {
+    if (rows + count > capacity) {
+      capacity = capacity ? capacity * 2 : HT_BATCH_SIZE;
+      char **new_keys = realloc(keys, capacity * sizeof(char *));
+      keys = new_keys ? new_keys : keys;
+      float *new_values = realloc(values, capacity * sizeof(float));
+      values = new_values ? new_values : values;
+      if (new_keys == NULL || new_values == NULL) {
+        ok = false;
+        break;
+      }
+    }
+    for (int i = 0; ok && i < count; i++) {
+      keys[rows] = copy_key(&join->chunks, batch.keys[i]);
+      values[rows] = batch.values[i];
+      ok = keys[rows] != NULL;
+      key_bytes += strlen(batch.keys[i]) + 1;
+      rows++;
+    }
+  }
+
+  //split until one table with its items and keys fits the budget
+  size_t bytes = rows * (sizeof(ht_item_t) + 2 * sizeof(ht_item_t *)) +
+                 key_bytes;
+  int bits = 0;
+  while (bits < HT_JOIN_MAX_BITS && (bytes >> bits) > join->cache_bytes) {
+    bits++;
+  }
+  join->partitions = 1 << bits;
+  join->shift = 64 - bits;
+  join->rows = rows;
+
+  //order the rows by partition with a counting sort
+  size_t *order = malloc(rows * sizeof(size_t) + 1);
+  unsigned short *parts = malloc(rows * sizeof(unsigned short) + 1);
+  size_t *starts = calloc(join->partitions + 1, sizeof(size_t));
+  join->tables = malloc(join->partitions * sizeof(htk_table_t));
+  ok = ok && order != NULL && parts != NULL && starts != NULL &&
+       join->tables != NULL;
+  if (!ok) {
+    join->partitions = 0;
+  }
+
+  for (size_t i = 0; ok && i < rows; i++) {
+    parts[i] = ht_partition(join, keys[i]);
+    starts[parts[i] + 1]++;
+  }
+  for (int p = 0; ok && p < join->partitions; p++) {
+    starts[p + 1] += starts[p];
+  }
+
+  //a table per partition, sized for its rows
+  for (int p = 0; ok && p < join->partitions; p++) {
+    size_t size = starts[p + 1] - starts[p];
+    htk_options_t opts = {HTK_HASH_SIPHASH, {join->seed[0], join->seed[1]},
+                          size > 0 ? size : 1, HTK_SIZING_POW2,
+                          HTK_REORDER_NONE};
+    htk_init(&join->tables[p], &opts);
+  }
+  for (size_t i = 0; ok && i < rows; i++) {
+    order[starts[parts[i]]++] = i;
+  }
+
+  //insert partition by partition, each table stays in cache meanwhile
+  for (size_t j = 0; ok && j < rows; j++) {
+    size_t i = order[j];
+    htk_insert(&join->tables[parts[i]], keys[i], values[i]);
+  }
+
+  free(order);
+  free(parts);
+  free(starts);
+  free(keys);
+  free(values);
+  return ok;
+}
+
+/*
+ * Zkoušení spojení celým zdrojem.
+ *
+ * Pro každý řádek zdroje s klíčem v sestavené straně přidá dvojici do dávky
+ * nalezených a plnou dávku předá funkci emit. Pořadí dvojic v dávce nemusí
+ * odpovídat pořadí řádků. Klíče dvojic patří spojení a platí do
+ * ht_join_dispose. Vrací počet nalezených dvojic.
+ */
+size_t ht_probe_stream(ht_join_t *join, ht_source_t next, void *context,
+                       ht_emit_t emit, void *emit_context) {
+  if (join->partitions == 0) {
+    return 0;
+  }
+
+  ht_batch_t batch;
+  ht_matches_t matches;
+  matches.count = 0;
+  size_t total = 0;
+  int count;
+
+  while ((count = next(context, &batch)) > 0) {
+    int order[HT_BATCH_SIZE];
+    unsigned short parts[HT_BATCH_SIZE];
+
+    //order the batch by partition, so each table is probed in one run
+    if (join->partitions == 1) {
+      for (int i = 0; i < count; i++) {
+        order[i] = i;
+        parts[i] = 0;
+      }
+    } else {
+      int starts[(1 << HT_JOIN_MAX_BITS) + 1] = {0};
+      for (int i = 0; i < count; i++) {
+        parts[i] = ht_partition(join, batch.keys[i]);
+        starts[parts[i] + 1]++;
+      }
+      for (int p = 0; p < join->partitions; p++) {
+        starts[p + 1] += starts[p];
+      }
+      for (int i = 0; i < count; i++) {
+        order[starts[parts[i]]++] = i;
+      }
+    }
+
+    //look up each run of one partition at once
+    char *keys[HT_BATCH_SIZE];
+    ht_item_t *items[HT_BATCH_SIZE];
+    for (int j = 0; j < count; j++) {
+      keys[j] = batch.keys[order[j]];
+    }
+    for (int run = 0, end; run < count; run = end) {
+      for (end = run + 1; end < count && parts[order[end]] == parts[order[run]];
+           end++) {
+      }
+      htk_search_batch(&join->tables[parts[order[run]]], keys + run, end - run,
+                       items + run);
+    }
+
+    for (int j = 0; j < count; j++) {
+      if (items[j] == NULL) {
+        continue;
+      }
+      matches.keys[matches.count] = items[j]->key;
+      matches.build_values[matches.count] = items[j]->value;
+      matches.probe_values[matches.count] = batch.values[order[j]];
+      total++;
+      if (++matches.count == HT_BATCH_SIZE) {
+        emit(emit_context, &matches);
+        matches.count = 0;
+      }
+    }
+  }
+
+  if (matches.count > 0) {
+    emit(emit_context, &matches);
+  }
+  return total;
+}
+
+/*
+ * Zrušení spojení včetně kopií klíčů.
+ */
+void ht_join_dispose(ht_join_t *join) {
+  for (int p = 0; p < join->partitions; p++) {
+    htk_dispose(&join->tables[p]);
+  }
+  free(join->tables);
+  free_chunks(&join->chunks);
+  join->tables = NULL;
+  join->partitions = 0;
+  join->rows = 0;
+}
+
+/*
+ * Inicializace seskupení pro zhruba groups různých klíčů.
+ *
+ * Tabulka obsahuje ukazatel na vlastní pole, seskupení se proto po
+ * inicializaci nesmí přesouvat.
+ */
+void ht_group_init(ht_group_t *group, int groups) {
+  htk_options_t opts = {HTK_HASH_SIPHASH, {0, 0}, groups > 0 ? groups : 1,
+                        HTK_SIZING_POW2, HTK_REORDER_NONE};
+  htk_init(&group->table, &opts);
+  group->chunks = NULL;
+}
+
+/*
+ * Přičtení jedné dávky k součtům.
+ *
+ * Existující součet se zvýší přímo přes ukazatel z htk_get, nový klíč se
+ * zkopíruje. Vrací false, pokud se nepodaří zkopírovat klíč.
+ */
+bool ht_group_batch(ht_group_t *group, const ht_batch_t *batch) {
+  for (int i = 0; i < batch->count; i++) {
+    float *sum = htk_get(&group->table, batch->keys[i]);
+    if (sum != NULL) {
+      *sum += batch->values[i];
+      continue;
+    }
+
+    char *copy = copy_key(&group->chunks, batch->keys[i]);
+    if (copy == NULL) {
+      return false;
+    }
+    htk_insert(&group->table, copy, batch->values[i]);
+  }
+  return true;
+}
+
+/*
+ * Přičtení celého zdroje k součtům.
+ */
+bool ht_group_by_stream(ht_group_t *group, ht_source_t next, void *context) {
+  ht_batch_t batch;
+  while (next(context, &batch) > 0) {
+    if (!ht_group_batch(group, &batch)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+ * Zrušení seskupení včetně kopií klíčů.
+ */
+void ht_group_dispose(ht_group_t *group) {
+  htk_dispose(&group->table);
+  free_chunks(&group->chunks);
+}
@@ -0,0 +1,88 @@
+/*
+ * Hlavičkový súbor pre operátory spojenia a zoskupenia nad tabuľkou.
+ *
+ * Operátory čítajú vstup po dávkach s HT_BATCH_SIZE riadkami, každý riadok
+ * je kľúč a hodnota. Zdrojom môže byť CSV súbor alebo ľubovoľná funkcia
+ * typu ht_source_t. Kľúče, ktoré zostanú v tabuľkách, si operátory kopírujú.
+ */
+
+#ifndef IAL_HASHTABLE_OPS_H
+#define IAL_HASHTABLE_OPS_H
+
+#include "keyed.h"
+#include <stdio.h>
+
+// Počet riadkov v jednej dávke
+#define HT_BATCH_SIZE 1024
+
+// Predvolený rozpočet pamäte jednej tabuľky spojenia, zhruba veľkosť L2
+#define HT_JOIN_CACHE_BYTES (256 * 1024)
+
+// Dávka riadkov zo zdroja
+typedef struct ht_batch {
+  int count;                   // počet platných riadkov
+  char *keys[HT_BATCH_SIZE];   // kľúče, platné do ďalšieho čítania zo zdroja
+  float values[HT_BATCH_SIZE]; // hodnoty
+} ht_batch_t;
+
+// Zdroj dávok, vráti počet načítaných riadkov a 0 na konci vstupu
+typedef int (*ht_source_t)(void *context, ht_batch_t *batch);
+
+// Dávka nájdených dvojíc zo spojenia
+typedef struct ht_matches {
+  int count;                         // počet platných dvojíc
+  char *keys[HT_BATCH_SIZE];         // spoločný kľúč
+  float build_values[HT_BATCH_SIZE]; // hodnota zo zostavenej strany
+  float probe_values[HT_BATCH_SIZE]; // hodnota zo skúšanej strany
+} ht_matches_t;
+
+// Príjemca nájdených dvojíc
+typedef void (*ht_emit_t)(void *context, const ht_matches_t *matches);
+
+// Kúsok pamäte pre kópie kľúčov, definovaný v ops.c
+typedef struct ht_chunk ht_chunk_t;
+
+// Zdroj z CSV súboru
+typedef struct ht_csv {
+  FILE *file;        // otvorený súbor
+  int key_column;    // stĺpec s kľúčom, od nuly
+  int value_column;  // stĺpec s hodnotou, od nuly
+  char *line;        // posledný načítaný riadok
+  size_t line_size;  // alokovaná veľkosť line
+  char *text;        // kľúče aktuálnej dávky
+  size_t text_size;  // alokovaná veľkosť text
+} ht_csv_t;
+
+// Hashovacie spojenie, zostavená strana rozdelená podľa bitov rozptylu
+typedef struct ht_join {
+  size_t cache_bytes;    // rozpočet pamäte jednej tabuľky
+  htk_table_t *tables;   // tabuľka pre každý oddiel
+  int partitions;        // počet oddielov, mocnina dvoch
+  int shift;             // posun rozptylu na číslo oddielu
+  uint64_t seed[2];      // kľúč rozptylovacej funkcie všetkých tabuliek
+  size_t rows;           // počet riadkov zostavenej strany
+  ht_chunk_t *chunks;    // kópie kľúčov
+} ht_join_t;
+
+// Zoskupenie so súčtom hodnôt
+typedef struct ht_group {
+  htk_table_t table;  // súčty podľa kľúča
+  ht_chunk_t *chunks; // kópie kľúčov
+} ht_group_t;
+
+void ht_csv_open(ht_csv_t *csv, FILE *file, int key_column, int value_column);
+int ht_csv_next(void *csv, ht_batch_t *batch);
+void ht_csv_close(ht_csv_t *csv);
+
+void ht_join_init(ht_join_t *join, size_t cache_bytes);
+bool ht_build_from_stream(ht_join_t *join, ht_source_t next, void *context);
+size_t ht_probe_stream(ht_join_t *join, ht_source_t next, void *context,
+                       ht_emit_t emit, void *emit_context);
+void ht_join_dispose(ht_join_t *join);
+
+void ht_group_init(ht_group_t *group, int groups);
+bool ht_group_batch(ht_group_t *group, const ht_batch_t *batch);
+bool ht_group_by_stream(ht_group_t *group, ht_source_t next, void *context);
+void ht_group_dispose(ht_group_t *group);
+
+#endif
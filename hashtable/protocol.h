@@ -0,0 +1,42 @@
+/*
+ * Hlavičkový súbor pre binárny protokol servera s tabuľkou.
+ *
+ * Klient posiela požiadavky za sebou bez čakania na odpovede (pipelining),
+ * server odpovedá v rovnakom poradí. Čísla sú v poradí bajtov hostiteľa,
+ * protokol je určený len pre Unix domain socket na jednom stroji.
+ */
+
+#ifndef IAL_HASHTABLE_PROTOCOL_H
+#define IAL_HASHTABLE_PROTOCOL_H
+
+#include <stdint.h>
+
+// Predvolená cesta k socketu servera
+#define KV_SOCKET_PATH "/tmp/ial_kv.sock"
+
+// Operácie
+#define KV_GET 1
+#define KV_SET 2
+#define KV_DEL 3
+
+// Výsledky
+#define KV_OK 0
+#define KV_NOT_FOUND 1
+#define KV_ERROR 2
+
+// Hlavička požiadavky, za ňou nasleduje key_length bajtov kľúča bez nuly
+typedef struct kv_request {
+  uint8_t op;          // KV_GET, KV_SET alebo KV_DEL
+  uint8_t reserved;    // nula
+  uint16_t key_length; // dĺžka kľúča
+  float value;         // nová hodnota pre KV_SET
+} kv_request_t;
+
+// Odpoveď na jednu požiadavku
+typedef struct kv_response {
+  uint8_t status;      // KV_OK, KV_NOT_FOUND alebo KV_ERROR
+  uint8_t reserved[3]; // nuly
+  float value;         // hodnota pre KV_GET
+} kv_response_t;
+
+#endif
@@ -0,0 +1,351 @@
+/*
+ * Server s tabulkou s rozptýlenými položkami
+ *
+ * Drží jednu tabulku htk_table_t a obsluhuje požadavky GET/SET/DEL podle
+ * protocol.h přes Unix domain socket. Všechna spojení obsluhuje jedno
+ * vlákno ve smyčce nad epoll, takže tabulka nepotřebuje zámky. Z každého
+ * spojení se zpracují všechny celé požadavky, které jsou v bufferu, a
+ * odpovědi se odešlou jedním zápisem.
+ *
+ * Spuštění: ./server [cesta k socketu]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "keyed.h"
+#include "protocol.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Velikost tabulky serveru
+#define SERVER_HT_SIZE (1 << 16)
+
+// Počet událostí z jednoho volání epoll_wait
+#define SERVER_EVENTS 64
+
+// Nad tolik neodeslaných bajtů spojení přestane číst další požadavky
+#define SERVER_OUT_LIMIT (1 << 20)
+
+// Spojení s klientem
+typedef struct connection {
+  int fd;            // socket klienta
+  char *in;          // přijaté a nezpracované bajty
+  size_t in_length;  // počet bajtů v in
+  size_t in_size;    // alokovaná velikost in
+  char *out;         // odpovědi k odeslání
+  size_t out_length; // počet bajtů v out
+  size_t out_sent;   // počet už odeslaných bajtů z out
+  size_t out_size;   // alokovaná velikost out
+  bool reading;      // epoll hlásí EPOLLIN
+} connection_t;
+
+static volatile sig_atomic_t running = 1;
+
+static void stop(int signal) {
+  (void)signal;
+  running = 0;
+}
+
+/*
+ * Zajistí, že buffer pojme aspoň needed bajtů.
+ */
+static bool reserve(char **buffer, size_t *size, size_t needed) {
+  if (needed <= *size) {
+    return true;
+  }
+  size_t new_size = *size ? *size : 4096;
+  while (new_size < needed) {
+    new_size *= 2;
+  }
+  char *new_buffer = realloc(*buffer, new_size);
+  if (new_buffer == NULL) {
+    return false;
+  }
+  *buffer = new_buffer;
+  *size = new_size;
+  return true;
+}
+
+/*
+ * Provede jeden požadavek nad tabulkou. Klíče vlastní server, tabulka
+ * ukládá jen ukazatel, takže nový klíč se zkopíruje a smazaný uvolní.
+ */
+static kv_response_t handle(htk_table_t *table, const kv_request_t *request,
+                            char *key) {
+  kv_response_t response = {KV_OK, {0, 0, 0}, 0};
+
+  switch (request->op) {
+  case KV_GET: {
+    float *value = htk_get(table, key);
+    if (value == NULL) {
+      response.status = KV_NOT_FOUND;
+    } else {
+      response.value = *value;
+    }
+    break;
+  }
+
+  case KV_SET: {
+    ht_item_t *item = htk_search(table, key);
+    if (item != NULL) {
+      item->value = request->value;
+      break;
+    }
+    char *copy = malloc(request->key_length + 1);
+    if (copy == NULL) {
+      response.status = KV_ERROR;
+      break;
+    }
+    memcpy(copy, key, request->key_length + 1);
+    htk_insert(table, copy, request->value);
+    if (htk_search(table, copy) == NULL) {
+      free(copy);
+      response.status = KV_ERROR;
+    }
+    break;
+  }
+
+  case KV_DEL: {
+    ht_item_t *item = htk_search(table, key);
+    if (item == NULL) {
+      response.status = KV_NOT_FOUND;
+      break;
+    }
+    char *owned = item->key;
+    htk_delete(table, key);
+    free(owned);
+    break;
+  }
+
+  default:
+    response.status = KV_ERROR;
+  }
+
+  return response;
+}
+
+/*
+ * Zpracuje všechny celé požadavky v bufferu spojení a připraví odpovědi.
+ * Vrací false při chybě protokolu nebo nedostatku paměti.
+ */
+static bool process(htk_table_t *table, connection_t *connection) {
+  static char key[UINT16_MAX + 1];
+  size_t position = 0;
+
+  while (connection->in_length - position >= sizeof(kv_request_t)) {
+    kv_request_t request;
+    memcpy(&request, connection->in + position, sizeof(request));
+    size_t length = sizeof(request) + request.key_length;
+    if (connection->in_length - position < length) {
+      break;
+    }
+
+    //keys are C strings in the table, so no NUL inside
+    memcpy(key, connection->in + position + sizeof(request),
+           request.key_length);
+    key[request.key_length] = '\0';
+    kv_response_t response = {KV_ERROR, {0, 0, 0}, 0};
+    if (memchr(key, '\0', request.key_length) == NULL) {
+      response = handle(table, &request, key);
+    }
+
+    if (!reserve(&connection->out, &connection->out_size,
+                 connection->out_length + sizeof(response))) {
+      return false;
+    }
+    memcpy(connection->out + connection->out_length, &response,
+           sizeof(response));
+    connection->out_length += sizeof(response);
+    position += length;
+  }
+
+  //keep the incomplete request for the next read
+  memmove(connection->in, connection->in + position,
+          connection->in_length - position);
+  connection->in_length -= position;
+  return true;
+}
+
+/*
+ * Odešle co nejvíc odpovědí. Vrací false, pokud se klient odpojil.
+ */
+static bool flush(connection_t *connection) {
+  while (connection->out_sent < connection->out_length) {
+    ssize_t sent = send(connection->fd, connection->out + connection->out_sent,
+                        connection->out_length - connection->out_sent, 0);
+    if (sent == -1) {
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    connection->out_sent += sent;
+  }
+  connection->out_length = 0;
+  connection->out_sent = 0;
+  return true;
+}
+
+/*
+ * Nastaví, na které události spojení čeká: na čtení, dokud nemá příliš
+ * neodeslaných odpovědí, a na zápis, dokud nějaké má.
+ */
+static void watch(int epoll, connection_t *connection) {
+  size_t pending = connection->out_length - connection->out_sent;
+  struct epoll_event event = {0, {.ptr = connection}};
+  connection->reading = pending < SERVER_OUT_LIMIT;
+  event.events = (connection->reading ? EPOLLIN : 0) | (pending ? EPOLLOUT : 0);
+  epoll_ctl(epoll, EPOLL_CTL_MOD, connection->fd, &event);
+}
+
+static void close_connection(connection_t *connection) {
+  close(connection->fd);
+  free(connection->in);
+  free(connection->out);
+  free(connection);
+}
+
+/*
+ * Obsluha události na spojení. Vrací false, pokud se má spojení zavřít.
+ */
+static bool serve(htk_table_t *table, int epoll, connection_t *connection,
+                  uint32_t events) {
+  if (events & (EPOLLERR | EPOLLHUP)) {
+    return false;
+  }
+
+  //read everything the client has sent so far
+  while ((events & EPOLLIN) && connection->reading) {
+    if (!reserve(&connection->in, &connection->in_size,
+                 connection->in_length + 65536)) {
+      return false;
+    }
+    ssize_t received = recv(connection->fd, connection->in + connection->in_length,
+                            connection->in_size - connection->in_length, 0);
+    if (received == 0) {
+      return false;
+    }
+    if (received == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        return false;
+      }
+      break;
+    }
+    connection->in_length += received;
+    if (!process(table, connection)) {
+      return false;
+    }
+    if (connection->out_length - connection->out_sent >= SERVER_OUT_LIMIT) {
+      break;
+    }
+  }
+
+  if (!flush(connection)) {
+    return false;
+  }
+  watch(epoll, connection);
+  return true;
+}
+
+/*
+ * Uvolní klíče, které patří serveru, a zruší tabulku.
+ */
+static void dispose_table(htk_table_t *table) {
+  for (int i = 0; i < table->size; i++) {
+    for (ht_item_t *item = htk_list(table, i); item != NULL;
+         item = item->next) {
+      free(item->key);
+    }
+  }
+  htk_dispose(table);
+}
+
+int main(int argc, char *argv[]) {
+  const char *path = argc > 1 ? argv[1] : KV_SOCKET_PATH;
+
+  //stop cleanly on Ctrl+C and kill
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = stop;
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  //listen on the socket
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(address.sun_path)) {
+    fprintf(stderr, "Socket path is too long: %s\n", path);
+    return 1;
+  }
+  strcpy(address.sun_path, path);
+  unlink(path);
+
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener == -1 ||
+      bind(listener, (struct sockaddr *)&address, sizeof(address)) == -1 ||
+      listen(listener, SOMAXCONN) == -1) {
+    perror("Cannot listen");
+    return 1;
+  }
+  fcntl(listener, F_SETFL, fcntl(listener, F_GETFL) | O_NONBLOCK);
+
+  int epoll = epoll_create1(0);
+  struct epoll_event event = {EPOLLIN, {.ptr = NULL}};
+  epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &event);
+
+  //keys come from clients, so use a keyed hash
+  htk_table_t *table = malloc(sizeof(htk_table_t));
+  htk_options_t opts = {HTK_HASH_SIPHASH, {0, 0}, SERVER_HT_SIZE,
+                        HTK_SIZING_POW2, HTK_REORDER_NONE};
+  htk_init(table, &opts);
+  printf("Listening on %s\n", path);
+  fflush(stdout);
+
+  struct epoll_event events[SERVER_EVENTS];
+  while (running) {
+    int count = epoll_wait(epoll, events, SERVER_EVENTS, -1);
+    for (int i = 0; i < count; i++) {
+
+      //new clients
+      if (events[i].data.ptr == NULL) {
+        int fd;
+        while ((fd = accept(listener, NULL, NULL)) != -1) {
+          connection_t *connection = calloc(1, sizeof(connection_t));
+          if (connection == NULL) {
+            close(fd);
+            continue;
+          }
+          fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+          connection->fd = fd;
+          connection->reading = true;
+          struct epoll_event client = {EPOLLIN, {.ptr = connection}};
+          epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &client);
+        }
+        continue;
+      }
+
+      connection_t *connection = events[i].data.ptr;
+      if (!serve(table, epoll, connection, events[i].events)) {
+        epoll_ctl(epoll, EPOLL_CTL_DEL, connection->fd, NULL);
+        close_connection(connection);
+      }
+    }
+  }
+
+  close(listener);
+  close(epoll);
+  unlink(path);
+  dispose_table(table);
+  free(table);
+  return 0;
+}
@@ -0,0 +1,445 @@
+/*
+ * Tabulka s rozptýlenými položkami ve sdílené paměti
+ *
+ * Rozložení oblasti: hlavička, pole seznamů, pole prvků (htc_item_t) a pole
+ * klíčů, každé zarovnané na 64 bajtů. Velikosti se určí při vytvoření a
+ * nemění se, tabulka neroste. Místo po klíči smazaného prvku se použije
+ * znovu jen pro stejně dlouhý nebo kratší klíč, jinak zůstane nevyužité.
+ *
+ * Zapisovatel drží zámek sdílený mezi procesy a před změnou i po ní zvýší
+ * pořadové číslo (seqlock). Čtenář si přečte pořadové číslo, projde seznam
+ * synonym a výsledek použije, jen pokud se pořadové číslo mezitím nezměnilo
+ * a nebylo liché. Všechny indexy a posuny čtenář kontroluje proti velikosti
+ * oblasti, protože během zápisu může vidět nekonzistentní stav. Po
+ * HTS_READ_TRIES neúspěšných pokusech si čtenář vezme zámek zapisovatele,
+ * takže nečeká donekonečna na zapisovatele, který uprostřed zápisu skončil.
+ *
+ * Hlavička zabírá celou stránku. Čtenář ji mapuje pro zápis kvůli zámku,
+ * zbytek oblasti jen pro čtení.
+ *
+ * Rozptylovací funkce je vždy SipHash s klíčem z hlavičky a hlavička ji
+ * proto nezapisuje. Výběr podle vzorku (HTK_HASH_AUTO) tu není: klíče
+ * zapisují jiné procesy, nemusí být důvěryhodné, a funkce se po vytvoření
+ * oblasti nesmí změnit, protože ji čtenáři počítají sami.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "shared.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// "ialhash1" v ASCII
+#define HTS_MAGIC UINT64_C(0x3168736168616c69)
+
+// Počet čtení bez zámku, po kterém čtenář počká na zámek
+#define HTS_READ_TRIES 1024
+
+struct hts_header {
+  uint64_t magic;         // HTS_MAGIC, zapsané jako poslední při vytvoření
+  uint64_t seed[2];       // klíč rozptylovací funkce
+  uint32_t size;          // počet seznamů, mocnina dvou
+  uint32_t capacity;      // počet prvků
+  uint32_t keys_capacity; // počet bajtů pro klíče
+  uint32_t used;          // počet použitých prvků
+  uint32_t count;         // počet prvků v tabulce
+  uint32_t free;          // seznam uvolněných prvků
+  uint32_t keys_used;     // použité bajty pro klíče
+  uint32_t seq;           // liché během zápisu
+  pthread_mutex_t lock;   // zámek zapisovatele
+};
+
+static size_t hts_align(size_t length) {
+  return (length + 63) & ~(size_t)63;
+}
+
+/*
+ * Délka hlavičky zaokrouhlená na celou stránku.
+ */
+static size_t hts_header_length(void) {
+  size_t length = hts_align(sizeof(hts_header_t));
+  long page = sysconf(_SC_PAGESIZE);
+  return page > 0 && (size_t)page > length ? (size_t)page : length;
+}
+
+/*
+ * Délka oblasti pro tabulku daných rozměrů.
+ */
+static size_t hts_length(uint32_t size, uint32_t capacity,
+                         uint32_t keys_capacity) {
+  return hts_header_length() + hts_align(size * sizeof(uint32_t)) +
+         hts_align((size_t)capacity * sizeof(htc_item_t)) +
+         hts_align(keys_capacity);
+}
+
+/*
+ * Nastaví ukazatele na pole podle adresy, kam je oblast namapovaná.
+ */
+static void hts_map_arrays(hts_table_t *table) {
+  char *base = (char *)table->header;
+  size_t offset = hts_header_length();
+
+  table->buckets = (uint32_t *)(base + offset);
+  offset += hts_align(table->header->size * sizeof(uint32_t));
+  table->items = (htc_item_t *)(base + offset);
+  offset += hts_align((size_t)table->header->capacity * sizeof(htc_item_t));
+  table->keys = base + offset;
+}
+
+/*
+ * Vytvoření tabulky ve sdílené paměti s názvem name (viz shm_open).
+ *
+ * Tabulka bude mít size seznamů (zaokrouhleno na mocninu dvou), místo pro
+ * capacity prvků a keys_capacity bajtů klíčů včetně ukončovacích nul.
+ * Vrací false, pokud oblast s tímto názvem už existuje nebo ji nelze
+ * vytvořit. Vytvořená tabulka je otevřená pro zápis.
+ */
+bool hts_create(hts_table_t *table, const char *name, uint32_t size,
+                uint32_t capacity, uint32_t keys_capacity) {
+
+  //round the size up to a power of two
+  uint32_t pow2 = 1;
+  while (pow2 < size && pow2 < (UINT32_C(1) << 31)) {
+    pow2 *= 2;
+  }
+  if (capacity == HTC_NIL) {
+    capacity--;
+  }
+  size_t length = hts_length(pow2, capacity, keys_capacity);
+
+  //create and map the region
+  int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd == -1) {
+    return false;
+  }
+  if (ftruncate(fd, length) == -1) {
+    close(fd);
+    shm_unlink(name);
+    return false;
+  }
+  void *base =
+      mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    shm_unlink(name);
+    return false;
+  }
+
+  //fill in the header
+  hts_header_t *header = base;
+  htk_random_seed(header->seed);
+  header->size = pow2;
+  header->capacity = capacity;
+  header->keys_capacity = keys_capacity;
+  header->used = 0;
+  header->count = 0;
+  header->free = HTC_NIL;
+  header->keys_used = 0;
+  header->seq = 0;
+
+  //robust, so a writer that dies does not block the others forever
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+  pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+  pthread_mutex_init(&header->lock, &attr);
+  pthread_mutexattr_destroy(&attr);
+
+  table->header = header;
+  table->length = length;
+  table->writable = true;
+  hts_map_arrays(table);
+  memset(table->buckets, 0xff, pow2 * sizeof(uint32_t));
+
+  //the region is valid once the magic is visible
+  __atomic_store_n(&header->magic, HTS_MAGIC, __ATOMIC_RELEASE);
+  return true;
+}
+
+/*
+ * Otevření existující tabulky.
+ *
+ * Čtenáři stačí writable == false, oblast se pak kromě hlavičky namapuje
+ * jen pro čtení. I čtenář ale potřebuje právo zápisu do oblasti, aby mohl
+ * vzít zámek. Vrací false, pokud oblast neexistuje, neobsahuje tabulku nebo
+ * ji nelze otevřít pro zápis.
+ */
+bool hts_open(hts_table_t *table, const char *name, bool writable) {
+  int fd = shm_open(name, O_RDWR, 0);
+  if (fd == -1) {
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) == -1 || (size_t)st.st_size < hts_header_length()) {
+    close(fd);
+    return false;
+  }
+  int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+  void *base = mmap(NULL, st.st_size, prot, MAP_SHARED, fd, 0);
+
+  //the lock lives in the header, so readers map it writable too
+  if (base != MAP_FAILED && !writable &&
+      mmap(base, hts_header_length(), PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+    munmap(base, st.st_size);
+    base = MAP_FAILED;
+  }
+  close(fd);
+  if (base == MAP_FAILED) {
+    return false;
+  }
+
+  //check that the region really holds a table of this length
+  hts_header_t *header = base;
+  if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != HTS_MAGIC ||
+      hts_length(header->size, header->capacity, header->keys_capacity) !=
+          (size_t)st.st_size) {
+    munmap(base, st.st_size);
+    return false;
+  }
+
+  table->header = header;
+  table->length = st.st_size;
+  table->writable = writable;
+  hts_map_arrays(table);
+  return true;
+}
+
+/*
+ * Odmapování tabulky. Data ve sdílené paměti zůstávají.
+ */
+void hts_close(hts_table_t *table) {
+  munmap(table->header, table->length);
+  table->header = NULL;
+  table->length = 0;
+}
+
+/*
+ * Odstranění sdílené oblasti. Procesy, které ji mají namapovanou, ji mohou
+ * dál používat.
+ */
+void hts_unlink(const char *name) {
+  shm_unlink(name);
+}
+
+/*
+ * Zamknutí zámku zapisovatele.
+ *
+ * Pokud zapisovatel se zámkem skončil, zámek se obnoví a pořadové číslo se
+ * nastaví na sudé, aby čtenáři bez zámku nečekali na jeho konec zápisu.
+ */
+static void hts_lock(hts_header_t *header) {
+  if (pthread_mutex_lock(&header->lock) == EOWNERDEAD) {
+    //the previous writer died, its update may be half done
+    pthread_mutex_consistent(&header->lock);
+    __atomic_store_n(&header->seq, (header->seq | 1) + 1, __ATOMIC_RELEASE);
+  }
+}
+
+/*
+ * Začátek zápisu: zamkne zámek a nastaví liché pořadové číslo.
+ */
+static void hts_write_begin(hts_header_t *header) {
+  hts_lock(header);
+  __atomic_store_n(&header->seq, header->seq | 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/*
+ * Konec zápisu: sudé pořadové číslo a odemčení.
+ */
+static void hts_write_end(hts_header_t *header) {
+  __atomic_store_n(&header->seq, header->seq + 1, __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&header->lock);
+}
+
+static uint32_t hts_bucket(hts_table_t *table, const char *key, size_t len) {
+  return htk_siphash(table->header->seed, key, len) & (table->header->size - 1);
+}
+
+/*
+ * Vložení nového prvku do tabulky, jen pro zapisovatele.
+ *
+ * Pokud prvek s daným klíčem už v tabulce existuje, nahradí se jeho hodnota.
+ * Vrací false, pokud je tabulka otevřená jen pro čtení nebo v ní už není
+ * místo pro prvek nebo klíč.
+ */
+bool hts_insert(hts_table_t *table, const char *key, float value) {
+  if (!table->writable) {
+    return false;
+  }
+
+  hts_header_t *header = table->header;
+  size_t length = strlen(key) + 1;
+  uint32_t bucket = hts_bucket(table, key, length - 1);
+  bool ok = true;
+  hts_write_begin(header);
+
+  //if the item is found, change its value
+  uint32_t index = table->buckets[bucket];
+  while (index != HTC_NIL &&
+         strcmp(table->keys + table->items[index].key, key) != 0) {
+    index = table->items[index].next;
+  }
+  if (index != HTC_NIL) {
+    __atomic_store(&table->items[index].value, &value, __ATOMIC_RELAXED);
+    hts_write_end(header);
+    return true;
+  }
+
+  //take an item from the free list or from the unused rest of the array
+  if (header->free != HTC_NIL) {
+    index = header->free;
+  } else if (header->used < header->capacity) {
+    index = header->used;
+  } else {
+    ok = false;
+  }
+
+  //reuse the key space of a deleted item if the new key fits in it
+  uint32_t offset = header->keys_used;
+  if (ok && index == header->free &&
+      strlen(table->keys + table->items[index].key) + 1 >= length) {
+    offset = table->items[index].key;
+  } else if (header->keys_used + length > header->keys_capacity) {
+    ok = false;
+  }
+
+  //copy the key and add the new item to the beginning of the list
+  if (ok) {
+    htc_item_t *item = &table->items[index];
+    if (index == header->free) {
+      header->free = item->next;
+    } else {
+      header->used++;
+    }
+    if (offset == header->keys_used) {
+      header->keys_used += length;
+    }
+    memcpy(table->keys + offset, key, length);
+    __atomic_store_n(&item->key, offset, __ATOMIC_RELAXED);
+    __atomic_store(&item->value, &value, __ATOMIC_RELAXED);
+    __atomic_store_n(&item->next, table->buckets[bucket], __ATOMIC_RELAXED);
+    __atomic_store_n(&table->buckets[bucket], index, __ATOMIC_RELAXED);
+    __atomic_store_n(&header->count, header->count + 1, __ATOMIC_RELAXED);
+  }
+
+  hts_write_end(header);
+  return ok;
+}
+
+/*
+ * Hledání klíče délky length (včetně nuly) v seznamu bucket.
+ *
+ * Žádnému indexu ani posunu nevěří, takže projde i seznam rozbitý
+ * souběžným zápisem nebo zapisovatelem, který skončil uprostřed změny.
+ */
+static bool hts_find(hts_table_t *table, uint32_t bucket, const char *key,
+                     size_t length, float *value) {
+  uint32_t capacity = table->header->capacity;
+  uint32_t keys_capacity = table->header->keys_capacity;
+
+  //walk the list, never trusting an index that points outside the region
+  uint32_t index = __atomic_load_n(&table->buckets[bucket], __ATOMIC_RELAXED);
+  for (uint32_t steps = 0; index < capacity && steps < capacity; steps++) {
+    htc_item_t *item = &table->items[index];
+    uint32_t offset = __atomic_load_n(&item->key, __ATOMIC_RELAXED);
+
+    //torn reads of the key are thrown away by the caller's sequence check
+    if (offset < keys_capacity && keys_capacity - offset >= length &&
+        memcmp(table->keys + offset, key, length) == 0) {
+      __atomic_load(&item->value, value, __ATOMIC_RELAXED);
+      return true;
+    }
+    index = __atomic_load_n(&item->next, __ATOMIC_RELAXED);
+  }
+  return false;
+}
+
+/*
+ * Získání hodnoty z tabulky, přednostně bez zámku.
+ *
+ * Pokud prvek existuje, zapíše jeho hodnotu do value a vrací true. Čtení se
+ * opakuje, dokud neproběhne bez souběžného zápisu, nejvýš HTS_READ_TRIES
+ * krát. Potom čtenář počká na zámek, a pokud zapisovatel se zámkem skončil,
+ * zámek obnoví.
+ */
+bool hts_get(hts_table_t *table, const char *key, float *value) {
+  hts_header_t *header = table->header;
+  size_t length = strlen(key) + 1;
+  uint32_t bucket = hts_bucket(table, key, length - 1);
+  float found_value = 0;
+
+  for (int tries = 0; tries < HTS_READ_TRIES; tries++) {
+    uint32_t seq = __atomic_load_n(&header->seq, __ATOMIC_ACQUIRE);
+    if (seq & 1) {
+      continue;
+    }
+
+    bool found = hts_find(table, bucket, key, length, &found_value);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&header->seq, __ATOMIC_RELAXED) == seq) {
+      if (found) {
+        *value = found_value;
+      }
+      return found;
+    }
+  }
+
+  //the writer is slow or died in the middle of a change
+  hts_lock(header);
+  bool found = hts_find(table, bucket, key, length, &found_value);
+  pthread_mutex_unlock(&header->lock);
+  if (found) {
+    *value = found_value;
+  }
+  return found;
+}
+
+/*
+ * Smazání prvku z tabulky, jen pro zapisovatele.
+ *
+ * Prvek se vrátí do seznamu volných prvků i s místem pro svůj klíč. Pokud
+ * prvek neexistuje, funkce nedělá nic.
+ */
+void hts_delete(hts_table_t *table, const char *key) {
+  if (!table->writable) {
+    return;
+  }
+
+  hts_header_t *header = table->header;
+  uint32_t bucket = hts_bucket(table, key, strlen(key));
+  hts_write_begin(header);
+
+  //find the link that points to the item
+  uint32_t *link = &table->buckets[bucket];
+  while (*link != HTC_NIL) {
+    htc_item_t *item = &table->items[*link];
+    if (strcmp(table->keys + item->key, key) == 0) {
+      uint32_t index = *link;
+      __atomic_store_n(link, item->next, __ATOMIC_RELAXED);
+
+      //put the item on the free list
+      __atomic_store_n(&item->next, header->free, __ATOMIC_RELAXED);
+      header->free = index;
+      __atomic_store_n(&header->count, header->count - 1, __ATOMIC_RELAXED);
+      break;
+    }
+    link = &item->next;
+  }
+
+  hts_write_end(header);
+}
+
+/*
+ * Počet prvků v tabulce.
+ */
+uint32_t hts_count(hts_table_t *table) {
+  return __atomic_load_n(&table->header->count, __ATOMIC_RELAXED);
+}
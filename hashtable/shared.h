@@ -0,0 +1,39 @@
+/*
+ * Hlavičkový súbor pre tabuľku v zdieľanej pamäti.
+ *
+ * Zoznamy, prvky aj kľúče sú v jednej oblasti z shm_open/mmap a odkazujú
+ * na seba indexmi, takže oblasť môže byť v každom procese namapovaná na inej
+ * adrese. Jeden zapisovateľ mení tabuľku pod zámkom zdieľaným medzi
+ * procesmi, čitatelia čítajú bez zámku pomocou seqlocku. Zámok si čitateľ
+ * vezme, len ak sa čítanie mnohokrát za sebou stretne so zápisom.
+ */
+
+#ifndef IAL_HASHTABLE_SHARED_H
+#define IAL_HASHTABLE_SHARED_H
+
+#include "compact.h"
+
+// Hlavička na začiatku zdieľanej oblasti, definovaná v shared.c
+typedef struct hts_header hts_header_t;
+
+// Namapovaná tabuľka, platná len v procese, ktorý ju otvoril
+typedef struct hts_table {
+  hts_header_t *header; // začiatok oblasti
+  size_t length;        // dĺžka oblasti v bajtoch
+  uint32_t *buckets;    // index prvého synonyma každého zoznamu
+  htc_item_t *items;    // všetky prvky
+  char *keys;           // kľúče ukončené nulou, za sebou
+  bool writable;        // oblasť je namapovaná na zápis
+} hts_table_t;
+
+bool hts_create(hts_table_t *table, const char *name, uint32_t size,
+                uint32_t capacity, uint32_t keys_capacity);
+bool hts_open(hts_table_t *table, const char *name, bool writable);
+void hts_close(hts_table_t *table);
+void hts_unlink(const char *name);
+bool hts_insert(hts_table_t *table, const char *key, float value);
+bool hts_get(hts_table_t *table, const char *key, float *value);
+void hts_delete(hts_table_t *table, const char *key);
+uint32_t hts_count(hts_table_t *table);
+
+#endif
@@ -0,0 +1,296 @@
+/*
+ * Count-min sketch s haldou nejčastějších klíčů
+ *
+ * Sketch má HT_SKETCH_DEPTH řádků po width počítadlech. Klíč má v každém
+ * řádku jedno počítadlo a odhad jeho počtu je minimum z nich. Indexy se
+ * odvodí z jednoho SipHash klíče dvojitým rozptylováním (Kirsch,
+ * Mitzenmacher): h1 + i * h2 pro řádek i. Se šířkou w je odhad s
+ * pravděpodobností aspoň 1 - e^-HT_SKETCH_DEPTH nejvýš o e / w * total
+ * větší než skutečný počet.
+ *
+ * Přičítá se konzervativně (Estan, Varghese): počítadla se zvýší jen na
+ * nový odhad, ne všechna o celý přírůstek. Odhady zůstávají horními mezemi,
+ * ale jsou přesnější, hlavně pro málo časté klíče.
+ *
+ * Halda je min-halda podle odhadu, kořen je kandidát na vyřazení. Klíč se
+ * v ní hledá lineárně, k má proto být malé, desítky až stovky.
+ */
+
+#include "sketch.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Inicializace sketche v paměti bytes včetně haldy pro k klíčů.
+ *
+ * Šířka řádku je největší mocnina dvou, která se do zbytku paměti vejde.
+ * Sketche se stejným seed lze spojovat, seed {0, 0} nebo NULL znamená
+ * náhodný klíč. Vrací false, pokud se do bytes nevejde aspoň 64 počítadel
+ * na řádek nebo se nepodaří alokovat paměť.
+ */
+bool ht_sketch_init(ht_sketch_t *sketch, size_t bytes, int k,
+                    const uint64_t seed[2]) {
+  k = k < 0 ? 0 : k;
+  size_t heap_bytes = (size_t)k * sizeof(ht_sketch_entry_t);
+  size_t row_bytes =
+      bytes > heap_bytes ? (bytes - heap_bytes) / HT_SKETCH_DEPTH : 0;
+
+  //the widest power of two that fits
+  uint32_t width = 1;
+  while (width < (UINT32_C(1) << 31) &&
+         (size_t)width * 2 * sizeof(uint32_t) <= row_bytes) {
+    width *= 2;
+  }
+  if ((size_t)width * sizeof(uint32_t) > row_bytes || width < 64) {
+    return false;
+  }
+
+  sketch->counters =
+      calloc((size_t)width * HT_SKETCH_DEPTH, sizeof(uint32_t));
+  sketch->heap = malloc(heap_bytes > 0 ? heap_bytes : 1);
+  if (sketch->counters == NULL || sketch->heap == NULL) {
+    free(sketch->counters);
+    free(sketch->heap);
+    return false;
+  }
+  sketch->width = width;
+  sketch->heap_size = 0;
+  sketch->k = k;
+  sketch->total = 0;
+  if (seed != NULL && (seed[0] != 0 || seed[1] != 0)) {
+    sketch->seed[0] = seed[0];
+    sketch->seed[1] = seed[1];
+  } else {
+    htk_random_seed(sketch->seed);
+  }
+  return true;
+}
+
+/*
+ * Prázdný sketch stejné velikosti a se stejným klíčem jako other, třeba
+ * pro další vlákno.
+ */
+bool ht_sketch_init_like(ht_sketch_t *sketch, const ht_sketch_t *other) {
+  size_t bytes = (size_t)other->width * HT_SKETCH_DEPTH * sizeof(uint32_t) +
+                 (size_t)other->k * sizeof(ht_sketch_entry_t);
+  return ht_sketch_init(sketch, bytes, other->k, other->seed);
+}
+
+/*
+ * Index počítadla klíče s rozptylovací hodnotou hash v řádku row.
+ */
+static size_t ht_sketch_cell(const ht_sketch_t *sketch, uint64_t hash,
+                             int row) {
+  uint32_t h1 = (uint32_t)hash, h2 = (uint32_t)(hash >> 32) | 1;
+  return (size_t)row * sketch->width +
+         ((h1 + row * h2) & (sketch->width - 1));
+}
+
+static uint32_t ht_sketch_min(const ht_sketch_t *sketch, uint64_t hash) {
+  uint32_t estimate = UINT32_MAX;
+  for (int row = 0; row < HT_SKETCH_DEPTH; row++) {
+    uint32_t counter = sketch->counters[ht_sketch_cell(sketch, hash, row)];
+    estimate = counter < estimate ? counter : estimate;
+  }
+  return estimate;
+}
+
+static void ht_sketch_swap(ht_sketch_entry_t *a, ht_sketch_entry_t *b) {
+  ht_sketch_entry_t tmp = *a;
+  *a = *b;
+  *b = tmp;
+}
+
+/*
+ * Posun prvku haldy dolů po zvětšení jeho odhadu.
+ */
+static void ht_sketch_sift_down(ht_sketch_t *sketch, int i) {
+  for (;;) {
+    int smallest = i;
+    int left = 2 * i + 1, right = 2 * i + 2;
+    if (left < sketch->heap_size &&
+        sketch->heap[left].count < sketch->heap[smallest].count) {
+      smallest = left;
+    }
+    if (right < sketch->heap_size &&
+        sketch->heap[right].count < sketch->heap[smallest].count) {
+      smallest = right;
+    }
+    if (smallest == i) {
+      return;
+    }
+    ht_sketch_swap(&sketch->heap[i], &sketch->heap[smallest]);
+    i = smallest;
+  }
+}
+
+static void ht_sketch_sift_up(ht_sketch_t *sketch, int i) {
+  while (i > 0 && sketch->heap[(i - 1) / 2].count > sketch->heap[i].count) {
+    ht_sketch_swap(&sketch->heap[i], &sketch->heap[(i - 1) / 2]);
+    i = (i - 1) / 2;
+  }
+}
+
+/*
+ * Zápis nového odhadu klíče do haldy, pokud patří mezi k největších.
+ */
+static void ht_sketch_track(ht_sketch_t *sketch, const char *key, size_t len,
+                            uint64_t hash, uint32_t estimate) {
+  if (sketch->k == 0 || len >= HT_SKETCH_KEY_SIZE) {
+    return;
+  }
+
+  //a key already in the heap only grows
+  for (int i = 0; i < sketch->heap_size; i++) {
+    ht_sketch_entry_t *entry = &sketch->heap[i];
+    if (entry->hash == hash && strcmp(entry->key, key) == 0) {
+      entry->count = estimate;
+      ht_sketch_sift_down(sketch, i);
+      return;
+    }
+  }
+
+  //a new key fills the heap or replaces the smallest one
+  int i;
+  if (sketch->heap_size < sketch->k) {
+    i = sketch->heap_size++;
+  } else if (estimate > sketch->heap[0].count) {
+    i = 0;
+  } else {
+    return;
+  }
+  ht_sketch_entry_t *entry = &sketch->heap[i];
+  memcpy(entry->key, key, len + 1);
+  entry->hash = hash;
+  entry->count = estimate;
+  if (i == 0) {
+    ht_sketch_sift_down(sketch, 0);
+  } else {
+    ht_sketch_sift_up(sketch, i);
+  }
+}
+
+/*
+ * Přičtení count výskytů klíče, vrací nový odhad.
+ *
+ * Počítadla se při přetečení zastaví na UINT32_MAX.
+ */
+uint32_t ht_sketch_increment(ht_sketch_t *sketch, const char *key,
+                             uint32_t count) {
+  size_t len = strlen(key);
+  uint64_t hash = htk_siphash(sketch->seed, key, len);
+  sketch->total += count;
+
+  //conservative update, no counter goes above the new estimate
+  uint32_t estimate = ht_sketch_min(sketch, hash);
+  estimate = estimate > UINT32_MAX - count ? UINT32_MAX : estimate + count;
+  for (int row = 0; row < HT_SKETCH_DEPTH; row++) {
+    uint32_t *counter = &sketch->counters[ht_sketch_cell(sketch, hash, row)];
+    if (*counter < estimate) {
+      *counter = estimate;
+    }
+  }
+
+  ht_sketch_track(sketch, key, len, hash, estimate);
+  return estimate;
+}
+
+/*
+ * Odhad počtu výskytů klíče, nikdy menší než skutečný počet.
+ */
+uint32_t ht_sketch_estimate(const ht_sketch_t *sketch, const char *key) {
+  return ht_sketch_min(sketch, htk_siphash(sketch->seed, key, strlen(key)));
+}
+
+static int ht_sketch_compare(const void *a, const void *b) {
+  uint32_t x = ((const ht_sketch_entry_t *)a)->count;
+  uint32_t y = ((const ht_sketch_entry_t *)b)->count;
+  return (x < y) - (x > y);
+}
+
+/*
+ * Nejvýš max nejčastějších klíčů do out, od největšího odhadu. Vrací
+ * počet zapsaných klíčů.
+ */
+int ht_sketch_top_k(const ht_sketch_t *sketch, ht_sketch_entry_t *out,
+                    int max) {
+  int n = sketch->heap_size;
+  if (n == 0 || max <= 0) {
+    return 0;
+  }
+
+  //sort a copy, the heap order has to stay
+  ht_sketch_entry_t *sorted = malloc(n * sizeof(ht_sketch_entry_t));
+  if (sorted == NULL) {
+    return 0;
+  }
+  memcpy(sorted, sketch->heap, n * sizeof(ht_sketch_entry_t));
+  qsort(sorted, n, sizeof(ht_sketch_entry_t), ht_sketch_compare);
+  n = n < max ? n : max;
+  memcpy(out, sorted, n * sizeof(ht_sketch_entry_t));
+  free(sorted);
+  return n;
+}
+
+/*
+ * Přičtení sketche other, třeba z jiného vlákna, které už do něj nepíše.
+ *
+ * Oba sketche musí mít stejnou šířku a klíč (viz ht_sketch_init_like).
+ * Halda se sestaví znovu z klíčů obou hald s odhady ze spojeného sketche.
+ * Vrací false a sketch nezmění, pokud se sketche nedají spojit nebo se
+ * nepodaří alokovat paměť.
+ */
+bool ht_sketch_merge(ht_sketch_t *sketch, const ht_sketch_t *other) {
+  if (sketch->width != other->width || sketch->seed[0] != other->seed[0] ||
+      sketch->seed[1] != other->seed[1]) {
+    return false;
+  }
+  int candidates_count = sketch->heap_size + other->heap_size;
+  ht_sketch_entry_t *candidates =
+      malloc((candidates_count > 0 ? candidates_count : 1) *
+             sizeof(ht_sketch_entry_t));
+  if (candidates == NULL) {
+    return false;
+  }
+  memcpy(candidates, sketch->heap,
+         sketch->heap_size * sizeof(ht_sketch_entry_t));
+  memcpy(candidates + sketch->heap_size, other->heap,
+         other->heap_size * sizeof(ht_sketch_entry_t));
+
+  //saturating sums of the counters
+  size_t cells = (size_t)sketch->width * HT_SKETCH_DEPTH;
+  for (size_t i = 0; i < cells; i++) {
+    uint32_t a = sketch->counters[i], b = other->counters[i];
+    sketch->counters[i] = a > UINT32_MAX - b ? UINT32_MAX : a + b;
+  }
+  sketch->total += other->total;
+
+  //keys in both heaps are found by ht_sketch_track and kept once
+  sketch->heap_size = 0;
+  for (int i = 0; i < candidates_count; i++) {
+    ht_sketch_entry_t *entry = &candidates[i];
+    ht_sketch_track(sketch, entry->key, strlen(entry->key), entry->hash,
+                    ht_sketch_min(sketch, entry->hash));
+  }
+  free(candidates);
+  return true;
+}
+
+/*
+ * Paměť sketche v bajtech, počítadla a halda.
+ */
+size_t ht_sketch_memory(const ht_sketch_t *sketch) {
+  return (size_t)sketch->width * HT_SKETCH_DEPTH * sizeof(uint32_t) +
+         (size_t)sketch->k * sizeof(ht_sketch_entry_t);
+}
+
+void ht_sketch_dispose(ht_sketch_t *sketch) {
+  free(sketch->counters);
+  free(sketch->heap);
+  sketch->counters = NULL;
+  sketch->heap = NULL;
+  sketch->width = 0;
+  sketch->heap_size = 0;
+  sketch->k = 0;
+  sketch->total = 0;
+}
@@ -0,0 +1,52 @@
+/*
+ * Hlavičkový súbor pre count-min sketch s najčastejšími kľúčmi.
+ *
+ * Sketch odhaduje počet výskytov kľúča v pamäti pevne danej pri
+ * inicializácii a kľúče si neukladá. Odhad nikdy nie je menší ako skutočný
+ * počet. Malá halda si pamätá k kľúčov s najväčším odhadom. Jeden sketch
+ * patrí jednému vláknu; vlákna majú každé svoj sketch s rovnakým kľúčom
+ * rozptylovacej funkcie a nakoniec sa spoja cez ht_sketch_merge.
+ */
+
+#ifndef IAL_HASHTABLE_SKETCH_H
+#define IAL_HASHTABLE_SKETCH_H
+
+#include "keyed.h"
+
+// Počet riadkov počítadiel, pravdepodobnosť väčšej chyby je e^-4, asi 2 %
+#define HT_SKETCH_DEPTH 4
+
+// Miesto pre kľúč v halde, dlhšie kľúče sa počítajú, ale do haldy nejdú
+#define HT_SKETCH_KEY_SIZE 32
+
+// Kľúč v halde najčastejších kľúčov
+typedef struct ht_sketch_entry {
+  char key[HT_SKETCH_KEY_SIZE]; // kópia kľúča ukončená nulou
+  uint64_t hash;                // SipHash kľúča
+  uint32_t count;               // odhad počtu výskytov
+} ht_sketch_entry_t;
+
+// Count-min sketch s haldou najčastejších kľúčov
+typedef struct ht_sketch {
+  uint32_t *counters;       // HT_SKETCH_DEPTH riadkov po width počítadiel
+  uint32_t width;           // počet počítadiel v riadku, mocnina dvoch
+  uint64_t seed[2];         // kľúč rozptylovacej funkcie
+  ht_sketch_entry_t *heap;  // min-halda podľa count
+  int heap_size;            // počet kľúčov v halde
+  int k;                    // kapacita haldy
+  uint64_t total;           // súčet všetkých prírastkov
+} ht_sketch_t;
+
+bool ht_sketch_init(ht_sketch_t *sketch, size_t bytes, int k,
+                    const uint64_t seed[2]);
+bool ht_sketch_init_like(ht_sketch_t *sketch, const ht_sketch_t *other);
+uint32_t ht_sketch_increment(ht_sketch_t *sketch, const char *key,
+                             uint32_t count);
+uint32_t ht_sketch_estimate(const ht_sketch_t *sketch, const char *key);
+int ht_sketch_top_k(const ht_sketch_t *sketch, ht_sketch_entry_t *out,
+                    int max);
+bool ht_sketch_merge(ht_sketch_t *sketch, const ht_sketch_t *other);
+size_t ht_sketch_memory(const ht_sketch_t *sketch);
+void ht_sketch_dispose(ht_sketch_t *sketch);
+
+#endif
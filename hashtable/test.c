@@ -1,11 +1,24 @@
+#include "compact.h"
 #include "hashtable.h"
+#include "keyed.h"
+#include "mvcc.h"
+#include "ops.h"
+#include "shared.h"
+#include "sketch.h"
 #include "test_util.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 #define INSERT_TEST_DATA(TABLE)                                                \
   ht_insert_many(TABLE, TEST_DATA, sizeof(TEST_DATA) / sizeof(TEST_DATA[0]));
 
+#define INSERT_KEYED_DATA(TABLE)                                               \
+  for (int i = 0; i < 15; i++) {                                               \
+    htk_insert(TABLE, TEST_DATA[i].key, TEST_DATA[i].value);                   \
+  }
+
 const ht_item_t TEST_DATA[15] = {
     {"Bitcoin", 53247.71}, {"Ethereum", 3208.67}, {"Binance Coin", 409.15},
     {"Cardano", 1.82},     {"Tether", 0.86},      {"XRP", 0.93},
@@ -32,6 +45,16 @@ void reset_color(){
   printf("\033[0m");
 }
 
+int chain_position(htk_table_t *table, char *key) {
+  int position = 0;
+  ht_item_t *item = htk_list(table, htk_index_n(table, key, strlen(key)));
+  while (item != NULL && strcmp(item->key, key) != 0) {
+    item = item->next;
+    position++;
+  }
+  return item != NULL ? position : -1;
+}
+
 void init_test() {
   printf("Hash Table - testing script\n");
   printf("---------------------------\n");
@@ -265,6 +288,606 @@ printf("------------------------------------\n");
 reset_color();
 ENDTEST
 
+TEST(test_search_seeded, "Search and delete items in a SipHash table")
+ht_init(test_table);
+htk_table_t *keyed = malloc(sizeof(htk_table_t));
+htk_init(keyed, NULL);
+INSERT_KEYED_DATA(keyed)
+htk_delete(keyed, "Terra");
+int found = 0;
+for (int i = 0; i < 15; i++) {
+  if (htk_search(keyed, TEST_DATA[i].key) != NULL) {
+    found++;
+  }
+}
+
+//the table holds no pointer into itself, so a moved copy still works
+htk_table_t *moved = malloc(sizeof(htk_table_t));
+*moved = *keyed;
+memset(keyed, 0, sizeof(htk_table_t));
+bool copied = htk_search(moved, "Bitcoin") != NULL;
+*keyed = *moved;
+free(moved);
+if (found == 14 && copied && htk_search(keyed, "Terra") == NULL &&
+    keyed->hash == HTK_HASH_SIPHASH &&
+    (keyed->seed[0] != 0 || keyed->seed[1] != 0)) {
+  green();
+  printf("\nAll 14 remaining items were found with a random seed! [TEST PASSED ✓]\n");
+  tests_passed++;
+} else {
+  red();
+  printf("\nOnly %d of 14 remaining items were found! [TEST FAILED ☓]\n", found);
+}
+htk_dispose(keyed);
+free(keyed);
+reset_color();
+ENDTEST
+
+TEST(test_pow2_table, "Search in a power-of-two sized table")
+ht_init(test_table);
+htk_table_t *keyed = malloc(sizeof(htk_table_t));
+htk_options_t opts = {HTK_HASH_SUM, {0, 0}, 10, HTK_SIZING_POW2};
+htk_init(keyed, &opts);
+INSERT_KEYED_DATA(keyed)
+int found = 0;
+for (int i = 0; i < 15; i++) {
+  if (htk_search(keyed, TEST_DATA[i].key) != NULL) {
+    found++;
+  }
+}
+if (found == 15 && keyed->size == 16) {
+  green();
+  printf("\nAll 15 items were found in a table of size 16! [TEST PASSED ✓]\n");
+  tests_passed++;
+} else {
+  red();
+  printf("\nFound %d of 15 items in a table of size %d! [TEST FAILED ☓]\n", found, keyed->size);
+}
+htk_dispose(keyed);
+free(keyed);
+reset_color();
+ENDTEST
+
+TEST(test_search_reorder, "Move found synonyms forward")
+ht_init(test_table);
+htk_table_t *keyed = malloc(sizeof(htk_table_t));
+htk_options_t opts = {HTK_HASH_SUM, {0, 0}, 0, HTK_SIZING_PRIME, HTK_REORDER_TRANSPOSE};
+htk_init(keyed, &opts);
+INSERT_KEYED_DATA(keyed)
+int dogecoin = chain_position(keyed, "Dogecoin");
+htk_search(keyed, "Dogecoin");
+bool transposed = dogecoin > 0 &&
+                  chain_position(keyed, "Dogecoin") == dogecoin - 1;
+keyed->reorder = HTK_REORDER_MOVE_TO_FRONT;
+int uniswap = chain_position(keyed, "Uniswap");
+htk_search(keyed, "Uniswap");
+bool moved = uniswap > 0 && chain_position(keyed, "Uniswap") == 0;
+if (transposed && moved) {
+  green();
+  printf("\nDogecoin moved one step and Uniswap to the front! [TEST PASSED ✓]\n");
+  tests_passed++;
+} else {
+  red();
+  printf("\nThe chain was NOT reordered correctly! [TEST FAILED ☓]\n");
+}
+htk_dispose(keyed);
+free(keyed);
+reset_color();
+ENDTEST
+
+TEST(test_compact_table, "Insert, update and delete in a compact table")
+ht_init(test_table);
+htc_table_t compact;
+htc_init(&compact, 4);
+for (int i = 0; i < 15; i++) {
+  htc_insert(&compact, TEST_DATA[i].key, TEST_DATA[i].value);
+}
+htc_insert(&compact, "Ethereum", 12.34);
+htc_delete(&compact, "Terra");
+int found = 0;
+for (int i = 0; i < 15; i++) {
+  float *value = htc_get(&compact, TEST_DATA[i].key);
+  if (value != NULL && (*value == TEST_DATA[i].value || *value == 12.34f)) {
+    found++;
+  }
+}
+if (found == 14 && compact.count == 14 && htc_get(&compact, "Terra") == NULL &&
+    sizeof(htc_item_t) == 12) {
+  green();
+  printf("\nAll 14 items were found in %u lists of 12 byte items! [TEST PASSED ✓]\n", compact.size);
+  tests_passed++;
+} else {
+  red();
+  printf("\nOnly %d of 14 items were found in the compact table! [TEST FAILED ☓]\n", found);
+}
+htc_dispose(&compact);
+reset_color();
+ENDTEST
+
+TEST(test_shared_table, "Read a shared memory table through a second mapping")
+ht_init(test_table);
+hts_table_t writer, reader;
+char name[64];
+snprintf(name, sizeof(name), "/ial_hashtable_test_%ld", (long)getpid());
+bool created = hts_create(&writer, name, 16, 32, 512);
+bool opened = created && hts_open(&reader, name, false);
+int found = 0;
+if (opened) {
+  for (int i = 0; i < 15; i++) {
+    hts_insert(&writer, TEST_DATA[i].key, TEST_DATA[i].value);
+  }
+  hts_delete(&writer, "Terra");
+  for (int i = 0; i < 15; i++) {
+    float value;
+    if (hts_get(&reader, TEST_DATA[i].key, &value) && value == TEST_DATA[i].value) {
+      found++;
+    }
+  }
+}
+if (found == 14 && hts_count(&reader) == 14 && !hts_insert(&reader, "Terra", 1) &&
+    reader.items != writer.items) {
+  green();
+  printf("\nAll 14 items were read through a read-only mapping! [TEST PASSED ✓]\n");
+  tests_passed++;
+} else {
+  red();
+  printf("\nOnly %d of 14 items were read through the second mapping! [TEST FAILED ☓]\n", found);
+}
+if (opened) {
+  hts_close(&reader);
+}
+if (created) {
+  hts_close(&writer);
+  hts_unlink(name);
+}
+reset_color();
+ENDTEST
+
+TEST(test_insert_bulk, "Bulk insert into partitions with two threads")
+ht_init(test_table);
+htk_table_t *bulk = malloc(sizeof(htk_table_t));
+htk_options_t opts = {HTK_HASH_SIPHASH, {1, 2}, 1 << 17, HTK_SIZING_POW2, HTK_REORDER_NONE};
+htk_init(bulk, &opts);
+char *keys[16];
+float values[16];
+for (int i = 0; i < 15; i++) {
+  keys[i] = TEST_DATA[i].key;
+  values[i] = TEST_DATA[i].value;
+}
+keys[15] = "Bitcoin";
+values[15] = 1;
+bool inserted = htk_insert_bulk(bulk, keys, values, 16, 2);
+int found = 0;
+for (int i = 1; i < 15; i++) {
+  float *value = htk_get(bulk, TEST_DATA[i].key);
+  found += value != NULL && *value == TEST_DATA[i].value;
+}
+float *bitcoin = htk_get(bulk, "Bitcoin");
+
+//a deleted item of the block is reused by the next insert
+htk_delete(bulk, "Terra");
+ht_item_t *freed = bulk->free_items;
+htk_insert(bulk, "Monero", 232.5);
+ht_item_t *monero = htk_search(bulk, "Monero");
+
+//a prime table splits lists without division, a malloc'ed item is kept
+htk_table_t *prime = malloc(sizeof(htk_table_t));
+opts.sizing = HTK_SIZING_PRIME;
+htk_init(prime, &opts);
+htk_insert(prime, "Monero", 232.5);
+inserted = htk_insert_bulk(prime, keys, values, 16, 2) && inserted;
+htk_delete(prime, "Monero");
+int prime_found = 0;
+for (int i = 0; i < 15; i++) {
+  prime_found += htk_search(prime, TEST_DATA[i].key) != NULL;
+}
+if (inserted && found == 14 && bitcoin != NULL && *bitcoin == 1 &&
+    freed != NULL && monero == freed && htk_search(bulk, "Terra") == NULL &&
+    prime_found == 15 && prime->free_items != NULL) {
+  green();
+  printf("\nAll 15 keys were bulk inserted and Bitcoin was updated! [TEST PASSED ✓]\n");
+  tests_passed++;
+} else {
+  red();
+  printf("\nOnly %d of 14 keys were bulk inserted! [TEST FAILED ☓]\n", found);
+}
+htk_dispose(prime);
+free(prime);
+htk_dispose(bulk);
+free(bulk);
+reset_color();
+ENDTEST
+
+TEST(test_hash_batch, "Batch hashing matches SipHash on every instruction set")
+ht_init(test_table);
+htk_table_t *batch = malloc(sizeof(htk_table_t));
+htk_options_t opts = {HTK_HASH_SIPHASH, {5, 6}, 16, HTK_SIZING_POW2, HTK_REORDER_NONE};
+htk_init(batch, &opts);
+INSERT_KEYED_DATA(batch)
+char *keys[17];
+for (int i = 0; i < 15; i++) {
+  keys[i] = TEST_DATA[i].key;
+}
+keys[15] = "";
+keys[16] = "a key longer than two blocks";
+int matching = 0;
+for (htk_simd_t simd = HTK_SIMD_SCALAR; simd <= HTK_SIMD_AUTO; simd++) {
+  uint64_t hashes[17];
+  HTK_SIMD = simd;
+  htk_hash_batch(batch, keys, 17, hashes);
+  for (int i = 0; i < 17; i++) {
+    matching += hashes[i] == htk_siphash(batch->seed, keys[i], strlen(keys[i]));
+  }
+}
+HTK_SIMD = HTK_SIMD_AUTO;
+float *values[17];
+htk_get_batch(batch, keys, 17, values);
+int found = 0;
+for (int i = 0; i < 15; i++) {
+  found += values[i] != NULL && *values[i] == TEST_DATA[i].value;
+}
+if (matching == 4 * 17 && found == 15 && values[15] == NULL && values[16] == NULL) {
+  green();
+  printf("\nAll hashes matched and all 15 values were found in one batch! [TEST PASSED ✓]\n");
+  tests_passed++;
+} else {
+  red();
+  printf("\n%d of 68 hashes matched, %d of 15 values found! [TEST FAILED ☓]\n", matching, found);
+}
+htk_dispose(batch);
+free(batch);
+reset_color();
+ENDTEST
+
+TEST(test_iter_resize, "Resume a cursor after the table grows and shrinks")
+ht_init(test_table);
+htk_table_t *scan = malloc(sizeof(htk_table_t));
+htk_options_t opts = {HTK_HASH_SIPHASH, {7, 8}, 4, HTK_SIZING_POW2, HTK_REORDER_NONE};
+htk_init(scan, &opts);
+INSERT_KEYED_DATA(scan)
+int seen[15] = {0};
+htk_iter_t iter;
+ht_item_t *item;
+
+//about five items, grow, five more, shrink, the rest
+int sizes[] = {256, 2};
+uint64_t cursor = 0;
+bool resized = true;
+for (int slice = 0; slice < 3; slice++) {
+  htk_iter_begin(&iter, scan, cursor);
+  for (int taken = 0; (slice == 2 || taken < 5 || !htk_iter_at_list_end(&iter)) &&
+                      (item = htk_iter_next(&iter)) != NULL;
+       taken++) {
+    for (int i = 0; i < 15; i++) {
+      seen[i] += strcmp(item->key, TEST_DATA[i].key) == 0;
+    }
+  }
+  cursor = htk_iter_cursor(&iter);
+  if (slice < 2) {
+    resized = resized && htk_resize(scan, sizes[slice]);
+  }
+}
+int missing = 0;
+for (int i = 0; i < 15; i++) {
+  missing += seen[i] == 0;
+}
+
+//a whole prime table, nothing twice
+int count = 0;
+htk_table_t *prime = malloc(sizeof(htk_table_t));
+htk_init(prime, NULL);
+INSERT_KEYED_DATA(prime)
+htk_iter_begin(&iter, prime, 0);
+while (htk_iter_next(&iter) != NULL) {
+  count++;
+}
+if (resized && missing == 0 && cursor == HTK_ITER_END && scan->size == 2 &&
+    count == 15 && htk_iter_cursor(&iter) == HTK_ITER_END) {
+  green();
+  printf("\nAll 15 items were seen across a grow and a shrink! [TEST PASSED ✓]\n");
+  tests_passed++;
+} else {
+  red();
+  printf("\n%d items were missed by the cursor! [TEST FAILED ☓]\n", missing);
+}
+htk_dispose(prime);
+free(prime);
+htk_dispose(scan);
+free(scan);
+reset_color();
+ENDTEST
+
+TEST(test_mvcc_snapshot, "Read an old snapshot while the table changes")
+ht_init(test_table);
+htv_table_t versioned;
+htv_init(&versioned, 4);
+for (int i = 0; i < 15; i++) {
+  htv_insert(&versioned, TEST_DATA[i].key, TEST_DATA[i].value);
+}
+htv_snapshot_t before, after;
+bool taken = htv_snapshot_take(&versioned, &before);
+htv_insert(&versioned, "Bitcoin", 1);
+htv_delete(&versioned, "Terra");
+htv_insert(&versioned, "Monero", 167.81);
+taken = htv_snapshot_take(&versioned, &after) && taken;
+
+//nothing is freed while the old snapshot is open
+size_t kept = htv_collect(&versioned);
+int found = 0;
+for (int i = 0; i < 15; i++) {
+  float value;
+  found += htv_snapshot_get(&before, TEST_DATA[i].key, &value) && value == TEST_DATA[i].value;
+}
+float bitcoin = 0, monero = 0;
+bool changed = htv_snapshot_get(&after, "Bitcoin", &bitcoin) && bitcoin == 1 &&
+               !htv_snapshot_get(&before, "Monero", &monero) &&
+               htv_snapshot_get(&after, "Monero", &monero) &&
+               !htv_snapshot_get(&after, "Terra", &monero);
+int listed = 0;
+htv_iter_t iter;
+htv_iter_begin(&iter, &after);
+while (htv_iter_next(&iter) != NULL) {
+  listed++;
+}
+htv_snapshot_release(&before);
+htv_snapshot_release(&after);
+size_t freed = htv_collect(&versioned);
+if (taken && kept == 0 && found == 15 && changed && listed == 15 && freed == 2 &&
+    versioned.versions == 15 && versioned.count == 15) {
+  green();
+  printf("\nThe old snapshot kept all 15 items until it was released! [TEST PASSED ✓]\n");
+  tests_passed++;
+} else {
+  red();
+  printf("\nOnly %d of 15 items were kept for the old snapshot! [TEST FAILED ☓]\n", found);
+}
+htv_dispose(&versioned);
+reset_color();
+ENDTEST
+
+TEST(test_hash_tune, "Pick a hash function for numeric string keys")
+ht_init(test_table);
+static char numbers[HTK_TUNE_SAMPLE][8];
+char *keys[HTK_TUNE_SAMPLE];
+for (int i = 0; i < HTK_TUNE_SAMPLE; i++) {
+  snprintf(numbers[i], sizeof(numbers[i]), "%06d", i * 7);
+  keys[i] = numbers[i];
+}
+
+//automatic choice after the sample is inserted
+htk_table_t *tuned = malloc(sizeof(htk_table_t));
+htk_options_t opts = {HTK_HASH_AUTO, {0, 0}, HTK_TUNE_SAMPLE, HTK_SIZING_POW2, HTK_REORDER_NONE,
+                     HTK_PAGES_NORMAL, true};
+htk_init(tuned, &opts);
+for (int i = 0; i < HTK_TUNE_SAMPLE; i++) {
+  htk_insert(tuned, keys[i], i);
+}
+int found = 0;
+for (int i = 0; i < HTK_TUNE_SAMPLE; i++) {
+  float *value = htk_get(tuned, keys[i]);
+  found += value != NULL && *value == i;
+}
+htk_stats_t stats;
+htk_stats(tuned, &stats);
+
+//without allow_unkeyed the automatic choice keeps SipHash
+htk_table_t *keyed = malloc(sizeof(htk_table_t));
+opts.allow_unkeyed = false;
+htk_init(keyed, &opts);
+for (int i = 0; i < HTK_TUNE_SAMPLE; i++) {
+  htk_insert(keyed, keys[i], i);
+}
+htk_tune(keyed, keys, HTK_TUNE_SAMPLE);
+htk_stats_t keyed_stats;
+htk_stats(keyed, &keyed_stats);
+
+//sums of digits collide, so the plain sum must lose
+htk_table_t *sum = malloc(sizeof(htk_table_t));
+htk_options_t sum_opts = {HTK_HASH_SUM, {0, 0}, 0, HTK_SIZING_PRIME};
+htk_init(sum, &sum_opts);
+INSERT_KEYED_DATA(sum)
+htk_tune(sum, keys, HTK_TUNE_SAMPLE);
+htk_stats_t sum_stats;
+htk_stats(sum, &sum_stats);
+if (found == HTK_TUNE_SAMPLE && stats.count == HTK_TUNE_SAMPLE &&
+    stats.tuning.sample == HTK_TUNE_SAMPLE && stats.hash != HTK_HASH_SUM &&
+    stats.hash != HTK_HASH_AUTO && tuned->tune_left == 0 &&
+    sum_stats.hash != HTK_HASH_SUM && sum_stats.count == 15 &&
+    keyed_stats.hash == HTK_HASH_SIPHASH && keyed->tune_left == 0 &&
+    htk_get(sum, "Bitcoin") != NULL &&
+    stats.tuning.chain_ratio[HTK_HASH_SUM] > 2 * stats.tuning.chain_ratio[stats.hash]) {
+  green();
+  printf("\nThe sum lost with chain ratio %.1f against %.1f! [TEST PASSED ✓]\n",
+         stats.tuning.chain_ratio[HTK_HASH_SUM], stats.tuning.chain_ratio[stats.hash]);
+  tests_passed++;
+} else {
+  red();
+  printf("\nOnly %d of %d keys were found after tuning! [TEST FAILED ☓]\n", found, HTK_TUNE_SAMPLE);
+}
+htk_dispose(sum);
+free(sum);
+htk_dispose(keyed);
+free(keyed);
+htk_dispose(tuned);
+free(tuned);
+reset_color();
+ENDTEST
+
+TEST(test_hash_tune_keyed, "Keep SipHash when an unkeyed function wins")
+ht_init(test_table);
+static char letters[97][2];
+char *keys[97];
+for (int i = 0; i < 97; i++) {
+  letters[i][0] = (char)(' ' + i);
+  letters[i][1] = '\0';
+  keys[i] = letters[i];
+}
+
+//sums of single characters never collide, SipHash chains do
+htk_table_t *table = malloc(sizeof(htk_table_t));
+htk_options_t opts = {HTK_HASH_SIPHASH, {9, 10}, 97, HTK_SIZING_PRIME};
+htk_init(table, &opts);
+for (int i = 0; i < 97; i++) {
+  htk_insert(table, keys[i], i);
+}
+htk_hash_mode_t chosen = htk_tune(table, keys, 97);
+ht_item_t *items[97];
+htk_search_batch(table, keys, 97, items);
+int found = 0;
+for (int i = 0; i < 97; i++) {
+  found += items[i] != NULL && items[i] == htk_search(table, keys[i]) &&
+           items[i]->value == i;
+}
+if (chosen == HTK_HASH_SIPHASH && table->hash == HTK_HASH_SIPHASH && found == 97 &&
+    table->tuning.chain_ratio[HTK_HASH_SUM] < table->tuning.chain_ratio[HTK_HASH_SIPHASH]) {
+  green();
+  printf("\nSipHash was kept against chain ratio %.1f of the sum! [TEST PASSED ✓]\n",
+         table->tuning.chain_ratio[HTK_HASH_SUM]);
+  tests_passed++;
+} else {
+  red();
+  printf("\nOnly %d of 97 keys were found after tuning! [TEST FAILED ☓]\n", found);
+}
+htk_dispose(table);
+free(table);
+reset_color();
+ENDTEST
+
+TEST(test_huge_pages, "Keep buckets and items on huge pages")
+ht_init(test_table);
+htk_table_t *huge = malloc(sizeof(htk_table_t));
+htk_options_t opts = {HTK_HASH_SIPHASH, {3, 4}, 1 << 17, HTK_SIZING_POW2, HTK_REORDER_NONE,
+                     HTK_PAGES_EXPLICIT};
+htk_init(huge, &opts);
+INSERT_KEYED_DATA(huge)
+htk_delete(huge, "Terra");
+htk_delete(huge, "Bitcoin");
+htk_insert(huge, "Bitcoin", 1);
+htk_resize(huge, 1 << 18);
+int found = 0;
+for (int i = 1; i < 15; i++) {
+  float *value = htk_get(huge, TEST_DATA[i].key);
+  found += value != NULL && *value == TEST_DATA[i].value;
+}
+float *bitcoin = htk_get(huge, "Bitcoin");
+
+//without reserved pages MAP_HUGETLB fails and madvise is used instead
+if (found == 13 && bitcoin != NULL && *bitcoin == 1 && htk_get(huge, "Terra") == NULL &&
+    huge->items_pages != HTK_PAGES_NORMAL && huge->size == 1 << 18) {
+  green();
+  printf("\nAll 14 items were found with %s huge pages! [TEST PASSED ✓]\n",
+         huge->items_pages == HTK_PAGES_EXPLICIT ? "explicit" : "transparent");
+  tests_passed++;
+} else {
+  red();
+  printf("\nOnly %d of 13 items were found on huge pages! [TEST FAILED ☓]\n", found);
+}
+htk_dispose(huge);
+free(huge);
+reset_color();
+ENDTEST
+
+TEST(test_sketch_top_k, "Count keys approximately in two merged sketches")
+ht_init(test_table);
+ht_sketch_t sketch, other;
+bool created = ht_sketch_init(&sketch, 16 * 1024, 3, NULL) &&
+               ht_sketch_init_like(&other, &sketch);
+
+//key i is seen i + 1 times, split between the two sketches
+for (int i = 0; created && i < 15; i++) {
+  ht_sketch_increment(&sketch, TEST_DATA[i].key, i / 2 + 1);
+  ht_sketch_increment(i % 2 ? &sketch : &other, TEST_DATA[i].key, i - i / 2);
+}
+bool merged = created && ht_sketch_merge(&sketch, &other);
+int exact = 0;
+for (int i = 0; merged && i < 15; i++) {
+  exact += ht_sketch_estimate(&sketch, TEST_DATA[i].key) == (uint32_t)i + 1;
+}
+ht_sketch_entry_t top[3];
+int n = merged ? ht_sketch_top_k(&sketch, top, 3) : 0;
+if (merged && exact == 15 && sketch.total == 120 && n == 3 &&
+    strcmp(top[0].key, TEST_DATA[14].key) == 0 && top[0].count == 15 &&
+    strcmp(top[2].key, TEST_DATA[12].key) == 0 &&
+    ht_sketch_memory(&sketch) <= 16 * 1024) {
+  green();
+  printf("\nAll 15 counts were exact and %s led the top 3! [TEST PASSED ✓]\n", top[0].key);
+  tests_passed++;
+} else {
+  red();
+  printf("\nOnly %d of 15 counts were exact after the merge! [TEST FAILED ☓]\n", exact);
+}
+if (created) {
+  ht_sketch_dispose(&sketch);
+  ht_sketch_dispose(&other);
+}
+reset_color();
+ENDTEST
+
+int test_data_source(void *context, ht_batch_t *batch) {
+  int *position = context;
+  batch->count = 0;
+  while (*position < 15 && batch->count < HT_BATCH_SIZE) {
+    batch->keys[batch->count] = TEST_DATA[*position].key;
+    batch->values[batch->count] = TEST_DATA[*position].value;
+    batch->count++;
+    (*position)++;
+  }
+  return batch->count;
+}
+
+void test_emit(void *context, const ht_matches_t *matches) {
+  float *sum = context;
+  for (int i = 0; i < matches->count; i++) {
+    *sum += matches->build_values[i] * matches->probe_values[i];
+  }
+}
+
+TEST(test_join_group, "Join and group CSV rows against the table data")
+ht_init(test_table);
+FILE *file = tmpfile();
+if (file != NULL) {
+  fputs("coin,amount\nBitcoin,2\nNope,1\nTerra,10\nBitcoin,1\n", file);
+  rewind(file);
+}
+
+//tiny cache budget, so the build side is partitioned
+ht_join_t join;
+ht_join_init(&join, 64);
+int position = 0;
+bool built = ht_build_from_stream(&join, test_data_source, &position);
+ht_csv_t csv;
+ht_csv_open(&csv, file, 0, 1);
+float joined = 0;
+size_t matches = file ? ht_probe_stream(&join, ht_csv_next, &csv, test_emit, &joined) : 0;
+
+//group the same rows by coin
+ht_group_t group;
+ht_group_init(&group, 4);
+if (file != NULL) {
+  rewind(file);
+  ht_group_by_stream(&group, ht_csv_next, &csv);
+}
+float *bitcoin = htk_get(&group.table, "Bitcoin");
+float expected = 53247.71f * 2 + 30.67f * 10 + 53247.71f * 1;
+if (built && join.partitions > 1 && matches == 3 && joined > expected - 0.1f &&
+    joined < expected + 0.1f && bitcoin != NULL && *bitcoin == 3) {
+  green();
+  printf("\nFound 3 matches in %d partitions and summed Bitcoin to 3! [TEST PASSED ✓]\n", join.partitions);
+  tests_passed++;
+} else {
+  red();
+  printf("\nFound %zu matches in %d partitions! [TEST FAILED ☓]\n", matches, join.partitions);
+}
+ht_csv_close(&csv);
+ht_group_dispose(&group);
+ht_join_dispose(&join);
+if (file != NULL) {
+  fclose(file);
+}
+reset_color();
+ENDTEST
+
+
 
 
 
@@ -282,10 +905,24 @@ int main(int argc, char *argv[]) {
   test_get();
   test_delete();
   test_delete_all();
+  test_search_seeded();
+  test_pow2_table();
+  test_search_reorder();
+  test_compact_table();
+  test_shared_table();
+  test_join_group();
+  test_insert_bulk();
+  test_hash_batch();
+  test_iter_resize();
+  test_mvcc_snapshot();
+  test_hash_tune();
+  test_hash_tune_keyed();
+  test_huge_pages();
+  test_sketch_top_k();
 
   free(uninitialized_item);
 
-  tests_failed = 6 - tests_passed;
+  tests_failed = 20 - tests_passed;
   printf("\n");
   printf("---------- TESTS SUMMARY ----------\n");
   printf("|                                 |\n");
@@ -0,0 +1,104 @@
+#include "hashtable.hpp"
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+static void check(bool passed, const char *name) {
+  if (passed) {
+    printf("\033[1;32m[%s] [TEST PASSED ✓]\033[0m\n", name);
+    tests_passed++;
+  } else {
+    printf("\033[1;31m[%s] [TEST FAILED ☓]\033[0m\n", name);
+    tests_failed++;
+  }
+}
+
+int main() {
+  printf("Hash Table C++ wrapper - testing script\n");
+  printf("---------------------------------------\n\n");
+
+  //keys are slices of one buffer, no NUL after them
+  const std::string coins = "BitcoinEthereumSolanaTerra";
+  std::string_view all(coins);
+  std::string_view bitcoin = all.substr(0, 7), ethereum = all.substr(7, 8),
+                   solana = all.substr(15, 6), terra = all.substr(21, 5);
+
+  ial::HashTable<float> prices(16);
+  prices.insert_or_assign(bitcoin, 53247.71f);
+  prices.insert_or_assign(ethereum, 3208.67f);
+  prices.insert_or_assign(solana, 134.50f);
+  bool updated = !prices.insert_or_assign(solana, 140.0f);
+  float value = 0;
+  check(prices.size() == 3 && updated && prices.get("Solana", value) &&
+            value == 140.0f && !prices.contains(terra) &&
+            !prices.contains(all.substr(0, 6)),
+        "insert and string_view lookup");
+
+  int visited = 0;
+  float sum = 0;
+  for (const auto &[key, price] : prices) {
+    visited++;
+    sum += key == "Bitcoin" ? price : 0;
+  }
+  auto found = prices.find(ethereum);
+  int after = 0;
+  for (auto it = found; it != prices.end(); ++it) {
+    after++;
+  }
+  check(visited == 3 && sum == 53247.71f && found->first == "Ethereum" &&
+            found.value() == 3208.67f && after >= 1 && after <= 3,
+        "iterators");
+
+  ial::HashTable<float> moved = std::move(prices);
+  check(moved.size() == 3 && moved.contains(bitcoin) && prices.size() == 0 &&
+            !prices.contains(bitcoin) && prices.begin() == prices.end(),
+        "move");
+
+  bool thrown = false;
+  try {
+    moved.insert_or_assign(std::string_view("Bit\0coin", 8), 1.0f);
+  } catch (const std::invalid_argument &) {
+    thrown = true;
+  }
+  check(moved.erase(solana) == 1 && moved.erase(solana) == 0 &&
+            moved.size() == 2 && thrown,
+        "erase and NUL in key");
+
+  ial::HashTable<int> counts(4, HTK_HASH_SUM);
+  for (int i = 0; i < 100; i++) {
+    counts.insert_or_assign(std::to_string(i % 10), i);
+  }
+  int nine = 0;
+  check(counts.size() == 10 && counts.get("9", nine) && nine == 99,
+        "int values in a sum-hash table");
+
+  //const lookups must not move items in a self-organizing table
+  htk_options_t opts = {HTK_HASH_SUM, {0, 0}, 1, HTK_SIZING_POW2,
+                        HTK_REORDER_MOVE_TO_FRONT};
+  ial::HashTable<int> ordered(opts);
+  for (int i = 0; i < 5; i++) {
+    ordered.insert_or_assign(std::to_string(i), i);
+  }
+  const auto &view = ordered;
+  std::string before, after_lookups;
+  for (const auto &[key, number] : view) {
+    before += key;
+  }
+  bool all_found = view.contains("0") && view.find("1") != view.end();
+  for (const auto &[key, number] : view) {
+    after_lookups += key;
+  }
+  using category = ial::HashTable<int>::const_iterator::iterator_category;
+  check(all_found && before == after_lookups &&
+            std::is_same_v<category, std::input_iterator_tag>,
+        "const lookups keep the order");
+
+  printf("\nTESTS PASSED: %d, TESTS FAILED: %d\n", tests_passed, tests_failed);
+  return tests_failed == 0 ? 0 : 1;
+}